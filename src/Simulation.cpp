@@ -0,0 +1,676 @@
+#include "Simulation.h"
+#include "GameOfLife.h"
+#include "FrameRecorder.h"
+#include "BackgroundIO.h"
+#include "SessionLog.h"
+#include <SDL.h>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <condition_variable>
+
+const double PUBLISH_INTERVAL = 4.0; // Minimum milliseconds between published snapshots
+const size_t COMMAND_QUEUE_SIZE = 4096;
+const double TURBO_FRAME_PERIOD = 1000.0 / 60.0; // Milliseconds per published frame in max speed mode
+const double RATE_WINDOW = 500.0; // Milliseconds over which the achieved rate is measured
+const double PLACEMENT_INTERVAL = 1000.0; // Milliseconds between looks at where the board's memory is
+const double COUNTER_INTERVAL = 1000.0; // Milliseconds of steps summed into each published counter reading
+const double MAX_CATCH_UP = 0.25; // Seconds of missed generations replayed before the backlog is dropped
+const double STEP_SLICE = 8.0; // Milliseconds of stepping between command and snapshot checks
+const double STATS_INTERVAL = 250.0; // Milliseconds between snapshots that only refresh the counters
+const double IDLE_WAIT = 1000.0; // Longest sleep while nothing is due, in milliseconds
+const char* SNAPSHOT_PATH = "grid.golsnap";
+
+std::thread simulationThread;
+std::atomic<bool> simulationRunning{false};
+SpscQueue<SimCommand, COMMAND_QUEUE_SIZE> commandQueue;
+TripleBuffer snapshots;
+void (*publishCallback)() = nullptr;
+
+// Wakes the simulation thread early when a command arrives or it is stopped
+std::mutex wakeMutex;
+std::condition_variable wakeCondition;
+
+// State owned by the simulation thread
+bool simPaused = false;
+double simTargetRate = 10.0; // Generations per second
+bool simMaxSpeed = false;
+double simFrameBudget = 14.0; // Milliseconds of stepping per frame in max speed mode
+double stepCostEstimate = 0.01; // Running average of milliseconds per generation
+int generationsSincePublish = 0;
+uint64_t droppedGenerations = 0; // Backlog discarded by the catch-up bound
+uint64_t generation = 0;
+CheckpointSettings checkpointSettings;
+uint64_t lastCheckpointGeneration = 0;
+Uint64 lastCheckpointTime = 0;
+
+// Achieved rate, measured between step completions at least RATE_WINDOW apart
+Uint64 rateWindowStart = 0;
+uint64_t rateWindowGeneration = 0;
+double generationsPerSecond = 0.0;
+
+// Memory placement of the board, looked up now and then since it reads /proc
+GridPlacement placement;
+Uint64 placementTime = 0;
+
+// Hardware counters of the simulation thread and its step workers, read around every step
+// while measuring is on
+PerfCounters stepCounters;
+bool measuringSteps = false;
+PerfReading shownCounters;
+Uint64 counterTime = 0;
+
+// Tiles changed since each snapshot buffer was last published. The buffers take turns, so
+// each keeps its own list, and a bit per buffer in tileListed keeps repeats out of the lists.
+// A list past an eighth of the tiles gives way to copying the whole board.
+struct BufferChanges {
+    std::vector<uint32_t> tiles;
+    bool whole = true;
+    bool channelStale = true; // The board changed since the buffer's channel was sampled
+};
+BufferChanges bufferChanges[TripleBuffer::BUFFER_COUNT];
+std::vector<uint8_t> tileListed;
+
+// What the renderer shows, so the channels are sampled only there
+SimViewport viewport;
+
+double elapsedMs(Uint64 from, Uint64 to) {
+    return static_cast<double>(to - from) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+void updateMeasuredRate() {
+    Uint64 now = SDL_GetPerformanceCounter();
+    double elapsed = elapsedMs(rateWindowStart, now);
+    if (elapsed >= RATE_WINDOW) {
+        generationsPerSecond = (generation - rateWindowGeneration) * 1000.0 / elapsed;
+        rateWindowStart = now;
+        rateWindowGeneration = generation;
+    }
+}
+
+size_t getTileCount() {
+    const PopulationPyramid& pyramid = getPyramid();
+    return pyramid.getLevelCount() == 0 ? 0 : static_cast<size_t>(pyramid.getTilesPerRow()) * pyramid.getLevelHeight(0);
+}
+
+// Loads, clears and resets: every buffer takes a copy of the whole board
+void noteBoardReplaced() {
+    for (BufferChanges& changes : bufferChanges) {
+        changes.tiles.clear();
+        changes.whole = true;
+        changes.channelStale = true;
+    }
+    tileListed.assign(getTileCount(), 0);
+}
+
+void noteTilesChanged(const std::vector<uint32_t>& tiles) {
+    if (tileListed.size() != getTileCount()) {
+        noteBoardReplaced();
+        return;
+    }
+    for (int buffer = 0; buffer < TripleBuffer::BUFFER_COUNT; ++buffer) {
+        BufferChanges& changes = bufferChanges[buffer];
+        changes.channelStale = true;
+        if (changes.whole) {
+            continue;
+        }
+        for (uint32_t tile : tiles) {
+            if ((tileListed[tile] & (1 << buffer)) == 0) {
+                tileListed[tile] |= 1 << buffer;
+                changes.tiles.push_back(tile);
+            }
+        }
+        if (changes.tiles.size() > tileListed.size() / 8) {
+            changes.whole = true; // Its bits in tileListed are cleared by the copy
+        }
+    }
+}
+
+// An edit of the width x height rectangle at (x, y), which may reach past the board
+void noteRegionChanged(int x, int y, int width, int height) {
+    const int size = PopulationPyramid::TILE_SIZE;
+    int tx0 = std::max(x, 0) / size;
+    int ty0 = std::max(y, 0) / size;
+    int tx1 = (std::min(x + width, getGridWidth()) + size - 1) / size;
+    int ty1 = (std::min(y + height, getGridHeight()) + size - 1) / size;
+    if (tx0 >= tx1 || ty0 >= ty1) {
+        return;
+    }
+    std::vector<uint32_t> tiles;
+    if (static_cast<size_t>(tx1 - tx0) * (ty1 - ty0) > getTileCount() / 8) {
+        for (BufferChanges& changes : bufferChanges) {
+            changes.whole = true;
+            changes.channelStale = true;
+        }
+        return;
+    }
+    const int tilesPerRow = getPyramid().getTilesPerRow();
+    for (int ty = ty0; ty < ty1; ++ty) {
+        for (int tx = tx0; tx < tx1; ++tx) {
+            tiles.push_back(static_cast<uint32_t>(ty * tilesPerRow + tx));
+        }
+    }
+    noteTilesChanged(tiles);
+}
+
+// Bring the back buffer's board up to date: its changed tiles, or all of it
+void copyChangedTiles(GridSnapshot& snapshot, int buffer) {
+    BufferChanges& changes = bufferChanges[buffer];
+    const GridBuffer& grid = getGrid();
+    const int wordsPerRow = getWordsPerRow();
+    if (changes.whole || snapshot.cells.size() != grid.size()) {
+        snapshot.cells.assign(grid.begin(), grid.end());
+        snapshot.pyramid = getPyramid();
+        for (uint8_t& listed : tileListed) {
+            listed &= ~(1 << buffer);
+        }
+    } else if (!changes.tiles.empty()) {
+        const int tilesPerRow = getPyramid().getTilesPerRow();
+        const int height = getGridHeight();
+        for (uint32_t tile : changes.tiles) {
+            size_t word = (tile % tilesPerRow) >> 3; // Eight tiles to a word
+            int y0 = static_cast<int>(tile / tilesPerRow) * PopulationPyramid::TILE_SIZE;
+            for (int y = y0; y < std::min(y0 + PopulationPyramid::TILE_SIZE, height); ++y) {
+                snapshot.cells[static_cast<size_t>(y) * wordsPerRow + word] = grid[static_cast<size_t>(y) * wordsPerRow + word];
+            }
+            tileListed[tile] &= ~(1 << buffer);
+        }
+        snapshot.pyramid.updateTiles(snapshot.cells.data(), wordsPerRow, changes.tiles);
+    }
+    changes.tiles.clear();
+    changes.whole = false;
+}
+
+// The shown channel at the first cell of each viewport pixel, picked as renderGrid picks them
+void sampleChannel(GridSnapshot& snapshot) {
+    const std::vector<uint8_t>& plane = getAuxChannel(static_cast<AuxChannel>(viewport.channel));
+    const int width = getGridWidth();
+    const int height = getGridHeight();
+    const int wordsPerRow = getWordsPerRow();
+    std::vector<int> columns(viewport.columns);
+    for (int sx = 0; sx < viewport.columns; ++sx) {
+        columns[sx] = std::max(static_cast<int>(std::floor(viewport.x + sx / viewport.zoom)), 0);
+    }
+    snapshot.auxView.assign(static_cast<size_t>(viewport.columns) * viewport.rows, 0);
+    for (int sy = 0; sy < viewport.rows; ++sy) {
+        int y = std::max(static_cast<int>(std::floor(viewport.y + sy / viewport.zoom)), 0);
+        if (y >= height || plane.empty()) {
+            continue;
+        }
+        uint8_t* row = &snapshot.auxView[static_cast<size_t>(sy) * viewport.columns];
+        for (int sx = 0; sx < viewport.columns; ++sx) {
+            int x = columns[sx];
+            if (x < width) {
+                row[sx] = plane[(static_cast<size_t>(y) * wordsPerRow + (x >> 6)) * 64 + (x & 63)];
+            }
+        }
+    }
+    snapshot.auxViewport = viewport;
+}
+
+// Hand the current generation to the renderer in the back buffer. Only the tiles changed
+// since that buffer was last published are copied, and the channel only where it is shown.
+// A publish that only refreshes the counters (boardChanged false) samples the channel only
+// if this buffer's sample predates a change to the board or the view.
+void publishSnapshot(bool boardChanged) {
+    GridSnapshot& snapshot = snapshots.getBackBuffer();
+    const int buffer = snapshots.getBackIndex();
+    snapshot.width = getGridWidth();
+    snapshot.height = getGridHeight();
+    snapshot.wordsPerRow = getWordsPerRow();
+    copyChangedTiles(snapshot, buffer);
+    if (!getAuxChannelsEnabled() || viewport.channel < 0) {
+        snapshot.auxView.clear();
+    } else if (boardChanged || bufferChanges[buffer].channelStale || snapshot.auxView.empty() || snapshot.auxViewport != viewport) {
+        sampleChannel(snapshot);
+        bufferChanges[buffer].channelStale = false;
+    }
+    snapshot.generation = generation;
+    snapshot.population = snapshot.pyramid.getPopulation();
+    snapshot.generationsPerSecond = generationsPerSecond;
+    snapshot.generationsPerFrame = generationsSincePublish;
+    snapshot.droppedGenerations = droppedGenerations;
+    snapshot.stable = !gridChangedLastUpdate();
+    snapshot.rule = getRule();
+    snapshot.engine = getLastStepEngine();
+    snapshot.engineCosts = getEngineCosts();
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (placementTime == 0 || elapsedMs(placementTime, now) >= PLACEMENT_INTERVAL) {
+        placement = getGridPlacement();
+        placementTime = now;
+    }
+    snapshot.placement = placement;
+    if (measuringSteps && (counterTime == 0 || elapsedMs(counterTime, now) >= COUNTER_INTERVAL)) {
+        shownCounters = stepCounters.takeReading();
+        counterTime = now;
+    }
+    snapshot.stepCounters = shownCounters;
+    snapshot.counterError = stepCounters.getError();
+    generationsSincePublish = 0;
+    snapshots.publish();
+
+    if (publishCallback != nullptr) {
+        publishCallback();
+    }
+}
+
+// Sleep for up to the given time, returning early when a command is posted
+void waitForCommands(double milliseconds) {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wakeCondition.wait_for(lock, std::chrono::duration<double, std::milli>(milliseconds), [] {
+        return !commandQueue.isEmpty() || !simulationRunning.load(std::memory_order_relaxed) || hasLoadedBoard();
+    });
+}
+
+// Called by the I/O thread when a loaded board is ready
+void wakeSimulation() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+// Swap in boards parsed by the I/O thread. Returns true if the board changed.
+bool applyLoadedBoards() {
+    bool applied = false;
+    LoadedBoard loaded;
+    while (takeLoadedBoard(loaded)) {
+        // Snapshots restore their generation, a new board starts from 0 and a pattern placed
+        // into the running board keeps the count going
+        std::string error;
+        bool snapshot = loaded.type == IoJobType::LoadSnapshot || loaded.type == IoJobType::LoadCheckpoint;
+        bool placed = !snapshot && loaded.placeAt;
+        bool ok = snapshot ? replaceBoard(loaded.board, error)
+                  : placed ? placePatternAt(loaded.board, loaded.x, loaded.y, error)
+                           : placePattern(loaded.board, error);
+        uint64_t loadedAt = generation;
+        if (ok && !placed) {
+            generation = snapshot ? loaded.generation : 0;
+            lastCheckpointGeneration = generation;
+        }
+        if (ok) {
+            SessionEvent event;
+            event.type = loaded.type == IoJobType::LoadCheckpoint ? SessionEventType::LoadCheckpoint
+                         : loaded.type == IoJobType::LoadSnapshot ? SessionEventType::LoadSnapshot
+                         : placed                                  ? SessionEventType::Place
+                                                                   : SessionEventType::Load;
+            event.generation = loadedAt;
+            event.nextGeneration = generation;
+            event.x = loaded.x;
+            event.y = loaded.y;
+            event.path = loaded.path;
+            logSessionEvent(event);
+            reportIoResult("Loaded " + loaded.path + " (" + std::to_string(loaded.board.width) + "x" + std::to_string(loaded.board.height) + ")", false);
+            applied = true;
+        } else {
+            reportIoResult(error, true);
+        }
+    }
+    if (applied) {
+        noteBoardReplaced();
+    }
+    return applied;
+}
+
+// Every edit is also written to the session log, if one is being recorded
+void applyCommand(const SimCommand& command) {
+    SessionEvent event;
+    event.generation = generation;
+    switch (command.type) {
+        case SimCommandType::Paint:
+            paintCells(command.x, command.y, command.size, command.state);
+            noteRegionChanged(command.x, command.y, command.size, command.size);
+            event.type = SessionEventType::Paint;
+            event.x = command.x;
+            event.y = command.y;
+            event.size = command.size;
+            event.state = command.state;
+            logSessionEvent(event);
+            break;
+        case SimCommandType::Clear:
+            clearGrid();
+            noteBoardReplaced();
+            event.type = SessionEventType::Clear;
+            logSessionEvent(event);
+            break;
+        case SimCommandType::Reset:
+            event.type = SessionEventType::Reset;
+            event.seed = randomSeed();
+            initializeGrid(event.seed);
+            noteBoardReplaced();
+            logSessionEvent(event);
+            generation = 0;
+            break;
+        // Saves take a copy of the board and loads are parsed on the I/O thread, so
+        // stepping carries on while files are written or read
+        case SimCommandType::Save:
+            queueSave(IoJobType::SavePattern, command.path.empty() ? SAVE_PATH : command.path, copyBoard(), generation);
+            break;
+        case SimCommandType::Load: {
+            std::string path = command.path.empty() ? SAVE_PATH : command.path;
+            if (path == SAVE_PATH && !std::ifstream(SAVE_PATH)) {
+                if (!std::ifstream(LEGACY_SAVE_PATH)) {
+                    reportIoResult(std::string("No saved grid (") + SAVE_PATH + ")", true);
+                    break;
+                }
+                path = LEGACY_SAVE_PATH;
+            }
+            queueLoad(IoJobType::LoadPattern, path, command.state, command.x, command.y);
+            break;
+        }
+        case SimCommandType::SaveSnapshot:
+            queueSave(IoJobType::SaveSnapshot, SNAPSHOT_PATH, copyBoard(), generation);
+            break;
+        case SimCommandType::LoadSnapshot:
+            queueLoad(IoJobType::LoadSnapshot, SNAPSHOT_PATH);
+            break;
+        case SimCommandType::ExportImage:
+            queueExport(command.path, copyBoard(), generation, command.value);
+            break;
+        case SimCommandType::SetPaused:
+            simPaused = command.value != 0;
+            break;
+        case SimCommandType::SetTargetRate:
+            simTargetRate = command.rate;
+            rateWindowStart = SDL_GetPerformanceCounter();
+            rateWindowGeneration = generation;
+            break;
+        case SimCommandType::SetMaxSpeed:
+            simMaxSpeed = command.value != 0;
+            break;
+        case SimCommandType::SetFrameBudget:
+            simFrameBudget = command.value / 1000.0;
+            break;
+        case SimCommandType::SetAuxChannels:
+            setAuxChannelsEnabled(command.value != 0);
+            break;
+        case SimCommandType::SetCheckpoints:
+            checkpointSettings.everyGenerations = static_cast<uint64_t>(std::max(command.value, 0));
+            checkpointSettings.everySeconds = std::max(command.rate, 0.0);
+            lastCheckpointTime = SDL_GetPerformanceCounter();
+            break;
+        case SimCommandType::ResumeCheckpoint:
+            queueLoad(IoJobType::LoadCheckpoint, checkpointSettings.directory);
+            break;
+        case SimCommandType::StartSessionLog: {
+            std::string error;
+            if (startSessionLog(command.path, generation, error)) {
+                reportIoResult("Recording session to " + command.path, false);
+            } else {
+                reportIoResult(error, true);
+            }
+            break;
+        }
+        case SimCommandType::StopSessionLog:
+            if (isSessionLogging()) {
+                stopSessionLog(generation);
+                reportIoResult("Session recorded", false);
+            }
+            break;
+        case SimCommandType::EditRegion:
+            event.type = SessionEventType::Edit;
+            event.x = command.x;
+            event.y = command.y;
+            event.width = command.width;
+            event.height = command.height;
+            event.edit = command.value;
+            event.seed = command.value == EDIT_RANDOM ? randomSeed() : 0;
+            editRegion(command.x, command.y, command.width, command.height, static_cast<RegionEdit>(command.value), event.seed);
+            if (command.value == EDIT_ROTATE_CLOCKWISE || command.value == EDIT_ROTATE_COUNTERCLOCKWISE) {
+                // Turned on its top-left corner, so the edit reaches the square on the longer side
+                int side = std::max(command.width, command.height);
+                noteRegionChanged(command.x, command.y, side, side);
+            } else {
+                noteRegionChanged(command.x, command.y, command.width, command.height);
+            }
+            logSessionEvent(event);
+            break;
+        case SimCommandType::SetEngine:
+            setStepEngine(static_cast<StepEngine>(command.value));
+            break;
+        case SimCommandType::SetViewport:
+            viewport = command.viewport;
+            break;
+        case SimCommandType::SetCounters:
+            measuringSteps = command.value != 0;
+            stepCounters.takeReading();
+            shownCounters = PerfReading();
+            counterTime = SDL_GetPerformanceCounter();
+            break;
+        case SimCommandType::Paste:
+            if (command.pattern) {
+                pastePattern(*command.pattern, command.x, command.y, command.state);
+                noteRegionChanged(command.x, command.y, command.pattern->width, command.pattern->height);
+                if (isSessionLogging()) {
+                    event.type = SessionEventType::Paste;
+                    event.x = command.x;
+                    event.y = command.y;
+                    event.width = command.pattern->width;
+                    event.height = command.pattern->height;
+                    event.state = command.state;
+                    event.words = command.pattern->words;
+                    logSessionEvent(event);
+                }
+            }
+            break;
+    }
+}
+
+// Hand a copy of the board to the I/O thread once enough generations or seconds have passed
+// since the last checkpoint. While the previous one is still being written the checkpoint is
+// put off, so a slow disk costs checkpoints, never stepping time or memory.
+void checkpointIfDue() {
+    if (generation == lastCheckpointGeneration) {
+        return;
+    }
+    Uint64 now = SDL_GetPerformanceCounter();
+    bool due = (checkpointSettings.everyGenerations != 0 && generation - lastCheckpointGeneration >= checkpointSettings.everyGenerations) ||
+               (checkpointSettings.everySeconds > 0.0 && elapsedMs(lastCheckpointTime, now) >= checkpointSettings.everySeconds * 1000.0);
+    if (due && tryBeginCheckpoint()) {
+        queueCheckpoint(checkpointSettings, copyBoard(), generation);
+        lastCheckpointGeneration = generation;
+        lastCheckpointTime = now;
+    }
+}
+
+// Step a batch of generations and fold its cost into the running estimate.
+// Returns true if any generation of the batch changed the board.
+bool runBatch(int batch) {
+    bool changed = false;
+    Uint64 batchStart = SDL_GetPerformanceCounter();
+    for (int i = 0; i < batch; ++i) {
+        if (measuringSteps) {
+            stepCounters.start();
+            updateGrid();
+            stepCounters.stop(1);
+        } else {
+            updateGrid();
+        }
+        if (gridChangedLastUpdate()) {
+            noteTilesChanged(getUniverse().getChangedTiles());
+            changed = true;
+        }
+        recordGeneration(getGrid().data(), getWordsPerRow(), getGridWidth(), getGridHeight(), ++generation);
+    }
+    Uint64 batchEnd = SDL_GetPerformanceCounter();
+
+    generationsSincePublish += batch;
+    stepCostEstimate = std::max(0.8 * stepCostEstimate + 0.2 * elapsedMs(batchStart, batchEnd) / batch, 1e-6);
+    return changed;
+}
+
+// Step as many generations as fit in the frame budget. Batches are sized from the measured
+// cost per generation, so the clock is read a few times per frame rather than per step.
+void runMaxSpeedFrame(Uint64 frameStart) {
+    bool stepped = false;
+
+    while (true) {
+        double remaining = simFrameBudget - elapsedMs(frameStart, SDL_GetPerformanceCounter());
+        // Plan for half the remaining time so a cost spike cannot overrun the budget by much
+        int batch = static_cast<int>(remaining * 0.5 / stepCostEstimate);
+        if (batch < 1) {
+            if (stepped || remaining <= 0.0) {
+                break;
+            }
+            batch = 1; // Always make progress, even if one step exceeds the budget
+        }
+
+        runBatch(batch);
+        stepped = true;
+    }
+}
+
+// Fixed-timestep scheduler. Elapsed performance-counter time is accumulated as generations
+// owed at the target rate, so the long-run rate is exact and never drifts, whatever the
+// sleep granularity. A backlog larger than MAX_CATCH_UP seconds is dropped instead of
+// being replayed in one burst. Between generations the thread blocks until the next one is
+// due or a command arrives, and a board that stopped changing is only republished now and
+// then to refresh the counters, so a paused or settled simulation costs next to nothing.
+void simulationLoop() {
+    // Opened here so the counters follow this thread and the step workers it starts
+    stepCounters.open(true);
+    Uint64 lastTick = SDL_GetPerformanceCounter();
+    Uint64 lastPublishTime = 0;
+    double owed = 0.0; // Generations due but not yet stepped
+    bool dirty = true; // The grid changed since the last published snapshot
+    bool statsDirty = false; // Only the counters changed since the last published snapshot
+
+    while (simulationRunning.load(std::memory_order_relaxed)) {
+        SimCommand command;
+        while (commandQueue.pop(command)) {
+            applyCommand(command);
+            dirty = true;
+        }
+        if (applyLoadedBoards()) {
+            dirty = true;
+        }
+
+        // Max speed: one budgeted batch of generations per frame, publishing only the last one
+        if (simMaxSpeed && !simPaused) {
+            Uint64 frameStart = SDL_GetPerformanceCounter();
+            runMaxSpeedFrame(frameStart);
+            updateMeasuredRate();
+            checkpointIfDue();
+            publishSnapshot(true);
+            dirty = false;
+
+            double idle = TURBO_FRAME_PERIOD - elapsedMs(frameStart, SDL_GetPerformanceCounter());
+            if (idle > 0.0) {
+                waitForCommands(idle);
+            }
+            lastTick = SDL_GetPerformanceCounter();
+            owed = 0.0;
+            continue;
+        }
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (simPaused) {
+            owed = 0.0;
+            rateWindowStart = now;
+            rateWindowGeneration = generation;
+            if (generationsPerSecond != 0.0) {
+                generationsPerSecond = 0.0;
+                dirty = true;
+            }
+        } else {
+            owed += elapsedMs(lastTick, now) / 1000.0 * simTargetRate;
+
+            double maxBacklog = std::max(1.0, simTargetRate * MAX_CATCH_UP);
+            if (owed > maxBacklog) {
+                droppedGenerations += static_cast<uint64_t>(owed - maxBacklog);
+                owed = maxBacklog;
+            }
+
+            // Step what is owed in slices, so commands and snapshots are never starved
+            int batch = static_cast<int>(std::min(owed, std::max(1.0, STEP_SLICE / stepCostEstimate)));
+            if (batch > 0) {
+                if (runBatch(batch)) {
+                    dirty = true;
+                } else {
+                    statsDirty = true;
+                }
+                updateMeasuredRate();
+                checkpointIfDue();
+                owed -= batch;
+            }
+        }
+        lastTick = now;
+
+        // Publishing copies the changed tiles, so it is capped at a rate no display will outrun
+        Uint64 publishTime = SDL_GetPerformanceCounter();
+        double sincePublish = elapsedMs(lastPublishTime, publishTime);
+        if ((dirty && sincePublish >= PUBLISH_INTERVAL) || (statsDirty && sincePublish >= STATS_INTERVAL)) {
+            publishSnapshot(dirty);
+            lastPublishTime = publishTime;
+            sincePublish = 0.0;
+            dirty = false;
+            statsDirty = false;
+        }
+
+        // Block until the next generation or pending snapshot is due; commands wake us early
+        double wait = simPaused ? IDLE_WAIT : std::min(IDLE_WAIT, (1.0 - owed) * 1000.0 / simTargetRate);
+        if (dirty) {
+            wait = std::min(wait, PUBLISH_INTERVAL - sincePublish);
+        } else if (statsDirty) {
+            wait = std::min(wait, STATS_INTERVAL - sincePublish);
+        }
+        if (wait > 0.0) {
+            waitForCommands(wait);
+        }
+    }
+}
+
+void startSimulation(bool paused, double targetRate) {
+    simPaused = paused;
+    simTargetRate = targetRate;
+    rateWindowStart = SDL_GetPerformanceCounter();
+    lastCheckpointTime = rateWindowStart;
+    startIoThread(wakeSimulation);
+    simulationRunning = true;
+    simulationThread = std::thread(simulationLoop);
+}
+
+void stopSimulation() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        simulationRunning = false;
+    }
+    wakeCondition.notify_one();
+    if (simulationThread.joinable()) {
+        simulationThread.join();
+    }
+    stopSessionLog(generation);
+    stopIoThread(); // Finishes any queued saves
+}
+
+void setCheckpointSettings(const CheckpointSettings& settings) {
+    checkpointSettings = settings;
+}
+
+void postCommand(const SimCommand& command) {
+    // The queue only fills up if the simulation thread is stalled; wait for room rather than drop edits
+    while (!commandQueue.push(command)) {
+        std::this_thread::yield();
+    }
+
+    // Taking the lock orders the push before a concurrent wait check, so the wake-up cannot be lost
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void setPublishCallback(void (*callback)()) {
+    publishCallback = callback;
+}
+
+bool acquireSnapshot() {
+    return snapshots.acquire();
+}
+
+const GridSnapshot& getSnapshot() {
+    return snapshots.getFrontBuffer();
+}
@@ -0,0 +1,200 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PopulationPyramid.h"
+#include "GameOfLife.h"
+#include "Checkpoint.h"
+#include "PatternIO.h"
+#include "PerfCounters.h"
+
+// The part of the board on screen and the channel shown there (-1 for none): viewport pixel
+// (sx, sy) shows the cells from (floor(x + sx / zoom), floor(y + sy / zoom)) on
+struct SimViewport {
+    double x = 0.0;
+    double y = 0.0;
+    double zoom = 1.0;
+    int columns = 0;
+    int rows = 0;
+    int channel = -1;
+
+    bool operator==(const SimViewport& other) const {
+        return x == other.x && y == other.y && zoom == other.zoom && columns == other.columns && rows == other.rows &&
+               channel == other.channel;
+    }
+    bool operator!=(const SimViewport& other) const { return !(*this == other); }
+};
+
+// A completed generation, published by the simulation thread for the renderer. Each of the
+// three buffers is brought up to date by copying only the tiles changed since it was last
+// published, so a publish costs in proportion to the change, not to the board.
+struct GridSnapshot {
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> cells;  // Same bit-packed row layout as getGrid()
+    // The shown channel's value at the first cell of each viewport pixel, row by row, sampled
+    // for auxViewport; empty unless the channels are enabled and one is shown
+    std::vector<uint8_t> auxView;
+    SimViewport auxViewport;
+    PopulationPyramid pyramid;
+    uint64_t generation = 0;
+    uint64_t population = 0;
+    double generationsPerSecond = 0.0;  // Achieved rate, measured by the simulation thread
+    int generationsPerFrame = 0;        // Generations stepped per published frame
+    uint64_t droppedGenerations = 0;    // Generations skipped because stepping fell too far behind
+    bool stable = false;                // The last generation left the board unchanged
+    std::string rule;                   // Rule in B/S notation
+    StepEngine engine = ENGINE_DENSE;   // Engine of the last generation stepped
+    EngineCosts engineCosts;            // Calibrated costs the engines are chosen by
+    GridPlacement placement;            // Of the board's memory, refreshed about once a second
+    PerfReading stepCounters;           // Of updateGrid over the last second, while SetCounters is on
+    std::string counterError;           // Why hardware counters are unavailable, if they are
+
+    bool getCellState(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return false;
+        }
+        return (cells[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    uint64_t countLiveCells(int x0, int y0, int x1, int y1) const {
+        return pyramid.countLiveCells(cells.data(), wordsPerRow, x0, y0, x1, y1);
+    }
+};
+
+// Single-writer single-reader triple buffer. The writer always owns one buffer and the
+// reader another; the third sits in the middle and is swapped atomically on publish and
+// acquire, so neither side ever waits on the other.
+class TripleBuffer {
+public:
+    static const int BUFFER_COUNT = 3;
+
+    GridSnapshot& getBackBuffer() { return buffers[backIndex]; }
+    int getBackIndex() const { return backIndex; } // Which of the three buffers the writer holds
+    const GridSnapshot& getFrontBuffer() const { return buffers[frontIndex]; }
+
+    // Writer: hand the back buffer over and take the middle one in exchange
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader: swap in the middle buffer if a newer generation was published since the last call
+    bool acquire() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    GridSnapshot buffers[BUFFER_COUNT];
+    std::atomic<int> middle{1};
+    int backIndex = 0;
+    int frontIndex = 2;
+};
+
+// Lock-free single-producer single-consumer ring buffer
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    bool push(const T& item) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % Capacity;
+        if (next == headIndex.load(std::memory_order_acquire)) {
+            return false; // Full
+        }
+        items[tail] = item;
+        tailIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+    }
+
+    bool pop(T& item) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == tailIndex.load(std::memory_order_acquire)) {
+            return false; // Empty
+        }
+        item = items[head];
+        headIndex.store((head + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<size_t> headIndex{0};
+    std::atomic<size_t> tailIndex{0};
+};
+
+// Requests from the UI thread to the simulation thread
+enum class SimCommandType {
+    Paint,          // Set a size x size square at (x, y) to state
+    Clear,
+    Reset,
+    Save,           // Write path (grid.rle if empty) in the format of its extension
+    Load,           // Read path (grid.rle, or grid.txt from older versions, if empty); with state
+                    // set it is placed at (x, y) in the current board instead of replacing it
+    SaveSnapshot,   // Write grid.golsnap, a binary snapshot including the generation
+    LoadSnapshot,
+    ExportImage,    // Write path as a PBM or PNG image, by extension, value pixels per cell side
+    SetPaused,      // value != 0 pauses
+    SetTargetRate,  // rate is the target generations per second
+    SetMaxSpeed,    // value != 0 steps as many generations per frame as fit the frame budget
+    SetFrameBudget, // value is the stepping budget per frame in microseconds
+    SetAuxChannels, // value != 0 maintains the age, last-change and heat channels
+    SetCheckpoints, // value is the generation interval and rate the interval in seconds, 0 turns either off
+    ResumeCheckpoint, // Replace the board with the newest consistent checkpoint
+    StartSessionLog, // Record every edit from now on to path (SessionLog.h)
+    StopSessionLog,
+    EditRegion,     // Apply the RegionEdit in value to the width x height rectangle at (x, y)
+    Paste,          // Write pattern at (x, y), ORed in if state is set
+    SetEngine,      // value is the StepEngine, ENGINE_AUTO to let the costs decide
+    SetCounters,    // value != 0 measures every step with the hardware counters (PerfCounters.h)
+    SetViewport     // viewport is what the renderer shows, so channels are sampled only there
+};
+
+struct SimCommand {
+    SimCommandType type;
+    int x = 0;
+    int y = 0;
+    int size = 1;
+    bool state = false;
+    int value = 0;
+    double rate = 0.0;
+    std::string path;
+    int width = 0;
+    int height = 0;
+    std::shared_ptr<const Pattern> pattern; // Shared, so a brush stamped many times is not copied
+    SimViewport viewport;
+};
+
+// Run the simulation on its own thread; the grid functions of GameOfLife.h must then only
+// be called from that thread, everything else goes through postCommand. File saves and
+// loads run on a further I/O thread (BackgroundIO.h), started and stopped with it.
+void startSimulation(bool paused, double targetRate);
+
+// Where and how often to checkpoint; set before startSimulation
+void setCheckpointSettings(const CheckpointSettings& settings);
+void stopSimulation();
+void postCommand(const SimCommand& command);
+
+// Called on the simulation thread after every publish, e.g. to wake a waiting event loop
+void setPublishCallback(void (*callback)());
+
+// Renderer side: swap in the latest published generation, returns true if it is new
+bool acquireSnapshot();
+const GridSnapshot& getSnapshot();
+
+#endif // SIMULATION_H
@@ -0,0 +1,177 @@
+#include "Universe.h"
+#include "EngineTuner.h"
+#include "BinarySnapshot.h"
+#include "Headless.h"
+#include "PerfCounters.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Benchmarks of the step engines, linked against libgol only. Every engine steps its own
+// universe from the same random soup, and the results are printed as one JSON document,
+// with the hardware counters of each run where the system offers them (PerfCounters.h):
+//   --sizes A,B,...     board sides to run (default 256,1024,4096)
+//   --generations N     generations per run (default 200)
+//   --engine NAME       only this engine (dense, threaded, active, sparse or auto); all by default
+//   --seed N            seed of the soup (default 1)
+//   --calibrate         measure the engine costs again instead of reading them
+//   --output PATH       write the JSON there instead of to stdout
+
+struct BenchResult {
+    StepEngine engine;
+    int size;
+    uint64_t generations;
+    double seconds;
+    UniverseStats stats;
+    uint64_t checksum;
+    PerfReading counters; // Of the steps, over all the threads stepping
+};
+
+BenchResult runBench(StepEngine engine, const EngineCosts& costs, int size, uint64_t generations, uint64_t seed, PerfCounters& counters) {
+    Universe universe(size, size);
+    universe.setEngineCosts(costs);
+    universe.setStepEngine(engine);
+    universe.randomize(seed);
+
+    auto start = std::chrono::steady_clock::now();
+    counters.start();
+    universe.step(generations);
+    counters.stop(generations);
+    BenchResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.counters = counters.takeReading();
+    result.engine = engine;
+    result.size = size;
+    result.generations = generations;
+    result.stats = universe.getStats();
+    result.checksum = checksumWords(universe.getWords().data(), universe.getWords().size());
+    return result;
+}
+
+// Counter totals of a run, null where a counter is not available
+void writeCounters(std::ostream& out, const PerfReading& reading) {
+    char number[64];
+    out << "{";
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        std::snprintf(number, sizeof(number), "%.0f", reading.counts[counter]);
+        out << (counter == 0 ? "\"" : ", \"") << PERF_COUNTER_NAMES[counter] << "\": " << (reading.available[counter] ? number : "null");
+    }
+    std::snprintf(number, sizeof(number), "%.3f", reading.getIpc());
+    out << ", \"ipc\": " << (reading.available[PERF_CYCLES] && reading.available[PERF_INSTRUCTIONS] ? number : "null") << "}";
+}
+
+void writeJson(std::ostream& out, const std::string& cpu, const EngineCosts& costs, const std::string& counterError,
+               const std::vector<BenchResult>& results) {
+    char number[64];
+    out << "{\n  \"cpu\": \"" << cpu << "\",\n";
+    out << "  \"counterError\": \"" << counterError << "\",\n";
+    std::snprintf(number, sizeof(number), "%.4f", costs.denseWord);
+    out << "  \"costs\": {\"denseWord\": " << number << ", \"threads\": " << costs.threads;
+    std::snprintf(number, sizeof(number), "%.4f", costs.threadedWord);
+    out << ", \"threadedWord\": " << number;
+    std::snprintf(number, sizeof(number), "%.1f", costs.threadedGeneration);
+    out << ", \"threadedGeneration\": " << number;
+    std::snprintf(number, sizeof(number), "%.4f", costs.activeWord);
+    out << ", \"activeWord\": " << number;
+    std::snprintf(number, sizeof(number), "%.1f", costs.activeGeneration);
+    out << ", \"activeGeneration\": " << number;
+    std::snprintf(number, sizeof(number), "%.4f", costs.sparseCell);
+    out << ", \"sparseCell\": " << number;
+    std::snprintf(number, sizeof(number), "%.1f", costs.sparseGeneration);
+    out << ", \"sparseGeneration\": " << number << "},\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        double cells = static_cast<double>(result.size) * result.size * result.generations;
+        out << (i == 0 ? "\n" : ",\n") << "    {\"engine\": \"" << STEP_ENGINE_NAMES[result.engine] << "\""
+            << ", \"size\": " << result.size << ", \"generations\": " << result.generations;
+        std::snprintf(number, sizeof(number), "%.6f", result.seconds);
+        out << ", \"seconds\": " << number;
+        std::snprintf(number, sizeof(number), "%.1f", result.generations / result.seconds);
+        out << ", \"generationsPerSecond\": " << number;
+        std::snprintf(number, sizeof(number), "%.4g", cells / result.seconds);
+        out << ", \"cellsPerSecond\": " << number << ", \"population\": " << result.stats.population;
+        std::snprintf(number, sizeof(number), "%016llx", static_cast<unsigned long long>(result.checksum));
+        out << ", \"checksum\": \"" << number << "\", \"engineGenerations\": {";
+        for (int kind = 0; kind < ENGINE_COUNT; ++kind) {
+            out << (kind == 0 ? "" : ", ") << "\"" << STEP_ENGINE_NAMES[kind] << "\": " << result.stats.engineGenerations[kind];
+        }
+        out << "}, \"counters\": ";
+        writeCounters(out, result.counters);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes = { 256, 1024, 4096 };
+    if (const char* list = getArgument(argc, argv, "--sizes")) {
+        sizes.clear();
+        std::stringstream stream(list);
+        std::string size;
+        while (std::getline(stream, size, ',')) {
+            if (std::atoi(size.c_str()) > 0) {
+                sizes.push_back(std::atoi(size.c_str()));
+            }
+        }
+    }
+    const char* generationsArgument = getArgument(argc, argv, "--generations");
+    uint64_t generations = generationsArgument ? std::strtoull(generationsArgument, nullptr, 10) : 200;
+    const char* seedArgument = getArgument(argc, argv, "--seed");
+    uint64_t seed = seedArgument ? std::strtoull(seedArgument, nullptr, 10) : 1;
+
+    std::vector<StepEngine> engines = { ENGINE_DENSE, ENGINE_THREADED, ENGINE_ACTIVE, ENGINE_SPARSE, ENGINE_AUTO };
+    if (getArgument(argc, argv, "--engine") != nullptr) {
+        StepEngine engine;
+        if (!getEngineArgument(argc, argv, engine)) {
+            std::cerr << "Unknown engine: " << getArgument(argc, argv, "--engine") << std::endl;
+            return 1;
+        }
+        engines = { engine };
+    }
+
+    std::string calibrationMessage;
+    EngineCosts costs = loadEngineCosts(getEngineCalibrationPath(), hasArgument(argc, argv, "--calibrate"), calibrationMessage);
+    std::cerr << calibrationMessage << std::endl;
+
+    // Opened before any engine starts its worker threads, so the threads are counted too
+    PerfCounters counters;
+    counters.open(true);
+    if (!counters.getError().empty()) {
+        std::cerr << "Hardware counters unavailable: " << counters.getError() << std::endl;
+    }
+
+    std::vector<BenchResult> results;
+    for (int size : sizes) {
+        size_t first = results.size();
+        for (StepEngine engine : engines) {
+            if (engine == ENGINE_THREADED && costs.threads <= 1) {
+                continue; // Would run as dense
+            }
+            // Every engine must end on the board the first one ended on
+            results.push_back(runBench(engine, costs, size, generations, seed, counters));
+            if (results.back().checksum != results[first].checksum) {
+                std::cerr << "Engine " << STEP_ENGINE_NAMES[engine] << " diverged on a " << size << " board" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    const char* outputPath = getArgument(argc, argv, "--output");
+    if (outputPath != nullptr) {
+        std::ofstream out(outputPath);
+        writeJson(out, getCpuModel(), costs, counters.getError(), results);
+        if (!out) {
+            std::cerr << "Cannot write " << outputPath << std::endl;
+            return 1;
+        }
+    } else {
+        writeJson(std::cout, getCpuModel(), costs, counters.getError(), results);
+    }
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include "BackgroundIO.h"
+#include "BinarySnapshot.h"
+#include "ImageExport.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+struct IoJob {
+    IoJobType type;
+    std::string path;
+    Pattern board;        // Saves: the board copy to write. Loads: the parsed result.
+    uint64_t generation = 0;
+    CheckpointSettings checkpoint;
+    bool placeAt = false; // Placement of a loaded pattern
+    int x = 0;
+    int y = 0;
+    int cellPixels = 1;   // Image exports
+};
+
+std::thread ioThread;
+std::mutex ioMutex;
+std::condition_variable ioJobAvailable;
+std::deque<IoJob> ioJobs;
+bool ioRunning = false;
+void (*loadedCallback)() = nullptr;
+
+// Status and finished loads, guarded by ioMutex
+IoStatus ioStatus;
+std::chrono::steady_clock::time_point jobStart;
+std::deque<IoJob> loadedBoards;
+
+// Flush a closed file's data to the disk
+bool syncFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ok;
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    bool ok = fsync(descriptor) == 0;
+    close(descriptor);
+    return ok;
+#endif
+}
+
+bool writeFileAtomically(const std::string& path, const std::function<bool(const std::string&, std::string&)>& write,
+                         std::string& error) {
+    // Keep the extension last, since writers pick the format from it
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    std::string tempPath = hasExtension ? path.substr(0, dot) + ".tmp" + path.substr(dot) : path + ".tmp";
+    if (!write(tempPath, error)) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    if (!syncFile(tempPath)) {
+        error = "Failed to flush " + tempPath;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    bool renamed = MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    bool renamed = std::rename(tempPath.c_str(), path.c_str()) == 0;
+    if (renamed) {
+        // Make the rename itself durable
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, std::max<size_t>(slash, 1));
+        int descriptor = open(directory.c_str(), O_RDONLY);
+        if (descriptor >= 0) {
+            fsync(descriptor);
+            close(descriptor);
+        }
+    }
+#endif
+    if (!renamed) {
+        error = "Failed to replace " + path;
+        std::remove(tempPath.c_str());
+    }
+    return renamed;
+}
+
+void setActivity(const std::string& activity) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    ioStatus.activity = activity;
+}
+
+void finishJob(const std::string& result, bool failed) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    ioStatus.busy = false;
+    ioStatus.activity.clear();
+    ioStatus.lastResult = result;
+    ioStatus.lastFailed = failed;
+}
+
+void runJob(IoJob& job) {
+    std::string error;
+    bool ok;
+
+    switch (job.type) {
+        case IoJobType::SavePattern:
+        case IoJobType::SaveSnapshot: {
+            setActivity("Writing " + job.path);
+            const Pattern& board = job.board;
+            ok = writeFileAtomically(job.path, [&](const std::string& tempPath, std::string& writeError) {
+                return job.type == IoJobType::SaveSnapshot
+                           ? writeBinarySnapshot(tempPath, board.words.data(), board.wordsPerRow, board.width, board.height, board.rule, job.generation, writeError)
+                           : writePattern(tempPath, board.words.data(), board.wordsPerRow, board.width, board.height, board.rule, writeError);
+            }, error);
+            // The copy can be large; give it back before reporting
+            std::vector<uint64_t>().swap(job.board.words);
+            finishJob(ok ? "Saved " + job.path + " at generation " + std::to_string(job.generation) : error, !ok);
+            break;
+        }
+        case IoJobType::ExportImage: {
+            const std::string activity = "Exporting " + job.path;
+            setActivity(activity);
+            const Pattern& board = job.board;
+            int percent = 0;
+            ok = writeFileAtomically(job.path, [&](const std::string& tempPath, std::string& writeError) {
+                return exportImage(tempPath, imageFormatForPath(job.path), board.words.data(), board.wordsPerRow, board.width,
+                                   board.height, job.cellPixels, writeError, [&](double done) {
+                                       if (static_cast<int>(done * 100) > percent) {
+                                           percent = static_cast<int>(done * 100);
+                                           setActivity(activity + " (" + std::to_string(percent) + "%)");
+                                       }
+                                   });
+            }, error);
+            std::vector<uint64_t>().swap(job.board.words);
+            finishJob(ok ? "Exported generation " + std::to_string(job.generation) + " to " + job.path : error, !ok);
+            break;
+        }
+        case IoJobType::Checkpoint: {
+            setActivity("Checkpointing to " + job.checkpoint.directory);
+            std::string result;
+            ok = writeCheckpoint(job.checkpoint, job.board, job.generation, result, error);
+            finishJob(ok ? result : error, !ok);
+            break;
+        }
+        case IoJobType::LoadPattern:
+        case IoJobType::LoadSnapshot:
+        case IoJobType::LoadCheckpoint: {
+            setActivity("Reading " + job.path);
+            if (job.type == IoJobType::LoadCheckpoint) {
+                ok = readLatestCheckpoint(job.path, job.board, job.generation, error);
+            } else if (job.type == IoJobType::LoadSnapshot) {
+                ok = readBinarySnapshot(job.path, job.board, job.generation, error);
+            } else {
+                ok = readPattern(job.path, job.board, error);
+            }
+            if (!ok) {
+                finishJob(error, true);
+                break;
+            }
+            // The board owner swaps it in and reports the outcome
+            finishJob("Read " + job.path, false);
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                loadedBoards.push_back(std::move(job));
+            }
+            if (loadedCallback != nullptr) {
+                loadedCallback();
+            }
+            break;
+        }
+    }
+}
+
+void ioLoop() {
+    while (true) {
+        IoJob job;
+        {
+            std::unique_lock<std::mutex> lock(ioMutex);
+            ioJobAvailable.wait(lock, [] { return !ioJobs.empty() || !ioRunning; });
+            if (ioJobs.empty()) {
+                return; // Stopped and drained
+            }
+            job = std::move(ioJobs.front());
+            ioJobs.pop_front();
+            ioStatus.busy = true;
+            ioStatus.queued = ioJobs.size();
+            jobStart = std::chrono::steady_clock::now();
+        }
+        runJob(job);
+    }
+}
+
+void startIoThread(void (*onLoaded)()) {
+    loadedCallback = onLoaded;
+    ioRunning = true;
+    ioThread = std::thread(ioLoop);
+}
+
+void stopIoThread() {
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        ioRunning = false;
+    }
+    ioJobAvailable.notify_one();
+    if (ioThread.joinable()) {
+        ioThread.join();
+    }
+}
+
+void queueJob(IoJob job) {
+    {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        ioJobs.push_back(std::move(job));
+        ioStatus.queued = ioJobs.size();
+    }
+    ioJobAvailable.notify_one();
+}
+
+void queueSave(IoJobType type, const std::string& path, Pattern board, uint64_t generation) {
+    IoJob job;
+    job.type = type;
+    job.path = path;
+    job.board = std::move(board);
+    job.generation = generation;
+    queueJob(std::move(job));
+}
+
+void queueLoad(IoJobType type, const std::string& path, bool placeAt, int x, int y) {
+    IoJob job;
+    job.type = type;
+    job.path = path;
+    job.placeAt = placeAt;
+    job.x = x;
+    job.y = y;
+    queueJob(std::move(job));
+}
+
+void queueExport(const std::string& path, Pattern board, uint64_t generation, int cellPixels) {
+    IoJob job;
+    job.type = IoJobType::ExportImage;
+    job.path = path;
+    job.board = std::move(board);
+    job.generation = generation;
+    job.cellPixels = cellPixels;
+    queueJob(std::move(job));
+}
+
+void queueCheckpoint(const CheckpointSettings& settings, Pattern board, uint64_t generation) {
+    IoJob job;
+    job.type = IoJobType::Checkpoint;
+    job.path = settings.directory;
+    job.board = std::move(board);
+    job.generation = generation;
+    job.checkpoint = settings;
+    queueJob(std::move(job));
+}
+
+bool hasLoadedBoard() {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    return !loadedBoards.empty();
+}
+
+bool takeLoadedBoard(LoadedBoard& loaded) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    if (loadedBoards.empty()) {
+        return false;
+    }
+    IoJob& job = loadedBoards.front();
+    loaded.type = job.type;
+    loaded.path = std::move(job.path);
+    loaded.board = std::move(job.board);
+    loaded.generation = job.generation;
+    loaded.placeAt = job.placeAt;
+    loaded.x = job.x;
+    loaded.y = job.y;
+    loadedBoards.pop_front();
+    return true;
+}
+
+void reportIoResult(const std::string& result, bool failed) {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    ioStatus.lastResult = result;
+    ioStatus.lastFailed = failed;
+}
+
+IoStatus getIoStatus() {
+    std::lock_guard<std::mutex> lock(ioMutex);
+    IoStatus status = ioStatus;
+    if (status.busy) {
+        status.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - jobStart).count();
+    }
+    return status;
+}
@@ -0,0 +1,72 @@
+#ifndef BACKGROUND_IO_H
+#define BACKGROUND_IO_H
+
+#include <functional>
+#include <string>
+#include <cstdint>
+#include "PatternIO.h"
+#include "Checkpoint.h"
+
+enum class IoJobType {
+    SavePattern,   // RLE, Macrocell or the legacy text format, by extension
+    SaveSnapshot,  // Binary snapshot
+    LoadPattern,
+    LoadSnapshot,
+    Checkpoint,    // Base or delta in the checkpoint directory
+    LoadCheckpoint, // Newest consistent checkpoint; the path is the directory
+    ExportImage     // PBM or PNG, by extension (ImageExport.h)
+};
+
+struct IoStatus {
+    bool busy = false;
+    std::string activity;       // What the I/O thread is doing right now
+    double seconds = 0.0;       // Time spent on the current job
+    size_t queued = 0;          // Jobs waiting behind it
+    std::string lastResult;     // Outcome of the last finished job
+    bool lastFailed = false;
+};
+
+// Run file saves and loads on their own thread. onLoaded is called from that thread when a
+// loaded board is ready to be taken, e.g. to wake the simulation thread.
+void startIoThread(void (*onLoaded)());
+
+// Finish the queued jobs, so no save is lost on exit, and stop the thread
+void stopIoThread();
+
+// A board parsed by a finished load
+struct LoadedBoard {
+    IoJobType type = IoJobType::LoadPattern;
+    std::string path;
+    Pattern board;
+    uint64_t generation = 0;  // Snapshots and checkpoints
+    bool placeAt = false;     // Place a pattern at (x, y) in the current board, which may be
+    int x = 0;                // off its edges, instead of centring it on a board grown to fit
+    int y = 0;
+};
+
+// Queue a save of a copy of the board; the caller carries on at once
+void queueSave(IoJobType type, const std::string& path, Pattern board, uint64_t generation);
+void queueLoad(IoJobType type, const std::string& path, bool placeAt = false, int x = 0, int y = 0);
+
+// Queue an image export of a copy of the board, cellPixels pixels per cell side; the
+// status shows how much of it is written
+void queueExport(const std::string& path, Pattern board, uint64_t generation, int cellPixels);
+
+// Queue a checkpoint of a board copy; call only after tryBeginCheckpoint succeeded
+void queueCheckpoint(const CheckpointSettings& settings, Pattern board, uint64_t generation);
+
+// Board owner: take a board parsed by a finished load, if there is one
+bool hasLoadedBoard();
+bool takeLoadedBoard(LoadedBoard& loaded);
+
+// Record the outcome of applying a loaded board, for the status line
+void reportIoResult(const std::string& result, bool failed);
+
+IoStatus getIoStatus();
+
+// Write a file through a temporary next to it, flushed to disk and renamed over the target,
+// so the target is either the old file or the complete new one, never half written
+bool writeFileAtomically(const std::string& path, const std::function<bool(const std::string&, std::string&)>& write,
+                         std::string& error);
+
+#endif // BACKGROUND_IO_H
@@ -0,0 +1,225 @@
+#include "BinarySnapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <new>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char SNAPSHOT_MAGIC[8] = {'G', 'O', 'L', 'S', 'N', 'A', 'P', '\n'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// Little-endian on disk, as the engine's words are; 80 bytes keeps the words 16-byte aligned
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t wordsPerRow;
+    uint32_t flags;       // Reserved, 0
+    uint64_t generation;
+    uint64_t checksum;    // Of the header with this field zeroed, then the words
+    char rule[32];        // Null-terminated
+};
+static_assert(sizeof(SnapshotHeader) == 80, "snapshot header layout");
+
+// Four independent multiply-rotate lanes, so the hash keeps up with memory bandwidth
+struct SnapshotHasher {
+    static const uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+    uint64_t lanes[4] = {1, 2, 3, 4};
+    uint64_t length = 0;
+
+    static uint64_t mix(uint64_t lane, uint64_t word) {
+        lane = (lane ^ word) * PRIME;
+        return (lane << 31) | (lane >> 33);
+    }
+
+    void add(const uint64_t* words, size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            lanes[0] = mix(lanes[0], words[i]);
+            lanes[1] = mix(lanes[1], words[i + 1]);
+            lanes[2] = mix(lanes[2], words[i + 2]);
+            lanes[3] = mix(lanes[3], words[i + 3]);
+        }
+        for (; i < count; ++i) {
+            lanes[0] = mix(lanes[0], words[i]);
+        }
+        length += count;
+    }
+
+    uint64_t finish() const {
+        uint64_t hash = length;
+        for (uint64_t lane : lanes) {
+            hash = mix(hash, lane);
+        }
+        return hash ^ (hash >> 29);
+    }
+};
+
+uint64_t snapshotChecksum(SnapshotHeader header, const uint64_t* words, size_t count) {
+    header.checksum = 0;
+    uint64_t headerWords[sizeof(SnapshotHeader) / 8];
+    std::memcpy(headerWords, &header, sizeof(header));
+
+    SnapshotHasher hasher;
+    hasher.add(headerWords, sizeof(headerWords) / 8);
+    hasher.add(words, count);
+    return hasher.finish();
+}
+
+uint64_t checksumWords(const uint64_t* words, size_t count) {
+    SnapshotHasher hasher;
+    hasher.add(words, count);
+    return hasher.finish();
+}
+
+// Read-only view of a whole file, memory-mapped where the platform allows
+class MappedFile {
+public:
+    ~MappedFile() {
+#ifdef _WIN32
+        if (view != nullptr) UnmapViewOfFile(view);
+        if (mapping != nullptr) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (view != nullptr) munmap(view, length);
+        if (descriptor >= 0) close(descriptor);
+#endif
+    }
+
+    bool open(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            return false;
+        }
+        length = static_cast<size_t>(size.QuadPart);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+        descriptor = ::open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (descriptor < 0 || fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            return false;
+        }
+        length = static_cast<size_t>(status.st_size);
+        view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (view == MAP_FAILED) {
+            view = nullptr;
+        } else {
+            madvise(view, length, MADV_SEQUENTIAL);
+        }
+#endif
+        return view != nullptr;
+    }
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(view); }
+    size_t size() const { return length; }
+
+private:
+    void* view = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
+
+bool isBinarySnapshotPath(const std::string& path) {
+    size_t extensionLength = sizeof(BINARY_SNAPSHOT_EXTENSION) - 1;
+    return path.size() >= extensionLength && path.compare(path.size() - extensionLength, extensionLength, BINARY_SNAPSHOT_EXTENSION) == 0;
+}
+
+bool writeBinarySnapshot(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+                         const std::string& rule, uint64_t generation, std::string& error) {
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.width = width;
+    header.height = height;
+    header.wordsPerRow = wordsPerRow;
+    header.generation = generation;
+    std::strncpy(header.rule, rule.c_str(), sizeof(header.rule) - 1);
+
+    size_t count = static_cast<size_t>(wordsPerRow) * height;
+    header.checksum = snapshotChecksum(header, words, count);
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (count == 0 || std::fwrite(words, sizeof(uint64_t), count, file) == count);
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Failed to write " + path;
+    }
+    return ok;
+}
+
+bool readBinarySnapshot(const std::string& path, Pattern& pattern, uint64_t& generation, std::string& error) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    SnapshotHeader header;
+    if (file.size() < sizeof(header)) {
+        error = path + " is not a snapshot";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        error = path + " is not a snapshot";
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION || header.headerSize < sizeof(header) || header.headerSize % 8 != 0) {
+        error = path + " has an unsupported snapshot version";
+        return false;
+    }
+
+    size_t count = static_cast<size_t>(header.wordsPerRow) * header.height;
+    if (header.wordsPerRow != (static_cast<uint64_t>(header.width) + 63) / 64 || header.width > 0x7FFFFFFF ||
+        header.height > 0x7FFFFFFF || header.headerSize > file.size() ||
+        (file.size() - header.headerSize) / sizeof(uint64_t) < count) {
+        error = path + " is truncated or has a bad size";
+        return false;
+    }
+
+    // The header size is a multiple of 8 and the view is page aligned, so the words can be read in place
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(file.data() + header.headerSize);
+    if (snapshotChecksum(header, words, count) != header.checksum) {
+        error = path + " is corrupt (checksum mismatch)";
+        return false;
+    }
+
+    try {
+        pattern.words.assign(words, words + count);
+    } catch (const std::bad_alloc&) {
+        error = path + " is too large to load";
+        return false;
+    }
+    pattern.width = static_cast<int>(header.width);
+    pattern.height = static_cast<int>(header.height);
+    pattern.wordsPerRow = static_cast<int>(header.wordsPerRow);
+    header.rule[sizeof(header.rule) - 1] = '\0';
+    pattern.rule = header.rule;
+    generation = header.generation;
+    return true;
+}
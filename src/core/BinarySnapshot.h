@@ -0,0 +1,24 @@
+#ifndef BINARY_SNAPSHOT_H
+#define BINARY_SNAPSHOT_H
+
+#include <string>
+#include <cstdint>
+#include "PatternIO.h"
+
+// Binary snapshots: an 80-byte header (magic, version, size, rule, generation, checksum)
+// followed by the grid words exactly as the engine stores them, so saving is one write and
+// loading is a mapped view checked and copied at memory speed.
+const char BINARY_SNAPSHOT_EXTENSION[] = ".golsnap";
+
+bool isBinarySnapshotPath(const std::string& path);
+
+bool writeBinarySnapshot(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+                         const std::string& rule, uint64_t generation, std::string& error);
+
+// Fails on a bad magic, version or size, or a checksum mismatch
+bool readBinarySnapshot(const std::string& path, Pattern& pattern, uint64_t& generation, std::string& error);
+
+// The hash snapshots are checked with, fast enough to run at memory bandwidth
+uint64_t checksumWords(const uint64_t* words, size_t count);
+
+#endif // BINARY_SNAPSHOT_H
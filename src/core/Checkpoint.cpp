@@ -0,0 +1,313 @@
+#include "Checkpoint.h"
+#include "BinarySnapshot.h"
+#include "BackgroundIO.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+const char DELTA_MAGIC[8] = {'G', 'O', 'L', 'D', 'E', 'L', 'T', 'A'};
+const uint32_t DELTA_VERSION = 1;
+
+struct DeltaHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t wordsPerRow;
+    uint32_t runCount;        // Runs of changed words that follow
+    uint64_t baseId;
+    uint64_t sequence;
+    uint64_t generation;
+    uint64_t boardChecksum;   // checksumWords of the rebuilt board
+    uint64_t payloadChecksum; // checksumWords of the runs
+    char rule[32];
+};
+// The payload after it is runs of changed words: first word index, length, then the words
+// XORed with the base
+static_assert(sizeof(DeltaHeader) % 8 == 0, "delta payload alignment");
+
+// Checkpoint files of a directory, grouped by base
+struct CheckpointFiles {
+    std::map<uint64_t, fs::path> bases;
+    std::map<uint64_t, std::map<uint64_t, fs::path>> deltas; // Base id, then sequence
+};
+
+std::atomic<bool> checkpointInFlight{false};
+
+// Owned by the I/O thread: the base the next delta is taken against
+Pattern currentBase;
+uint64_t currentBaseId = 0;
+uint64_t nextSequence = 1;
+
+bool tryBeginCheckpoint() {
+    bool expected = false;
+    return checkpointInFlight.compare_exchange_strong(expected, true);
+}
+
+CheckpointFiles listCheckpoints(const std::string& directory) {
+    CheckpointFiles files;
+    std::error_code code;
+    for (fs::directory_iterator it(directory, code), end; !code && it != end; it.increment(code)) {
+        std::string name = it->path().filename().string();
+        unsigned long long base, sequence;
+        char tail[16];
+        if (std::sscanf(name.c_str(), "delta-%llu-%llu%15s", &base, &sequence, tail) == 3 && std::strcmp(tail, ".goldelta") == 0) {
+            files.deltas[base][sequence] = it->path();
+        } else if (std::sscanf(name.c_str(), "base-%llu%15s", &base, tail) == 2 && std::strcmp(tail, ".golsnap") == 0) {
+            files.bases[base] = it->path();
+        }
+    }
+    return files;
+}
+
+bool hasCheckpoint(const std::string& directory) {
+    return !listCheckpoints(directory).bases.empty();
+}
+
+std::string checkpointName(const char* format, uint64_t base, uint64_t sequence = 0) {
+    char name[64];
+    std::snprintf(name, sizeof(name), format, static_cast<unsigned long long>(base), static_cast<unsigned long long>(sequence));
+    return name;
+}
+
+// Collect the runs of words where the board differs from the base
+std::vector<uint64_t> encodeDelta(const Pattern& base, const Pattern& board, uint32_t& runCount) {
+    std::vector<uint64_t> payload;
+    runCount = 0;
+    size_t count = board.words.size();
+    for (size_t i = 0; i < count;) {
+        if (board.words[i] == base.words[i]) {
+            ++i;
+            continue;
+        }
+        size_t runHeader = payload.size();
+        payload.push_back(i);
+        payload.push_back(0);
+        size_t start = i;
+        for (; i < count && board.words[i] != base.words[i]; ++i) {
+            payload.push_back(board.words[i] ^ base.words[i]);
+        }
+        payload[runHeader + 1] = i - start;
+        ++runCount;
+    }
+    return payload;
+}
+
+bool writeDelta(const std::string& path, const Pattern& board, const std::vector<uint64_t>& payload, uint32_t runCount,
+                uint64_t sequence, uint64_t generation, std::string& error) {
+    DeltaHeader header = {};
+    std::memcpy(header.magic, DELTA_MAGIC, sizeof(header.magic));
+    header.version = DELTA_VERSION;
+    header.headerSize = sizeof(DeltaHeader);
+    header.width = board.width;
+    header.height = board.height;
+    header.wordsPerRow = board.wordsPerRow;
+    header.runCount = runCount;
+    header.baseId = currentBaseId;
+    header.sequence = sequence;
+    header.generation = generation;
+    header.boardChecksum = checksumWords(board.words.data(), board.words.size());
+    header.payloadChecksum = checksumWords(payload.data(), payload.size());
+    std::strncpy(header.rule, board.rule.c_str(), sizeof(header.rule) - 1);
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (payload.empty() || std::fwrite(payload.data(), sizeof(uint64_t), payload.size(), file) == payload.size());
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Failed to write " + path;
+    }
+    return ok;
+}
+
+// Rebuild a board from a base and one of its deltas; false if the delta is torn or corrupt
+bool applyDelta(const fs::path& path, const Pattern& base, Pattern& board, uint64_t& generation) {
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    DeltaHeader header;
+    std::vector<uint64_t> payload;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && std::memcmp(header.magic, DELTA_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == DELTA_VERSION && header.headerSize == sizeof(DeltaHeader) &&
+              static_cast<int>(header.width) == base.width && static_cast<int>(header.height) == base.height;
+    if (ok) {
+        // The payload runs to the end of the file
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        ok = size >= static_cast<long>(sizeof(header)) && (size - sizeof(header)) % sizeof(uint64_t) == 0;
+        if (ok) {
+            payload.resize((size - sizeof(header)) / sizeof(uint64_t));
+            std::fseek(file, sizeof(header), SEEK_SET);
+            ok = payload.empty() || std::fread(payload.data(), sizeof(uint64_t), payload.size(), file) == payload.size();
+        }
+    }
+    std::fclose(file);
+    if (!ok || checksumWords(payload.data(), payload.size()) != header.payloadChecksum) {
+        return false;
+    }
+
+    board = base;
+    size_t position = 0;
+    for (uint32_t run = 0; run < header.runCount; ++run) {
+        if (position + 2 > payload.size()) {
+            return false;
+        }
+        uint64_t start = payload[position];
+        uint64_t count = payload[position + 1];
+        position += 2;
+        if (start + count > board.words.size() || position + count > payload.size()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            board.words[start + i] ^= payload[position + i];
+        }
+        position += count;
+    }
+    if (checksumWords(board.words.data(), board.words.size()) != header.boardChecksum) {
+        return false;
+    }
+    header.rule[sizeof(header.rule) - 1] = '\0';
+    board.rule = header.rule;
+    generation = header.generation;
+    return true;
+}
+
+// Delete the oldest checkpoints until the directory fits the budget. The current base and
+// the newest delta are always kept.
+void rotateCheckpoints(const CheckpointSettings& settings, uint64_t keepDelta) {
+    CheckpointFiles files = listCheckpoints(settings.directory);
+    std::vector<fs::path> oldestFirst;
+    for (const auto& base : files.bases) {
+        if (base.first != currentBaseId) {
+            for (const auto& delta : files.deltas[base.first]) {
+                oldestFirst.push_back(delta.second);
+            }
+            oldestFirst.push_back(base.second);
+        }
+    }
+    for (const auto& delta : files.deltas[currentBaseId]) {
+        if (delta.first != keepDelta) {
+            oldestFirst.push_back(delta.second);
+        }
+    }
+    // Deltas of bases that are gone can never be applied
+    for (const auto& group : files.deltas) {
+        if (files.bases.count(group.first) == 0) {
+            for (const auto& delta : group.second) {
+                oldestFirst.insert(oldestFirst.begin(), delta.second);
+            }
+        }
+    }
+
+    std::error_code code;
+    uint64_t total = 0;
+    for (const auto& entry : fs::directory_iterator(settings.directory, code)) {
+        total += entry.is_regular_file(code) ? entry.file_size(code) : 0;
+    }
+    for (const fs::path& path : oldestFirst) {
+        if (total <= settings.diskBudget) {
+            break;
+        }
+        uint64_t size = fs::file_size(path, code);
+        if (fs::remove(path, code)) {
+            total -= std::min(total, size);
+        }
+    }
+}
+
+bool writeCheckpoint(const CheckpointSettings& settings, Pattern& board, uint64_t generation,
+                     std::string& result, std::string& error) {
+    struct ReleaseSlot {
+        ~ReleaseSlot() { checkpointInFlight = false; }
+    } releaseSlot;
+
+    std::error_code code;
+    fs::create_directories(settings.directory, code);
+    if (code) {
+        error = "Failed to create " + settings.directory;
+        return false;
+    }
+
+    uint32_t runCount = 0;
+    std::vector<uint64_t> payload;
+    bool sameShape = currentBaseId != 0 && currentBase.width == board.width && currentBase.height == board.height &&
+                     currentBase.rule == board.rule;
+    if (sameShape) {
+        payload = encodeDelta(currentBase, board, runCount);
+    }
+
+    fs::path directory(settings.directory);
+    if (!sameShape || payload.size() * 2 > board.words.size()) {
+        // New base, numbered after every base already on disk so a resumed run never overwrites one
+        CheckpointFiles files = listCheckpoints(settings.directory);
+        uint64_t id = std::max(currentBaseId, files.bases.empty() ? 0 : files.bases.rbegin()->first) + 1;
+        std::string path = (directory / checkpointName("base-%06llu.golsnap", id)).string();
+        bool ok = writeFileAtomically(path, [&](const std::string& tempPath, std::string& writeError) {
+            return writeBinarySnapshot(tempPath, board.words.data(), board.wordsPerRow, board.width, board.height, board.rule, generation, writeError);
+        }, error);
+        if (!ok) {
+            return false;
+        }
+        currentBase = std::move(board);
+        currentBaseId = id;
+        nextSequence = 1;
+        rotateCheckpoints(settings, 0);
+        result = "Checkpoint at generation " + std::to_string(generation) + " (new base)";
+        return true;
+    }
+
+    uint64_t sequence = nextSequence++;
+    std::string path = (directory / checkpointName("delta-%06llu-%06llu.goldelta", currentBaseId, sequence)).string();
+    bool ok = writeFileAtomically(path, [&](const std::string& tempPath, std::string& writeError) {
+        return writeDelta(tempPath, board, payload, runCount, sequence, generation, writeError);
+    }, error);
+    if (!ok) {
+        return false;
+    }
+    rotateCheckpoints(settings, sequence);
+    result = "Checkpoint at generation " + std::to_string(generation) + " (delta, " +
+             std::to_string(payload.size() * sizeof(uint64_t) / 1024) + " KB)";
+    return true;
+}
+
+bool readLatestCheckpoint(const std::string& directory, Pattern& board, uint64_t& generation, std::string& error) {
+    CheckpointFiles files = listCheckpoints(directory);
+    if (files.bases.empty()) {
+        error = "No checkpoint in " + directory;
+        return false;
+    }
+
+    // Newest base first; within it, the newest delta that checks out wins
+    for (auto base = files.bases.rbegin(); base != files.bases.rend(); ++base) {
+        Pattern basePattern;
+        uint64_t baseGeneration;
+        std::string baseError;
+        if (!readBinarySnapshot(base->second.string(), basePattern, baseGeneration, baseError)) {
+            continue;
+        }
+        const auto& deltas = files.deltas[base->first];
+        for (auto delta = deltas.rbegin(); delta != deltas.rend(); ++delta) {
+            if (applyDelta(delta->second, basePattern, board, generation)) {
+                return true;
+            }
+        }
+        board = std::move(basePattern);
+        generation = baseGeneration;
+        return true;
+    }
+    error = "Every checkpoint in " + directory + " is damaged";
+    return false;
+}
@@ -0,0 +1,37 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include "PatternIO.h"
+
+struct CheckpointSettings {
+    std::string directory = "checkpoints";
+    uint64_t everyGenerations = 0;      // 0 disables the generation trigger
+    double everySeconds = 0.0;          // 0 disables the time trigger
+    uint64_t diskBudget = 1ULL << 30;   // Bytes kept in the directory before old checkpoints go
+};
+
+// Checkpoints are a base image (a binary snapshot, base-NNNNNN.golsnap) followed by deltas
+// (delta-NNNNNN-MMMMMM.goldelta) holding the words that differ from that base, XORed with
+// it. Each delta stands on the base alone, so recovery needs two files, and a new base is
+// written once a delta would grow past half the base.
+
+// Claim the single checkpoint slot; false while the previous checkpoint is still being
+// written, so a slow disk skips checkpoints instead of queueing board copies
+bool tryBeginCheckpoint();
+
+// Called on the I/O thread: write the board as the next base or delta, then delete the
+// oldest checkpoints until the directory fits the disk budget. Releases the slot.
+bool writeCheckpoint(const CheckpointSettings& settings, Pattern& board, uint64_t generation,
+                     std::string& result, std::string& error);
+
+// Find the newest base and delta that pass their checksums and rebuild the board from them,
+// falling back to older ones when the newest files are torn or corrupt
+bool readLatestCheckpoint(const std::string& directory, Pattern& board, uint64_t& generation, std::string& error);
+
+// Whether the directory holds any checkpoint, without reading it
+bool hasCheckpoint(const std::string& directory);
+
+#endif // CHECKPOINT_H
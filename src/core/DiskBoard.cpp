@@ -0,0 +1,554 @@
+#include "DiskBoard.h"
+#include "Universe.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The file: this header, zero-padded to HEADER_BYTES, then the two planes, each rounded up
+// to whole header-sized blocks. Little-endian, as the words are.
+const uint64_t HEADER_BYTES = 4096;
+const uint32_t DISK_BOARD_VERSION = 1;
+
+struct DiskBoard::Header {
+    char magic[8];        // "GOLDISK"
+    uint32_t version;
+    uint32_t current;     // Plane holding the last complete generation
+    int32_t width;
+    int32_t height;
+    uint64_t wordsPerRow;
+    uint64_t planeBytes;
+    uint64_t generation;
+    uint64_t population;
+    char rule[64];
+};
+
+#ifdef _WIN32
+
+bool isDiskBoardSupported() {
+    return false;
+}
+
+DiskBoard::~DiskBoard() {}
+
+bool DiskBoard::create(const std::string&, const Pattern&, uint64_t, std::string& error) {
+    error = "Out-of-core boards need mmap, which this system does not have";
+    return false;
+}
+
+bool DiskBoard::createRandom(const std::string&, int, int, uint64_t, const std::string&, std::string& error) {
+    error = "Out-of-core boards need mmap, which this system does not have";
+    return false;
+}
+
+bool DiskBoard::open(const std::string&, std::string& error) {
+    error = "Out-of-core boards need mmap, which this system does not have";
+    return false;
+}
+
+void DiskBoard::close() {}
+
+int DiskBoard::getWidth() const {
+    return 0;
+}
+
+int DiskBoard::getHeight() const {
+    return 0;
+}
+
+std::string DiskBoard::getRule() const {
+    return std::string();
+}
+
+void DiskBoard::setBandBytes(uint64_t bytes) {
+    bandBytes = std::max<uint64_t>(bytes, 1);
+}
+
+bool DiskBoard::step(uint64_t, std::string& error) {
+    error = "No board file is open";
+    return false;
+}
+
+bool DiskBoard::read(Pattern&, std::string& error) const {
+    error = "No board file is open";
+    return false;
+}
+
+#else
+
+bool isDiskBoardSupported() {
+    return true;
+}
+
+DiskBoard::~DiskBoard() {
+    close();
+}
+
+uint64_t* DiskBoard::plane(int index) const {
+    return reinterpret_cast<uint64_t*>(mapping + HEADER_BYTES + index * header->planeBytes);
+}
+
+uint64_t DiskBoard::rowOffset(int index, uint64_t y) const {
+    return HEADER_BYTES + index * header->planeBytes + y * header->wordsPerRow * sizeof(uint64_t);
+}
+
+int DiskBoard::getWidth() const {
+    return header ? header->width : 0;
+}
+
+int DiskBoard::getHeight() const {
+    return header ? header->height : 0;
+}
+
+std::string DiskBoard::getRule() const {
+    return header ? std::string(header->rule) : std::string();
+}
+
+void DiskBoard::setBandBytes(uint64_t bytes) {
+    bandBytes = std::max<uint64_t>(bytes, 1);
+    if (header != nullptr) {
+        layoutBands();
+    }
+}
+
+void DiskBoard::layoutBands() {
+    uint64_t rowBytes = header->wordsPerRow * sizeof(uint64_t);
+    bandRows = static_cast<int>(std::min<uint64_t>(std::max<uint64_t>(bandBytes / rowBytes, 1), header->height));
+    bandCount = (header->height + bandRows - 1) / bandRows;
+    for (std::vector<uint64_t>& output : outputs) {
+        output.assign(static_cast<size_t>(bandRows) * header->wordsPerRow, 0);
+    }
+    stats.bandRows = bandRows;
+}
+
+// Open or create the file and map all of it; bytes is the size of a created file
+bool DiskBoard::mapFile(const std::string& filePath, uint64_t bytes, bool create, std::string& error) {
+    fd = ::open(filePath.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (fd < 0) {
+        error = "Cannot open " + filePath + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat status;
+    if (create ? ftruncate(fd, static_cast<off_t>(bytes)) != 0 : fstat(fd, &status) != 0) {
+        error = "Cannot size " + filePath + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    if (!create) {
+        bytes = static_cast<uint64_t>(status.st_size);
+        if (bytes < HEADER_BYTES) {
+            error = filePath + " is not a board file";
+            close();
+            return false;
+        }
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        error = "Cannot map " + filePath + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    madvise(mapped, bytes, MADV_SEQUENTIAL);
+    path = filePath;
+    mapping = static_cast<uint8_t*>(mapped);
+    mappingBytes = bytes;
+    header = reinterpret_cast<Header*>(mapping);
+    return true;
+}
+
+// Write all of bytes at offset, whatever pwrite manages per call
+bool writeAt(int fd, const void* data, uint64_t bytes, uint64_t offset) {
+    const uint8_t* next = static_cast<const uint8_t*>(data);
+    while (bytes > 0) {
+        ssize_t written = pwrite(fd, next, bytes, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        next += written;
+        offset += static_cast<uint64_t>(written);
+        bytes -= static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+// Size and map a new file for a width x height board under the parsed rule, with the
+// header filled in but not yet on disk
+bool DiskBoard::createFile(const std::string& filePath, int width, int height, uint64_t generation, std::string& error) {
+    uint64_t wordsPerRow = (static_cast<uint64_t>(width) + 63) / 64;
+    uint64_t planeBytes = (height * wordsPerRow * sizeof(uint64_t) + HEADER_BYTES - 1) / HEADER_BYTES * HEADER_BYTES;
+    if (!mapFile(filePath, HEADER_BYTES + 2 * planeBytes, true, error)) {
+        return false;
+    }
+    *header = Header();
+    std::memcpy(header->magic, "GOLDISK", 8);
+    header->version = DISK_BOARD_VERSION;
+    header->width = width;
+    header->height = height;
+    header->wordsPerRow = wordsPerRow;
+    header->planeBytes = planeBytes;
+    header->generation = generation;
+    std::snprintf(header->rule, sizeof(header->rule), "%s", formatRule(birthMask, survivalMask).c_str());
+    layoutBands();
+    return true;
+}
+
+bool DiskBoard::create(const std::string& filePath, const Pattern& board, uint64_t generation, std::string& error) {
+    close();
+    std::string rule = board.rule.empty() ? "B3/S23" : board.rule;
+    if (board.width < 1 || board.height < 1 || !parseRule(rule, birthMask, survivalMask)) {
+        error = "Cannot make a board file of an empty board or unknown rule";
+        return false;
+    }
+    if (!createFile(filePath, board.width, board.height, generation, error)) {
+        return false;
+    }
+    for (uint64_t word : board.words) {
+        header->population += __builtin_popcountll(word);
+    }
+    if (!writeAt(fd, board.words.data(), board.words.size() * sizeof(uint64_t), rowOffset(0, 0))) {
+        error = "Cannot write " + filePath + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    return finishCreate(error);
+}
+
+// Random rows a band at a time, drawn in the order Universe::randomize draws them
+bool DiskBoard::createRandom(const std::string& filePath, int width, int height, uint64_t seed, const std::string& rule,
+                             std::string& error) {
+    close();
+    if (width < 1 || height < 1 || !parseRule(rule, birthMask, survivalMask)) {
+        error = "Cannot make a board file of an empty board or unknown rule";
+        return false;
+    }
+    if (!createFile(filePath, width, height, 0, error)) {
+        return false;
+    }
+    std::mt19937_64 gen(seed);
+    const uint64_t wordsPerRow = header->wordsPerRow;
+    const uint64_t tailMask = (width & 63) == 0 ? ~0ULL : (1ULL << (width & 63)) - 1;
+    source = 1; // writeBand writes into the plane after the source
+    for (int band = 0; band < bandCount; ++band) {
+        int y0 = band * bandRows;
+        int y1 = std::min(y0 + bandRows, height);
+        for (int y = y0; y < y1; ++y) {
+            uint64_t* row = &outputs[band % OUTPUT_BUFFERS][static_cast<size_t>(y - y0) * wordsPerRow];
+            for (uint64_t w = 0; w < wordsPerRow; ++w) {
+                row[w] = gen();
+            }
+            row[wordsPerRow - 1] &= tailMask;
+            for (uint64_t w = 0; w < wordsPerRow; ++w) {
+                header->population += __builtin_popcountll(row[w]);
+            }
+        }
+        if (!writeBand(band)) {
+            error = "Cannot write " + filePath + ": " + std::strerror(errno);
+            close();
+            return false;
+        }
+    }
+    return finishCreate(error);
+}
+
+bool DiskBoard::finishCreate(std::string& error) {
+    if (fsync(fd) != 0) {
+        error = "Cannot write " + path + ": " + std::strerror(errno);
+        close();
+        return false;
+    }
+    if (!commitHeader(error)) {
+        close();
+        return false;
+    }
+    stats = DiskBoardStats();
+    stats.generation = header->generation;
+    stats.population = header->population;
+    stats.bandRows = bandRows;
+    stats.fileBytes = mappingBytes;
+    startLanes();
+    return true;
+}
+
+bool DiskBoard::open(const std::string& filePath, std::string& error) {
+    close();
+    if (!mapFile(filePath, 0, false, error)) {
+        return false;
+    }
+    bool valid = std::memcmp(header->magic, "GOLDISK", 8) == 0 && header->version == DISK_BOARD_VERSION &&
+                 header->current <= 1 && header->width > 0 && header->height > 0 &&
+                 header->wordsPerRow == (static_cast<uint64_t>(header->width) + 63) / 64 &&
+                 header->planeBytes >= header->height * header->wordsPerRow * sizeof(uint64_t) &&
+                 HEADER_BYTES + 2 * header->planeBytes <= mappingBytes &&
+                 std::memchr(header->rule, 0, sizeof(header->rule)) != nullptr &&
+                 parseRule(header->rule, birthMask, survivalMask);
+    if (!valid) {
+        error = filePath + " is not a board file";
+        close();
+        return false;
+    }
+    layoutBands();
+    stats = DiskBoardStats();
+    stats.generation = header->generation;
+    stats.population = header->population;
+    stats.bandRows = bandRows;
+    stats.fileBytes = mappingBytes;
+    startLanes();
+    return true;
+}
+
+void DiskBoard::close() {
+    stopLanes();
+    if (mapping != nullptr) {
+        munmap(mapping, mappingBytes);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    mapping = nullptr;
+    mappingBytes = 0;
+    header = nullptr;
+    for (std::vector<uint64_t>& output : outputs) {
+        std::vector<uint64_t>().swap(output);
+    }
+}
+
+// The header goes to disk after the plane it names, so the file always names a complete one
+bool DiskBoard::commitHeader(std::string& error) {
+    if (msync(mapping, HEADER_BYTES, MS_SYNC) != 0) {
+        error = "Cannot write " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+// Drop the whole pages of rows [y0, y1) of a plane from this process and the page cache;
+// they are read from the file again if needed
+void DiskBoard::releaseRows(int index, uint64_t y0, uint64_t y1) const {
+    const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t start = (rowOffset(index, y0) + page - 1) / page * page;
+    uint64_t end = rowOffset(index, y1) / page * page;
+    if (end <= start) {
+        return;
+    }
+    madvise(mapping + start, end - start, MADV_DONTNEED);
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(fd, static_cast<off_t>(start), static_cast<off_t>(end - start), POSIX_FADV_DONTNEED);
+#endif
+}
+
+// Fault the band's pages of the source plane in, a read per page
+void DiskBoard::prefetchBand(int band) {
+    const uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t y0 = static_cast<uint64_t>(band) * bandRows;
+    uint64_t y1 = std::min<uint64_t>(y0 + bandRows, header->height);
+    uint64_t start = rowOffset(source, y0) / page * page;
+    uint64_t end = rowOffset(source, y1);
+    madvise(mapping + start, end - start, MADV_WILLNEED);
+    volatile uint8_t sink = 0;
+    for (uint64_t offset = start; offset < end; offset += page) {
+        sink = sink + mapping[offset];
+    }
+}
+
+// Write the band's output buffer into the other plane, push it to disk and release it from
+// the page cache, along with the input band the next band no longer reads
+bool DiskBoard::writeBand(int band) {
+    uint64_t y0 = static_cast<uint64_t>(band) * bandRows;
+    uint64_t y1 = std::min<uint64_t>(y0 + bandRows, header->height);
+    const int target = 1 - source;
+    if (!writeAt(fd, outputs[band % OUTPUT_BUFFERS].data(), (y1 - y0) * header->wordsPerRow * sizeof(uint64_t), rowOffset(target, y0))) {
+        return false;
+    }
+#ifdef __linux__
+    sync_file_range(fd, static_cast<off_t>(rowOffset(target, y0)), static_cast<off_t>(rowOffset(target, y1) - rowOffset(target, y0)),
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+    releaseRows(target, y0, y1);
+    if (band > 0) {
+        releaseRows(source, y0 - bandRows, y0);
+    }
+    if (y1 == static_cast<uint64_t>(header->height)) {
+        releaseRows(source, y0, y1);
+    }
+    return true;
+}
+
+void DiskBoard::startLanes() {
+    stopping = false;
+    for (int lane = 0; lane < LANE_COUNT; ++lane) {
+        lanes[lane].bands.clear();
+        lanes[lane].done = 0;
+        lanes[lane].thread = std::thread(&DiskBoard::runLane, this, lane);
+    }
+}
+
+void DiskBoard::stopLanes() {
+    {
+        std::lock_guard<std::mutex> lock(laneMutex);
+        stopping = true;
+    }
+    laneChanged.notify_all();
+    for (Lane& lane : lanes) {
+        if (lane.thread.joinable()) {
+            lane.thread.join();
+        }
+    }
+}
+
+void DiskBoard::runLane(int lane) {
+    while (true) {
+        int band;
+        {
+            std::unique_lock<std::mutex> lock(laneMutex);
+            laneChanged.wait(lock, [&] { return stopping || !lanes[lane].bands.empty(); });
+            if (lanes[lane].bands.empty()) {
+                return;
+            }
+            band = lanes[lane].bands.front();
+            lanes[lane].bands.pop_front();
+        }
+        bool ok = true;
+        if (lane == 0) {
+            prefetchBand(band);
+        } else {
+            ok = writeBand(band);
+        }
+        {
+            std::lock_guard<std::mutex> lock(laneMutex);
+            if (!ok && laneError.empty()) {
+                laneError = "Cannot write " + path + ": " + std::strerror(errno);
+            }
+            ++lanes[lane].done;
+        }
+        laneChanged.notify_all();
+    }
+}
+
+void DiskBoard::queueBand(int lane, int band) {
+    {
+        std::lock_guard<std::mutex> lock(laneMutex);
+        lanes[lane].bands.push_back(band);
+    }
+    laneChanged.notify_all();
+}
+
+void DiskBoard::waitForBands(int lane, int done) {
+    std::unique_lock<std::mutex> lock(laneMutex);
+    laneChanged.wait(lock, [&] { return lanes[lane].done >= done; });
+}
+
+// One generation from the current plane into the other. Band k is stepped once bands k and
+// k + 1 are read and the buffer of band k - OUTPUT_BUFFERS is written; band k + 2 is then
+// queued for reading, so the read lane keeps a band ahead of the stepping.
+bool DiskBoard::stepGeneration(std::string& error) {
+    using Clock = std::chrono::steady_clock;
+    {
+        std::lock_guard<std::mutex> lock(laneMutex);
+        source = static_cast<int>(header->current);
+        laneError.clear();
+        for (Lane& lane : lanes) {
+            lane.done = 0;
+        }
+    }
+    const int width = header->width;
+    const uint64_t height = static_cast<uint64_t>(header->height);
+    const uint64_t wordsPerRow = header->wordsPerRow;
+    const uint64_t* in = plane(source);
+    uint64_t population = 0;
+    for (int band = 0; band < std::min(bandCount, 2); ++band) {
+        queueBand(0, band);
+    }
+
+    for (int band = 0; band < bandCount; ++band) {
+        auto waitStart = Clock::now();
+        waitForBands(0, std::min(band + 2, bandCount));
+        auto readReady = Clock::now();
+        waitForBands(1, band - OUTPUT_BUFFERS + 1);
+        auto stepStart = Clock::now();
+        stats.readWaitSeconds += std::chrono::duration<double>(readReady - waitStart).count();
+        stats.writeWaitSeconds += std::chrono::duration<double>(stepStart - readReady).count();
+        if (band + 2 < bandCount) {
+            queueBand(0, band + 2);
+        }
+
+        uint64_t y0 = static_cast<uint64_t>(band) * bandRows;
+        uint64_t y1 = std::min<uint64_t>(y0 + bandRows, height);
+        uint64_t* out = outputs[band % OUTPUT_BUFFERS].data();
+        for (uint64_t y = y0; y < y1; ++y) {
+            const uint64_t* row = in + y * wordsPerRow;
+            uint64_t* next = out + (y - y0) * wordsPerRow;
+            stepRow(y > 0 ? row - wordsPerRow : nullptr, row, y + 1 < height ? row + wordsPerRow : nullptr, next, width,
+                    birthMask, survivalMask);
+            for (uint64_t w = 0; w < wordsPerRow; ++w) {
+                population += __builtin_popcountll(next[w]);
+            }
+        }
+        stats.stepSeconds += std::chrono::duration<double>(Clock::now() - stepStart).count();
+        queueBand(1, band);
+    }
+    auto waitStart = Clock::now();
+    waitForBands(1, bandCount);
+    stats.writeWaitSeconds += std::chrono::duration<double>(Clock::now() - waitStart).count();
+    {
+        std::lock_guard<std::mutex> lock(laneMutex);
+        if (!laneError.empty()) {
+            error = laneError;
+            return false;
+        }
+    }
+    if (fsync(fd) != 0) {
+        error = "Cannot write " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    stats.bytesRead += height * wordsPerRow * sizeof(uint64_t);
+    stats.bytesWritten += height * wordsPerRow * sizeof(uint64_t);
+
+    header->current = static_cast<uint32_t>(1 - source);
+    ++header->generation;
+    header->population = population;
+    stats.generation = header->generation;
+    stats.population = population;
+    return commitHeader(error);
+}
+
+bool DiskBoard::step(uint64_t generations, std::string& error) {
+    if (header == nullptr) {
+        error = "No board file is open";
+        return false;
+    }
+    for (uint64_t i = 0; i < generations; ++i) {
+        if (!stepGeneration(error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DiskBoard::read(Pattern& board, std::string& error) const {
+    if (header == nullptr) {
+        error = "No board file is open";
+        return false;
+    }
+    board.width = header->width;
+    board.height = header->height;
+    board.wordsPerRow = static_cast<int>(header->wordsPerRow);
+    board.rule = header->rule;
+    board.cropped = false;
+    const uint64_t* words = plane(static_cast<int>(header->current));
+    board.words.assign(words, words + static_cast<size_t>(header->height) * header->wordsPerRow);
+    return true;
+}
+
+#endif
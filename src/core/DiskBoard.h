@@ -0,0 +1,118 @@
+#ifndef DISK_BOARD_H
+#define DISK_BOARD_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "PatternIO.h"
+
+// A board too large for memory, kept in a memory-mapped file. The file holds a header page
+// and two planes of bit-packed rows in the layout of Universe: the current generation and
+// the one being stepped into. A generation streams through the board in bands of rows, with
+// three bands of the current plane resident at a time. An I/O thread reads the next band
+// ahead, while another writes finished output bands to disk and drops them and the input
+// band no longer needed from memory. Memory use is a few bands, however large the board.
+//
+// The header names the current plane and is rewritten only once a generation is on disk,
+// so a killed run reopens at its last complete generation. POSIX only (mmap);
+// isDiskBoardSupported says whether this build has it.
+struct DiskBoardStats {
+    uint64_t generation = 0;
+    uint64_t population = 0;
+    int bandRows = 0;             // Rows per band
+    uint64_t fileBytes = 0;
+    uint64_t bytesRead = 0;       // By the steps since open or create
+    uint64_t bytesWritten = 0;
+    double stepSeconds = 0.0;     // Stepping bands
+    double readWaitSeconds = 0.0; // Waiting for bands to be read
+    double writeWaitSeconds = 0.0; // Waiting for bands to be written, to keep memory bounded
+};
+
+bool isDiskBoardSupported();
+
+class DiskBoard {
+public:
+    DiskBoard() = default;
+    ~DiskBoard();
+    DiskBoard(const DiskBoard&) = delete;
+    DiskBoard& operator=(const DiskBoard&) = delete;
+
+    // Write a new board file at path, replacing any there: a copy of board, or a random
+    // board generated a band at a time, cell for cell the one Universe::randomize gives
+    bool create(const std::string& path, const Pattern& board, uint64_t generation, std::string& error);
+    bool createRandom(const std::string& path, int width, int height, uint64_t seed, const std::string& rule,
+                      std::string& error);
+    bool open(const std::string& path, std::string& error);
+    void close();
+    bool isOpen() const { return mapping != nullptr; }
+
+    int getWidth() const;
+    int getHeight() const;
+    std::string getRule() const;
+    const DiskBoardStats& getStats() const { return stats; }
+
+    // Bytes of the current plane per band, rounded to whole rows (default 32 MB); three
+    // bands of input and up to three of output are resident while stepping
+    void setBandBytes(uint64_t bytes);
+
+    bool step(uint64_t generations, std::string& error);
+    // The whole board, for boards that do fit in memory
+    bool read(Pattern& board, std::string& error) const;
+
+private:
+    struct Header;
+    bool mapFile(const std::string& path, uint64_t bytes, bool create, std::string& error);
+    bool createFile(const std::string& path, int width, int height, uint64_t generation, std::string& error);
+    bool finishCreate(std::string& error);
+    bool commitHeader(std::string& error);
+    void layoutBands();
+    uint64_t* plane(int index) const;
+    uint64_t rowOffset(int index, uint64_t y) const; // File offset of row y of a plane
+    void releaseRows(int index, uint64_t y0, uint64_t y1) const;
+    bool stepGeneration(std::string& error);
+    void startLanes();
+    void stopLanes();
+    void runLane(int lane);
+    void queueBand(int lane, int band);
+    void waitForBands(int lane, int done);
+    void prefetchBand(int band);
+    bool writeBand(int band);
+
+    std::string path;
+    int fd = -1;
+    uint8_t* mapping = nullptr;
+    uint64_t mappingBytes = 0;
+    Header* header = nullptr;
+    uint16_t birthMask = 0;
+    uint16_t survivalMask = 0;
+    uint64_t bandBytes = 32ULL << 20;
+    int bandRows = 1;
+    int bandCount = 0;
+    DiskBoardStats stats;
+
+    // Input bands are read through the mapping; output bands are stepped into buffers and
+    // written with pwrite, so their pages are never read in only to be overwritten
+    static const int OUTPUT_BUFFERS = 3;
+    std::vector<uint64_t> outputs[OUTPUT_BUFFERS];
+
+    // I/O lanes: 0 reads bands ahead, 1 writes them behind. Each takes band numbers of the
+    // generation in flight, in order, and counts the ones it has finished.
+    static const int LANE_COUNT = 2;
+    struct Lane {
+        std::thread thread;
+        std::deque<int> bands;
+        int done = 0;
+    };
+    Lane lanes[LANE_COUNT];
+    std::mutex laneMutex;
+    std::condition_variable laneChanged;
+    bool stopping = false;
+    std::string laneError; // The first failed write of the generation in flight
+    int source = 0;        // Plane of the generation in flight
+};
+
+#endif // DISK_BOARD_H
@@ -0,0 +1,239 @@
+#include "EngineTuner.h"
+#include "BackgroundIO.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+const uint64_t CALIBRATION_SEED = 1;
+const double MIN_TIMING_MS = 25.0;  // Each engine is stepped for at least this long
+const int SETTLE_GENERATIONS = 64;  // Untimed steps first, past the burst of change of a fresh soup
+const int BLINKER_SPACING = 64;     // Cells between the blinkers of the sparse engine's board
+
+// Boards the engines are timed on
+enum CalibrationBoard {
+    BOARD_SOUP,     // Random, half the cells alive
+    BOARD_EMPTY,
+    BOARD_BLINKERS  // A lattice of lone blinkers, under 0.1% alive, each flipping every generation
+};
+
+std::string getCpuModel() {
+    std::string model;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int brand[12];
+    if (__get_cpuid(0x80000000, &brand[0], &brand[1], &brand[2], &brand[3]) && brand[0] >= 0x80000004) {
+        for (unsigned int leaf = 0; leaf < 3; ++leaf) {
+            __get_cpuid(0x80000002 + leaf, &brand[leaf * 4], &brand[leaf * 4 + 1], &brand[leaf * 4 + 2], &brand[leaf * 4 + 3]);
+        }
+        model.assign(reinterpret_cast<const char*>(brand), strnlen(reinterpret_cast<const char*>(brand), sizeof(brand)));
+    }
+#endif
+    if (model.empty()) {
+        // Other architectures: the kernel's description, where there is one
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") == 0 || line.compare(0, 9, "Processor") == 0) {
+                model = line.substr(line.find(':') == std::string::npos ? line.size() : line.find(':') + 1);
+                break;
+            }
+        }
+    }
+    // Trim, and keep tabs out of the calibration file's fields
+    std::replace(model.begin(), model.end(), '\t', ' ');
+    model.erase(0, model.find_first_not_of(' '));
+    model.erase(model.find_last_not_of(' ') + 1);
+    if (model.empty()) {
+        model = "unknown CPU";
+    }
+    return model + " (" + std::to_string(std::max(std::thread::hardware_concurrency(), 1u)) + " threads)";
+}
+
+struct Timing {
+    double generationNs = 0.0;
+    double steppedWords = 0.0; // Per generation
+    uint64_t population = 0;   // At the end
+};
+
+// Step a width x height board with one engine
+Timing timeEngine(StepEngine engine, const EngineCosts& costs, int width, int height, CalibrationBoard board) {
+    Universe universe(width, height);
+    universe.setStepEngine(engine);
+    universe.setEngineCosts(costs);
+    if (board == BOARD_SOUP) {
+        universe.randomize(CALIBRATION_SEED);
+    } else if (board == BOARD_BLINKERS) {
+        for (int y = 1; y + 1 < height; y += BLINKER_SPACING) {
+            for (int x = 1; x + 2 < width; x += BLINKER_SPACING) {
+                universe.paintCells(x, y, 1, true);
+                universe.paintCells(x + 1, y, 1, true);
+                universe.paintCells(x + 2, y, 1, true);
+            }
+        }
+    }
+    universe.step(SETTLE_GENERATIONS);
+
+    Timing timing;
+    uint64_t generations = 0;
+    uint64_t stepped = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    while (elapsed < MIN_TIMING_MS * 1e6) {
+        for (int i = 0; i < 16; ++i) {
+            universe.step();
+            stepped += universe.getStats().lastSteppedWords;
+        }
+        generations += 16;
+        elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    timing.generationNs = elapsed / generations;
+    timing.steppedWords = static_cast<double>(stepped) / generations;
+    timing.population = universe.getStats().population;
+    return timing;
+}
+
+EngineCosts calibrateEngines() {
+    EngineCosts costs;
+    const int size = 512;
+    const double words = size * (size / 64.0);
+    costs.denseWord = timeEngine(ENGINE_DENSE, costs, size, size, BOARD_SOUP).generationNs / words;
+
+    // The active engine on a soup steps nearly every word; on an empty board it only looks
+    Timing emptyBoard = timeEngine(ENGINE_ACTIVE, costs, size, size, BOARD_EMPTY);
+    Timing soup = timeEngine(ENGINE_ACTIVE, costs, size, size, BOARD_SOUP);
+    costs.activeGeneration = emptyBoard.generationNs;
+    costs.activeWord = std::max(soup.generationNs - emptyBoard.generationNs, 0.0) / std::max(soup.steppedWords, 1.0);
+
+    // The sparse engine's cost grows with the population, which the blinkers keep constant;
+    // they are spread out, as on the boards it is for, so finding them costs its share
+    const int sparseSize = 1024;
+    Timing sparseEmpty = timeEngine(ENGINE_SPARSE, costs, sparseSize, sparseSize, BOARD_EMPTY);
+    Timing sparseBlinkers = timeEngine(ENGINE_SPARSE, costs, sparseSize, sparseSize, BOARD_BLINKERS);
+    costs.sparseGeneration = sparseEmpty.generationNs;
+    costs.sparseCell = std::max(sparseBlinkers.generationNs - sparseEmpty.generationNs, 0.0) / std::max<double>(sparseBlinkers.population, 1.0);
+
+    // Thread counts up to the hardware's, each on a large board for the per-word cost and a
+    // small one for the cost of handing out a generation
+    int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    double bestLarge = 0.0;
+    for (int threads = 2; threads <= hardwareThreads; threads *= 2) {
+        EngineCosts trial = costs;
+        trial.threads = threads;
+        const int largeSize = 1024;
+        double largeWords = largeSize * (largeSize / 64.0);
+        double large = timeEngine(ENGINE_THREADED, trial, largeSize, largeSize, BOARD_SOUP).generationNs;
+        double small = timeEngine(ENGINE_THREADED, trial, 64, 64, BOARD_SOUP).generationNs;
+        if (costs.threads == 1 || large < bestLarge) {
+            bestLarge = large;
+            costs.threads = threads;
+            costs.threadedWord = large / largeWords;
+            costs.threadedGeneration = std::max(small - 64 * costs.threadedWord, 0.0);
+        }
+    }
+    return costs;
+}
+
+// One line per CPU: the model, then the costs in the order of EngineCosts, tab separated.
+// Lines of other lengths, such as those from before an engine was added, are measured again.
+bool parseCosts(const std::string& line, std::string& cpu, EngineCosts& costs) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, '\t')) {
+        fields.push_back(field);
+    }
+    if (fields.size() != 9) {
+        return false;
+    }
+    cpu = fields[0];
+    costs.denseWord = std::strtod(fields[1].c_str(), nullptr);
+    costs.threads = std::max(std::atoi(fields[2].c_str()), 1);
+    costs.threadedWord = std::strtod(fields[3].c_str(), nullptr);
+    costs.threadedGeneration = std::strtod(fields[4].c_str(), nullptr);
+    costs.activeWord = std::strtod(fields[5].c_str(), nullptr);
+    costs.activeGeneration = std::strtod(fields[6].c_str(), nullptr);
+    costs.sparseCell = std::strtod(fields[7].c_str(), nullptr);
+    costs.sparseGeneration = std::strtod(fields[8].c_str(), nullptr);
+    return costs.denseWord > 0.0 && costs.activeWord >= 0.0 && costs.sparseCell >= 0.0;
+}
+
+std::string formatCosts(const std::string& cpu, const EngineCosts& costs) {
+    char numbers[256];
+    std::snprintf(numbers, sizeof(numbers), "\t%.4f\t%d\t%.4f\t%.1f\t%.4f\t%.1f\t%.4f\t%.1f", costs.denseWord, costs.threads,
+                  costs.threadedWord, costs.threadedGeneration, costs.activeWord, costs.activeGeneration,
+                  costs.sparseCell, costs.sparseGeneration);
+    return cpu + numbers;
+}
+
+std::string getEngineCalibrationPath() {
+#ifdef _WIN32
+    const char* local = std::getenv("LOCALAPPDATA");
+    std::string cache = local != nullptr && *local != '\0' ? std::string(local) : "";
+#else
+    // Relative values are invalid under the XDG spec and are ignored
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    std::string cache = xdg != nullptr && xdg[0] == '/' ? std::string(xdg)
+                        : home != nullptr && *home != '\0' ? std::string(home) + "/.cache"
+                                                          : "";
+#endif
+    if (cache.empty()) {
+        return ENGINE_CALIBRATION_FILE;
+    }
+    return (std::filesystem::path(cache) / "gol" / ENGINE_CALIBRATION_FILE).string();
+}
+
+EngineCosts loadEngineCosts(const std::string& path, bool recalibrate, std::string& message) {
+    std::string cpu = getCpuModel();
+    std::vector<std::string> lines; // Other CPUs' lines, kept when this one's is rewritten
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string lineCpu;
+        EngineCosts costs;
+        if (line.empty() || line[0] == '#' || !parseCosts(line, lineCpu, costs)) {
+            continue;
+        }
+        if (lineCpu != cpu) {
+            lines.push_back(line);
+        } else if (!recalibrate) {
+            message = "Engine costs for " + cpu + " read from " + path;
+            return costs;
+        }
+    }
+    file.close();
+
+    EngineCosts costs = calibrateEngines();
+    lines.push_back(formatCosts(cpu, costs));
+    std::error_code directoryError;
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (!directory.empty()) {
+        std::filesystem::create_directories(directory, directoryError); // A failure shows up as the write's
+    }
+    std::string error;
+    bool saved = writeFileAtomically(path, [&](const std::string& tempPath, std::string& writeError) {
+        std::ofstream out(tempPath);
+        out << "# Step engine costs in ns: CPU, dense per word, threads, threaded per word, threaded per generation, "
+               "active per word, active per generation, sparse per live cell, sparse per generation\n";
+        for (const std::string& entry : lines) {
+            out << entry << '\n';
+        }
+        out.close();
+        if (!out) {
+            writeError = "Cannot write " + tempPath;
+            return false;
+        }
+        return true;
+    }, error);
+    message = "Calibrated the engines for " + cpu + (saved ? ", saved to " + path : ", but " + error);
+    return costs;
+}
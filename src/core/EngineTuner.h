@@ -0,0 +1,27 @@
+#ifndef ENGINE_TUNER_H
+#define ENGINE_TUNER_H
+
+#include <string>
+#include "Universe.h"
+
+// Calibration of the step engines (Universe.h). Each engine is timed on scratch boards,
+// the timings are turned into the per-word and per-generation costs Universe::step predicts
+// with, and the costs are kept in a file, one line per CPU, so a machine is measured once.
+const char ENGINE_CALIBRATION_FILE[] = "engine-calibration.txt";
+
+// Where the calibration file lives: gol/ under $XDG_CACHE_HOME, or under ~/.cache when that
+// is unset (%LOCALAPPDATA% on Windows); the working directory if there is no home either
+std::string getEngineCalibrationPath();
+
+// CPU brand string and hardware thread count, e.g. "AMD Ryzen 7 5800X 8-Core Processor (16 threads)"
+std::string getCpuModel();
+
+// Time the engines on this machine on scratch universes; takes about half a second
+EngineCosts calibrateEngines();
+
+// The costs stored for this CPU in the calibration file. If there are none, or recalibrate
+// is set, calibrate and store them first, making the file's directory if need be. message
+// says which happened.
+EngineCosts loadEngineCosts(const std::string& path, bool recalibrate, std::string& message);
+
+#endif // ENGINE_TUNER_H
@@ -0,0 +1,274 @@
+#include "FrameRecorder.h"
+#include "ImageExport.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A copy of one recorded generation, waiting to be encoded
+struct FrameJob {
+    uint64_t index = 0;
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> words;
+};
+
+RecordingSettings recordingSettings;
+int recordingWidth = 0;   // Board size the frames are rendered at
+int recordingHeight = 0;
+int frameWidth = 0;       // Output size in pixels
+int frameHeight = 0;
+
+std::mutex recorderMutex;
+std::condition_variable jobAvailable;
+std::condition_variable spaceAvailable;
+std::deque<FrameJob> jobQueue;
+std::vector<std::thread> encoderThreads;
+std::atomic<bool> recording{false}; // Written under recorderMutex, read without it on the fast path
+uint64_t nextFrameIndex = 0;
+std::string recordingError;
+
+// Stream formats must be written in order, whichever encoder finishes first
+std::mutex writeMutex;
+std::FILE* streamFile = nullptr;
+std::map<uint64_t, std::vector<uint8_t>> encodedFrames;
+uint64_t nextFrameToWrite = 0;
+std::atomic<uint64_t> framesWritten{0};
+
+void setRecordingError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(recorderMutex);
+    if (recordingError.empty()) {
+        recordingError = message;
+    }
+}
+
+// Render a frame to 8-bit grey: live cells white, scaled up by repeating cells or down by
+// averaging blocks of cells
+std::vector<uint8_t> renderGreyFrame(const FrameJob& job) {
+    std::vector<uint8_t> pixels(static_cast<size_t>(frameWidth) * frameHeight, 0);
+    const int block = recordingSettings.cellsPerPixel;
+    const int scale = recordingSettings.cellPixels;
+    const int blockArea = block * block;
+
+    for (int py = 0; py < frameHeight; ++py) {
+        uint8_t* out = &pixels[static_cast<size_t>(py) * frameWidth];
+        int cellY = py / scale * block;
+
+        for (int px = 0; px < frameWidth; ++px) {
+            int cellX = px / scale * block;
+            int live = 0;
+            for (int y = cellY; y < cellY + block && y < job.height; ++y) {
+                const uint64_t* row = &job.words[static_cast<size_t>(y) * job.wordsPerRow];
+                for (int x = cellX; x < cellX + block && x < job.width; ++x) {
+                    live += (row[x >> 6] >> (x & 63)) & 1;
+                }
+            }
+            out[px] = static_cast<uint8_t>(live * 255 / blockArea);
+        }
+    }
+    return pixels;
+}
+
+// Binary PBM: rows of packed bits, most significant bit first, 1 is black. Live cells are
+// drawn black, and a downscaled pixel is black when at least half its block is alive.
+std::vector<uint8_t> encodePbm(const std::vector<uint8_t>& grey) {
+    char header[64];
+    int headerLength = std::snprintf(header, sizeof(header), "P4\n%d %d\n", frameWidth, frameHeight);
+    size_t rowBytes = (frameWidth + 7) / 8;
+
+    std::vector<uint8_t> bytes(header, header + headerLength);
+    bytes.resize(headerLength + rowBytes * frameHeight, 0);
+    for (int y = 0; y < frameHeight; ++y) {
+        uint8_t* out = &bytes[headerLength + rowBytes * y];
+        for (int x = 0; x < frameWidth; ++x) {
+            if (grey[static_cast<size_t>(y) * frameWidth + x] >= 128) {
+                out[x >> 3] |= static_cast<uint8_t>(0x80 >> (x & 7));
+            }
+        }
+    }
+    return bytes;
+}
+
+// The same frame packed as board words, least significant bit first, for the image writer
+std::vector<uint64_t> packFrame(const std::vector<uint8_t>& grey, int& wordsPerRow) {
+    wordsPerRow = (frameWidth + 63) / 64;
+    std::vector<uint64_t> words(static_cast<size_t>(wordsPerRow) * frameHeight, 0);
+    for (int y = 0; y < frameHeight; ++y) {
+        uint64_t* row = &words[static_cast<size_t>(y) * wordsPerRow];
+        for (int x = 0; x < frameWidth; ++x) {
+            if (grey[static_cast<size_t>(y) * frameWidth + x] >= 128) {
+                row[x >> 6] |= uint64_t(1) << (x & 63);
+            }
+        }
+    }
+    return words;
+}
+
+// Append finished frames to the stream in order
+void writeStreamFrame(uint64_t index, std::vector<uint8_t> bytes) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    encodedFrames[index] = std::move(bytes);
+
+    for (auto it = encodedFrames.find(nextFrameToWrite); it != encodedFrames.end(); it = encodedFrames.find(nextFrameToWrite)) {
+        if (recordingSettings.format == RECORD_Y4M) {
+            std::fputs("FRAME\n", streamFile);
+        }
+        if (std::fwrite(it->second.data(), 1, it->second.size(), streamFile) != it->second.size()) {
+            setRecordingError("Failed to write to " + recordingSettings.path);
+        }
+        encodedFrames.erase(it);
+        ++nextFrameToWrite;
+        ++framesWritten;
+    }
+}
+
+// prefix_000012.pbm
+std::string framePath(uint64_t index, const char* extension) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "_%06llu.%s", static_cast<unsigned long long>(index), extension);
+    return recordingSettings.path + name;
+}
+
+void writeFrameFile(uint64_t index, const std::vector<uint8_t>& bytes) {
+    std::string path = framePath(index, "pbm");
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr || std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size()) {
+        setRecordingError("Failed to write " + path);
+    }
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+    ++framesWritten;
+}
+
+void encoderLoop() {
+    while (true) {
+        FrameJob job;
+        {
+            std::unique_lock<std::mutex> lock(recorderMutex);
+            jobAvailable.wait(lock, [] { return !jobQueue.empty() || !recording; });
+            if (jobQueue.empty()) {
+                return; // Stopped and drained
+            }
+            job = std::move(jobQueue.front());
+            jobQueue.pop_front();
+        }
+        spaceAvailable.notify_one();
+
+        std::vector<uint8_t> grey = renderGreyFrame(job);
+        if (recordingSettings.format == RECORD_PBM_FRAMES) {
+            writeFrameFile(job.index, encodePbm(grey));
+        } else if (recordingSettings.format == RECORD_PNG_FRAMES) {
+            int wordsPerRow;
+            std::vector<uint64_t> words = packFrame(grey, wordsPerRow);
+            std::string error;
+            if (!exportImage(framePath(job.index, "png"), IMAGE_PNG, words.data(), wordsPerRow, frameWidth, frameHeight, 1, error)) {
+                setRecordingError(error);
+            }
+            ++framesWritten;
+        } else {
+            writeStreamFrame(job.index, std::move(grey));
+        }
+    }
+}
+
+bool startRecording(const RecordingSettings& settings, int width, int height, std::string& error) {
+    stopRecording();
+
+    // The simulation thread reads the settings under the lock once recording is on
+    std::lock_guard<std::mutex> lock(recorderMutex);
+    recordingSettings = settings;
+    recordingSettings.every = std::max(recordingSettings.every, 1);
+    recordingSettings.cellPixels = std::max(recordingSettings.cellPixels, 1);
+    recordingSettings.cellsPerPixel = std::max(recordingSettings.cellsPerPixel, 1);
+    recordingSettings.threads = std::max(recordingSettings.threads, 1);
+    recordingSettings.queueDepth = std::max(recordingSettings.queueDepth, 1);
+    recordingWidth = width;
+    recordingHeight = height;
+    frameWidth = std::max((width + recordingSettings.cellsPerPixel - 1) / recordingSettings.cellsPerPixel, 1) * recordingSettings.cellPixels;
+    frameHeight = std::max((height + recordingSettings.cellsPerPixel - 1) / recordingSettings.cellsPerPixel, 1) * recordingSettings.cellPixels;
+
+    if (recordingSettings.format != RECORD_PBM_FRAMES && recordingSettings.format != RECORD_PNG_FRAMES) {
+        streamFile = std::fopen(recordingSettings.path.c_str(), "wb");
+        if (streamFile == nullptr) {
+            error = "Failed to open " + recordingSettings.path;
+            return false;
+        }
+        if (recordingSettings.format == RECORD_Y4M) {
+            std::fprintf(streamFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 Cmono\n", frameWidth, frameHeight, recordingSettings.frameRate);
+        }
+    }
+
+    nextFrameIndex = 0;
+    nextFrameToWrite = 0;
+    framesWritten = 0;
+    recordingError.clear();
+    recording = true;
+    for (int i = 0; i < recordingSettings.threads; ++i) {
+        encoderThreads.emplace_back(encoderLoop);
+    }
+    return true;
+}
+
+void stopRecording() {
+    {
+        std::lock_guard<std::mutex> lock(recorderMutex);
+        recording = false;
+    }
+    jobAvailable.notify_all();
+    spaceAvailable.notify_all();
+
+    for (auto& thread : encoderThreads) {
+        thread.join();
+    }
+    encoderThreads.clear();
+
+    if (streamFile != nullptr) {
+        std::fclose(streamFile);
+        streamFile = nullptr;
+    }
+}
+
+void recordGeneration(const uint64_t* words, int wordsPerRow, int width, int height, uint64_t generation) {
+    if (!recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(recorderMutex);
+    if (!recording || generation % recordingSettings.every != 0) {
+        return;
+    }
+
+    // Hold the simulation back rather than drop frames when the encoders fall behind
+    spaceAvailable.wait(lock, [] { return jobQueue.size() < static_cast<size_t>(recordingSettings.queueDepth) || !recording; });
+    if (!recording) {
+        return;
+    }
+
+    FrameJob job;
+    job.index = nextFrameIndex++;
+    job.width = std::min(width, recordingWidth);
+    job.height = std::min(height, recordingHeight);
+    job.wordsPerRow = wordsPerRow;
+    job.words.assign(words, words + static_cast<size_t>(wordsPerRow) * job.height);
+    jobQueue.push_back(std::move(job));
+    lock.unlock();
+    jobAvailable.notify_one();
+}
+
+RecordingStatus getRecordingStatus() {
+    std::lock_guard<std::mutex> lock(recorderMutex);
+    RecordingStatus status;
+    status.recording = recording;
+    status.framesQueued = nextFrameIndex;
+    status.framesWritten = framesWritten;
+    status.error = recordingError;
+    return status;
+}
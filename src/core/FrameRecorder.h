@@ -0,0 +1,47 @@
+#ifndef FRAME_RECORDER_H
+#define FRAME_RECORDER_H
+
+#include <string>
+#include <cstdint>
+
+// Output formats for recorded runs
+enum RecordingFormat {
+    RECORD_Y4M,        // One YUV4MPEG2 stream in the mono colour space, playable by ffmpeg
+    RECORD_RAW,        // Headerless 8-bit grey frames, back to back
+    RECORD_PBM_FRAMES, // One numbered binary PBM file per frame
+    RECORD_PNG_FRAMES  // One numbered 1-bit PNG file per frame, written by ImageExport
+};
+
+struct RecordingSettings {
+    std::string path = "recording"; // Stream file, or the file name prefix for numbered frames
+    RecordingFormat format = RECORD_Y4M;
+    int every = 1;            // Record every Nth generation
+    int cellPixels = 1;       // Pixels per cell side when scaling up
+    int cellsPerPixel = 1;    // Cells per pixel side when scaling down, shown as density
+    int frameRate = 30;       // Frame rate written into the Y4M header
+    int threads = 2;          // Encoder threads
+    int queueDepth = 8;       // Frames waiting to be encoded before the simulation is held back
+};
+
+struct RecordingStatus {
+    bool recording = false;
+    uint64_t framesQueued = 0;
+    uint64_t framesWritten = 0;
+    std::string error;
+};
+
+// Start recording a board of the given size; frames of a differently sized board are
+// cropped or padded. Returns false and fills error if the output cannot be opened.
+bool startRecording(const RecordingSettings& settings, int width, int height, std::string& error);
+
+// Finish encoding the queued frames and close the output
+void stopRecording();
+
+// Called by the simulation thread after every generation. Copies the board into the queue
+// if this generation is due; blocks only while the queue is full, so encoding and file
+// writes happen on the recorder's threads.
+void recordGeneration(const uint64_t* words, int wordsPerRow, int width, int height, uint64_t generation);
+
+RecordingStatus getRecordingStatus();
+
+#endif // FRAME_RECORDER_H
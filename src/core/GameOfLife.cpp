@@ -0,0 +1,198 @@
+#include "GameOfLife.h"
+#include "PopulationPyramid.h"
+#include "RegionEdit.h"
+#include "PatternIO.h"
+#include "BinarySnapshot.h"
+#include <random>
+#include <fstream>
+
+Universe& getUniverse() {
+    static Universe universe(GRID_WIDTH, GRID_HEIGHT);
+    return universe;
+}
+
+uint64_t randomSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
+// Initialize the grid with random values; the same seed gives the same board
+void initializeGrid(uint64_t seed) {
+    getUniverse().randomize(seed);
+}
+
+bool getBoardSeed(uint64_t& seed) {
+    return getUniverse().getSeed(seed);
+}
+
+void toggleCell(int x, int y) {
+    if (x >= 0 && x < getGridWidth() && y >= 0 && y < getGridHeight()) {
+        setCellState(x, y, !getCellState(x, y));
+    }
+}
+
+bool setRule(const std::string& rule) {
+    return getUniverse().setRule(rule);
+}
+
+std::string getRule() {
+    return getUniverse().getRule();
+}
+
+void setAuxChannelsEnabled(bool enabled) {
+    getUniverse().setAuxChannelsEnabled(enabled);
+}
+
+bool getAuxChannelsEnabled() {
+    return getUniverse().getAuxChannelsEnabled();
+}
+
+const std::vector<uint8_t>& getAuxChannel(AuxChannel channel) {
+    return getUniverse().getAuxChannel(channel);
+}
+
+// Update the grid based on Game of Life rules
+void updateGrid() {
+    getUniverse().step();
+}
+
+void setStepEngine(StepEngine engine) {
+    getUniverse().setStepEngine(engine);
+}
+
+StepEngine getStepEngine() {
+    return getUniverse().getStepEngine();
+}
+
+void setEngineCosts(const EngineCosts& costs) {
+    getUniverse().setEngineCosts(costs);
+}
+
+const EngineCosts& getEngineCosts() {
+    return getUniverse().getEngineCosts();
+}
+
+StepEngine getLastStepEngine() {
+    return getUniverse().getStats().lastEngine;
+}
+
+uint64_t getLastSteppedWords() {
+    return getUniverse().getStats().lastSteppedWords;
+}
+
+GridPlacement getGridPlacement() {
+    return getUniverse().getPlacement();
+}
+
+// True if the last updateGrid changed at least one cell
+bool gridChangedLastUpdate() {
+    return !getUniverse().getChangedTiles().empty();
+}
+
+void clearGrid() {
+    getUniverse().clear();
+}
+
+bool getCellState(int x, int y) {
+    return getUniverse().getCell(x, y); // False for out-of-bounds
+}
+
+void setCellState(int x, int y, bool state) {
+    getUniverse().setCell(x, y, state);
+}
+
+void paintCells(int x, int y, int size, bool state) {
+    getUniverse().paintCells(x, y, size, state);
+}
+
+Pattern copyRegion(int x, int y, int width, int height) {
+    return getUniverse().copyRegion(x, y, width, height);
+}
+
+void editRegion(int x, int y, int width, int height, RegionEdit edit, uint64_t seed) {
+    getUniverse().editRegion(x, y, width, height, edit, seed);
+}
+
+void pastePattern(const Pattern& pattern, int x, int y, bool merge) {
+    getUniverse().pastePattern(pattern, x, y, merge);
+}
+
+// Count the live cells in the half-open rectangle [x0, x1) x [y0, y1), clipped to the grid
+uint64_t countLiveCells(int x0, int y0, int x1, int y1) {
+    return getUniverse().countLiveCells(x0, y0, x1, y1);
+}
+
+bool isRegionEmpty(int x0, int y0, int x1, int y1) {
+    return getUniverse().isRegionEmpty(x0, y0, x1, y1);
+}
+
+void setGrid(int width, int height, std::vector<uint64_t> words) {
+    getUniverse().setBoard(width, height, std::move(words));
+}
+
+const PopulationPyramid& getPyramid() {
+    return getUniverse().getPyramid();
+}
+
+const GridBuffer& getGrid() {
+    return getUniverse().getWords();
+}
+
+int getWordsPerRow() {
+    return getUniverse().getWordsPerRow();
+}
+
+int getGridWidth() {
+    return getUniverse().getWidth();
+}
+
+int getGridHeight() {
+    return getUniverse().getHeight();
+}
+
+
+    // Function to save the current state of the grid to a file
+    bool saveGrid(const std::string& path, std::string& error) {
+        return writePattern(path, getGrid().data(), getWordsPerRow(), getGridWidth(), getGridHeight(), getRule(), error);
+    }
+
+    bool placePattern(Pattern& pattern, std::string& error) {
+        return getUniverse().placePattern(pattern, error);
+    }
+
+    bool placePatternAt(const Pattern& pattern, int x, int y, std::string& error) {
+        return getUniverse().placePatternAt(pattern, x, y, error);
+    }
+
+    bool replaceBoard(Pattern& pattern, std::string& error) {
+        return getUniverse().replaceBoard(pattern, error);
+    }
+
+    Pattern copyBoard() {
+        return getUniverse().copyBoard();
+    }
+
+    bool loadPattern(const std::string& path, std::string& error) {
+        Pattern pattern;
+        return readPattern(path, pattern, error) && placePattern(pattern, error);
+    }
+
+    bool loadGrid(const std::string& path, std::string& error) {
+        // Saves of older versions are only found under their own name
+        bool legacy = path == SAVE_PATH && !std::ifstream(SAVE_PATH) && std::ifstream(LEGACY_SAVE_PATH);
+        return loadPattern(legacy ? LEGACY_SAVE_PATH : path, error);
+    }
+
+    bool saveBinarySnapshot(const std::string& path, uint64_t generation, std::string& error) {
+        return writeBinarySnapshot(path, getGrid().data(), getWordsPerRow(), getGridWidth(), getGridHeight(), getRule(), generation, error);
+    }
+
+    bool loadBinarySnapshot(const std::string& path, uint64_t& generation, std::string& error) {
+        Pattern pattern;
+        uint64_t savedGeneration;
+        if (!readBinarySnapshot(path, pattern, savedGeneration, error) || !replaceBoard(pattern, error)) {
+            return false;
+        }
+        generation = savedGeneration;
+        return true;
+    }
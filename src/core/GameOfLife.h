@@ -0,0 +1,88 @@
+#ifndef GAME_OF_LIFE_H
+#define GAME_OF_LIFE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Universe.h"
+#include "RegionEdit.h"
+
+// The board of a program with one board: a process-wide Universe (Universe.h) and free
+// functions forwarding to it, used by the window, the headless runner and the modules that
+// act on "the" board, such as session logs
+const int GRID_WIDTH = 50;
+const int GRID_HEIGHT = 50;
+const char SAVE_PATH[] = "grid.rle";
+const char LEGACY_SAVE_PATH[] = "grid.txt"; // Two characters per cell, column by column
+
+class PopulationPyramid;
+struct Pattern;
+
+// GRID_WIDTH x GRID_HEIGHT until replaced
+Universe& getUniverse();
+
+// The grid is stored as bit-packed rows: 64 cells per word, cell x of row y is
+// bit (x % 64) of word y * getWordsPerRow() + x / 64
+const GridBuffer& getGrid();
+int getWordsPerRow();
+int getGridWidth();
+int getGridHeight();
+const PopulationPyramid& getPyramid();
+
+// Replace the board with a width x height one holding words in the layout above
+void setGrid(int width, int height, std::vector<uint64_t> words);
+
+// Outer-totalistic rule in B/S notation ("B3/S23"); the S/B form "23/3" is also accepted.
+// setRule returns false and leaves the rule unchanged if it cannot be parsed.
+bool setRule(const std::string& rule);
+std::string getRule();
+
+void setAuxChannelsEnabled(bool enabled);
+bool getAuxChannelsEnabled();
+const std::vector<uint8_t>& getAuxChannel(AuxChannel channel);
+
+void setStepEngine(StepEngine engine); // ENGINE_AUTO by default
+StepEngine getStepEngine();
+void setEngineCosts(const EngineCosts& costs);
+const EngineCosts& getEngineCosts();
+StepEngine getLastStepEngine();  // The engine the last updateGrid ran
+uint64_t getLastSteppedWords();  // Words it stepped
+GridPlacement getGridPlacement(); // Where the board's memory is; slow, see addPlacement
+
+// Functions declarations
+uint64_t randomSeed();
+void initializeGrid(uint64_t seed); // Random board, the same for the same seed
+bool getBoardSeed(uint64_t& seed);  // False once the seeded board was stepped, edited or replaced
+void updateGrid();
+bool gridChangedLastUpdate();
+void toggleCell(int x, int y);
+bool getCellState(int x, int y);
+void setCellState(int x, int y, bool state);
+void paintCells(int x, int y, int size, bool state); // A size x size square with its top-left corner at (x, y)
+// Rectangle edits done a word at a time (RegionEdit.h); the rectangle may reach past the board
+Pattern copyRegion(int x, int y, int width, int height);
+void editRegion(int x, int y, int width, int height, RegionEdit edit, uint64_t seed = 0);
+void pastePattern(const Pattern& pattern, int x, int y, bool merge); // Replaces the cells under it unless merge
+uint64_t countLiveCells(int x0, int y0, int x1, int y1);
+bool isRegionEmpty(int x0, int y0, int x1, int y1);
+void clearGrid();
+// Save to and load from a pattern file in any format readPattern and writePattern take,
+// normally SAVE_PATH; loading SAVE_PATH falls back to the old grid.txt format when there is
+// no RLE save. Return false and fill error on failure.
+bool saveGrid(const std::string& path, std::string& error);
+bool loadGrid(const std::string& path, std::string& error);
+bool loadPattern(const std::string& path, std::string& error); // Any format readPattern takes
+
+// Boards read elsewhere (PatternIO.h), e.g. on an I/O thread. placePattern grows the board to
+// fit and centres the pattern; replaceBoard takes the pattern's size exactly. Both move the
+// words out of the pattern and take on its rule, if it has one.
+bool placePattern(Pattern& pattern, std::string& error);
+bool placePatternAt(const Pattern& pattern, int x, int y, std::string& error); // Top-left corner at (x, y)
+bool replaceBoard(Pattern& pattern, std::string& error);
+Pattern copyBoard(); // The board and rule, for writing out elsewhere
+
+// Binary snapshots (BinarySnapshot.h) restore the board size, rule and generation exactly
+bool saveBinarySnapshot(const std::string& path, uint64_t generation, std::string& error);
+bool loadBinarySnapshot(const std::string& path, uint64_t& generation, std::string& error);
+
+#endif // GAME_OF_LIFE_H
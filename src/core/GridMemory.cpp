@@ -0,0 +1,176 @@
+#include "GridMemory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <vector>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+const size_t HUGE_PAGE_BYTES = 2 << 20;
+const size_t PLACEMENT_SAMPLES = 1024; // Pages looked up per buffer
+
+GridBuffer::GridBuffer(size_t wordCount) : count(wordCount) {
+    if (wordCount == 0) {
+        return;
+    }
+    size_t bytes = wordCount * sizeof(uint64_t);
+#ifndef _WIN32
+    if (bytes >= HUGE_PAGE_BYTES) {
+        // Map a huge page more than needed and unmap the ends, leaving an aligned mapping
+        size_t alignedBytes = (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+        void* mapped = mmap(nullptr, alignedBytes + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped != MAP_FAILED) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(mapped);
+            uintptr_t aligned = (start + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+            if (aligned > start) {
+                munmap(mapped, aligned - start);
+            }
+            size_t tail = start + alignedBytes + HUGE_PAGE_BYTES - (aligned + alignedBytes);
+            if (tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + alignedBytes), tail);
+            }
+            words = reinterpret_cast<uint64_t*>(aligned);
+            mappedBytes = alignedBytes;
+#ifdef MADV_HUGEPAGE
+            hugePageAdvice = madvise(words, alignedBytes, MADV_HUGEPAGE) == 0;
+#endif
+            return;
+        }
+    }
+#endif
+    // Small boards, and systems without mmap: the heap, zeroed now by this thread
+    words = static_cast<uint64_t*>(std::calloc(wordCount, sizeof(uint64_t)));
+    if (words == nullptr) {
+        throw std::bad_alloc();
+    }
+}
+
+GridBuffer::~GridBuffer() {
+    release();
+}
+
+GridBuffer::GridBuffer(GridBuffer&& other) noexcept {
+    swap(other);
+}
+
+GridBuffer& GridBuffer::operator=(GridBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        swap(other);
+    }
+    return *this;
+}
+
+void GridBuffer::swap(GridBuffer& other) {
+    std::swap(words, other.words);
+    std::swap(count, other.count);
+    std::swap(mappedBytes, other.mappedBytes);
+    std::swap(hugePageAdvice, other.hugePageAdvice);
+}
+
+void GridBuffer::release() {
+#ifndef _WIN32
+    if (mappedBytes != 0) {
+        munmap(words, mappedBytes);
+    } else
+#endif
+    {
+        std::free(words);
+    }
+    words = nullptr;
+    count = 0;
+    mappedBytes = 0;
+    hugePageAdvice = false;
+}
+
+// The kernel's transparent huge page setting, the bracketed word of "always [madvise] never"
+std::string readHugePageMode() {
+    std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    if (!std::getline(in, line)) {
+        return std::string();
+    }
+    size_t open = line.find('[');
+    size_t close = line.find(']', open);
+    return open != std::string::npos && close != std::string::npos ? line.substr(open + 1, close - open - 1) : std::string();
+}
+
+// Bytes of [start, end) in huge pages: the AnonHugePages of the mappings overlapping it
+uint64_t readHugePageBytes(uintptr_t start, uintptr_t end) {
+    std::ifstream in("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    uint64_t total = 0;
+    while (std::getline(in, line)) {
+        unsigned long long from, to;
+        char dash;
+        if (std::sscanf(line.c_str(), "%llx%c%llx", &from, &dash, &to) == 3 && dash == '-') {
+            inside = from < end && to > start;
+        } else if (inside && line.compare(0, 14, "AnonHugePages:") == 0) {
+            total += std::strtoull(line.c_str() + 14, nullptr, 10) * 1024;
+        }
+    }
+    return total;
+}
+
+void addPlacement(const GridBuffer& buffer, GridPlacement& placement) {
+    placement.bytes += buffer.size() * sizeof(uint64_t);
+    if (buffer.hasHugePageAdvice()) {
+        placement.hugePageAdvised += buffer.size() * sizeof(uint64_t);
+    }
+    if (placement.hugePageMode.empty()) {
+        placement.hugePageMode = readHugePageMode();
+    }
+    if (!buffer.isMapped()) {
+        return;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(buffer.data());
+    uintptr_t end = reinterpret_cast<uintptr_t>(buffer.end());
+    placement.hugePageBytes += std::min<uint64_t>(readHugePageBytes(start, end), end - start); // The mapping runs on to 2 MB
+
+#ifdef __linux__
+    // move_pages with no target nodes only reports where each page is; pages never written
+    // are not resident and come back as errors, and are not counted
+    const size_t pageBytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t pages = (end - start + pageBytes - 1) / pageBytes;
+    const size_t samples = std::min(pages, PLACEMENT_SAMPLES);
+    std::vector<void*> addresses(samples);
+    std::vector<int> nodes(samples, -1);
+    for (size_t i = 0; i < samples; ++i) {
+        addresses[i] = reinterpret_cast<void*>(start + (pages * i / samples) * pageBytes);
+    }
+    if (syscall(SYS_move_pages, 0, samples, addresses.data(), nullptr, nodes.data(), 0) != 0) {
+        return; // No NUMA support, or hidden from this process
+    }
+    placement.nodesKnown = true;
+    for (int node : nodes) {
+        if (node >= 0 && node < MAX_PLACEMENT_NODES) {
+            ++placement.nodePages[node];
+            ++placement.sampledPages;
+        }
+    }
+#endif
+}
+
+std::string describePlacement(const GridPlacement& placement) {
+    std::string text = std::to_string(placement.bytes >> 20) + " MB, " + std::to_string(placement.hugePageBytes >> 20) +
+                       " MB in huge pages (THP " + (placement.hugePageMode.empty() ? "unavailable" : placement.hugePageMode) + ")";
+    if (!placement.nodesKnown || placement.sampledPages == 0) {
+        return text + ", nodes unknown";
+    }
+    text += ", nodes";
+    for (int node = 0; node < MAX_PLACEMENT_NODES; ++node) {
+        if (placement.nodePages[node] != 0) {
+            text += " " + std::to_string(node) + ": " + std::to_string(placement.nodePages[node] * 100 / placement.sampledPages) + "%";
+        }
+    }
+    return text;
+}
@@ -0,0 +1,68 @@
+#ifndef GRID_MEMORY_H
+#define GRID_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Word buffers for boards. A buffer of at least one 2 MB huge page is mapped straight from
+// the system, aligned to 2 MB and advised to use transparent huge pages where the kernel has
+// them (it stays in small pages where not). Its pages are left untouched until first
+// written, so each lands on the NUMA node of the thread that writes it first; Universe has
+// the threads that step each band of rows write it first (Engine::placeRows).
+class GridBuffer {
+public:
+    GridBuffer() = default;
+    explicit GridBuffer(size_t wordCount); // All zero
+    ~GridBuffer();
+    GridBuffer(GridBuffer&& other) noexcept;
+    GridBuffer& operator=(GridBuffer&& other) noexcept;
+    GridBuffer(const GridBuffer&) = delete;
+    GridBuffer& operator=(const GridBuffer&) = delete;
+
+    uint64_t* data() { return words; }
+    const uint64_t* data() const { return words; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    uint64_t& operator[](size_t index) { return words[index]; }
+    const uint64_t& operator[](size_t index) const { return words[index]; }
+    uint64_t* begin() { return words; }
+    uint64_t* end() { return words + count; }
+    const uint64_t* begin() const { return words; }
+    const uint64_t* end() const { return words + count; }
+    void swap(GridBuffer& other);
+
+    bool isMapped() const { return mappedBytes != 0; } // Mapped, rather than from the heap
+    bool hasHugePageAdvice() const { return hugePageAdvice; }
+
+private:
+    void release();
+
+    uint64_t* words = nullptr;
+    size_t count = 0;
+    size_t mappedBytes = 0;
+    bool hugePageAdvice = false;
+};
+
+const int MAX_PLACEMENT_NODES = 8;
+
+// Where the pages of some buffers are, as the kernel reports it (Linux; elsewhere, and in
+// containers that hide it, the node counts stay unknown)
+struct GridPlacement {
+    uint64_t bytes = 0;
+    uint64_t hugePageBytes = 0;     // Backed by huge pages
+    uint64_t hugePageAdvised = 0;   // Bytes in buffers advised to use them
+    std::string hugePageMode;       // The kernel's setting: always, madvise or never; empty if none
+    bool nodesKnown = false;
+    uint64_t sampledPages = 0;      // Pages looked up, spread evenly over the buffers
+    uint64_t nodePages[MAX_PLACEMENT_NODES] = {}; // Of those, the ones on each node
+};
+
+// Add a buffer's pages to placement. Costs a read of /proc/self/smaps and a system call,
+// so it suits a status display refreshed now and then, not every generation.
+void addPlacement(const GridBuffer& buffer, GridPlacement& placement);
+
+// One line for status displays: "128 MB, 124 MB in huge pages (THP madvise), nodes 0: 52% 1: 48%"
+std::string describePlacement(const GridPlacement& placement);
+
+#endif // GRID_MEMORY_H
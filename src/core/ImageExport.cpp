@@ -0,0 +1,364 @@
+#include "ImageExport.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const int BAND_ROWS = 64;            // Image rows converted per band, at least one board row
+const size_t IDAT_CHUNK_SIZE = 65536; // Compressed bytes per PNG data chunk
+const int MAX_MATCH = 258;           // Longest deflate match
+
+ImageFormat imageFormatForPath(const std::string& path) {
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".png" ? IMAGE_PNG : IMAGE_PBM;
+}
+
+// Grid words are least significant bit first, image rows most significant bit first, so
+// at one pixel per cell a row converts by reversing the bits of each byte: sixteen bytes at
+// a time with SSE2, the rest through a bit-reversal table
+struct ByteTables {
+    uint8_t reversed[256];
+
+    ByteTables() {
+        for (int i = 0; i < 256; ++i) {
+            uint8_t r = 0;
+            for (int bit = 0; bit < 8; ++bit) {
+                r |= ((i >> bit) & 1) << (7 - bit);
+            }
+            reversed[i] = r;
+        }
+    }
+};
+
+const ByteTables byteTables;
+
+// Pack one board row into image bits, 1 for a live cell, each cell cellPixels wide
+void packRow(const uint64_t* row, int width, int cellPixels, uint8_t* out, size_t rowBytes) {
+    std::fill(out, out + rowBytes, 0);
+
+    if (cellPixels == 1) {
+        size_t cellBytes = (width + 7) / 8;
+        size_t i = 0;
+#ifdef __SSE2__
+        // Swap single bits, then pairs, then nibbles; a byte-wise shift is a 16-bit shift
+        // and a mask
+        const __m128i ones = _mm_set1_epi8(0x55);
+        const __m128i pairs = _mm_set1_epi8(0x33);
+        const __m128i nibbles = _mm_set1_epi8(0x0F);
+        const uint8_t* cellBits = reinterpret_cast<const uint8_t*>(row);
+        for (; i + 16 <= cellBytes; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cellBits + i));
+            bytes = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(bytes, 1), ones), _mm_slli_epi16(_mm_and_si128(bytes, ones), 1));
+            bytes = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(bytes, 2), pairs), _mm_slli_epi16(_mm_and_si128(bytes, pairs), 2));
+            bytes = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(bytes, 4), nibbles), _mm_slli_epi16(_mm_and_si128(bytes, nibbles), 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+        }
+#endif
+        for (; i < cellBytes; ++i) {
+            out[i] = byteTables.reversed[(row[i >> 3] >> ((i & 7) * 8)) & 0xFF];
+        }
+        if (width & 7) {
+            out[cellBytes - 1] &= static_cast<uint8_t>(0xFF00 >> (width & 7));
+        }
+        return;
+    }
+
+    // Scaled up: visit live cells only and fill their run of pixels a byte at a time
+    for (int word = 0; word * 64 < width; ++word) {
+        uint64_t bits = row[word];
+        if (word * 64 + 64 > width) {
+            bits &= (uint64_t(1) << (width - word * 64)) - 1;
+        }
+        while (bits != 0) {
+            int x = word * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            size_t first = static_cast<size_t>(x) * cellPixels;
+            size_t last = first + cellPixels;
+            while (first < last) {
+                int offset = first & 7;
+                int span = static_cast<int>(std::min<size_t>(8 - offset, last - first));
+                out[first >> 3] |= static_cast<uint8_t>(static_cast<uint8_t>(0xFF00 >> span) >> offset);
+                first += span;
+            }
+        }
+    }
+}
+
+// Streaming zlib stream writer: one fixed-Huffman deflate block per band, with runs of a
+// repeated byte coded as distance-one matches. Board images are mostly long runs of empty
+// bytes, which this shrinks close to what a full LZ77 search would, at a fraction of the cost.
+class DeflateWriter {
+public:
+    explicit DeflateWriter(std::vector<uint8_t>& output) : out(output) {
+        out.push_back(0x78); // 32K window, deflate
+        out.push_back(0x01); // Fastest compression level, no dictionary
+        startBlock(false);
+    }
+
+    void write(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            uint8_t byte = data[i];
+            adlerA = (adlerA + byte) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+
+            if (havePrevious && byte == previous) {
+                if (++runLength == MAX_MATCH) {
+                    flushRun();
+                }
+                continue;
+            }
+            flushRun();
+            writeLiteral(byte);
+            previous = byte;
+            havePrevious = true;
+        }
+    }
+
+    // End the current block and start the next, so the output can be drained
+    void endBlock() {
+        flushRun();
+        writeSymbol(256);
+        startBlock(false);
+    }
+
+    void finish() {
+        flushRun();
+        writeSymbol(256);
+        startBlock(true);
+        writeSymbol(256);
+        if (bitCount > 0) {
+            out.push_back(static_cast<uint8_t>(bitBuffer));
+            bitBuffer = 0;
+            bitCount = 0;
+        }
+        uint32_t adler = (adlerB << 16) | adlerA;
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<uint8_t>(adler >> shift));
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint32_t bitBuffer = 0;
+    int bitCount = 0;
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    uint8_t previous = 0;
+    bool havePrevious = false;
+    int runLength = 0; // Repeats of previous not yet written
+
+    void writeBits(uint32_t value, int count) {
+        bitBuffer |= value << bitCount;
+        bitCount += count;
+        while (bitCount >= 8) {
+            out.push_back(static_cast<uint8_t>(bitBuffer));
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    // Huffman codes are sent most significant bit first
+    void writeCode(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        writeBits(reversed, length);
+    }
+
+    // Fixed literal/length code of RFC 1951 section 3.2.6
+    void writeSymbol(int symbol) {
+        if (symbol < 144) {
+            writeCode(0x30 + symbol, 8);
+        } else if (symbol < 256) {
+            writeCode(0x190 + symbol - 144, 9);
+        } else if (symbol < 280) {
+            writeCode(symbol - 256, 7);
+        } else {
+            writeCode(0xC0 + symbol - 280, 8);
+        }
+    }
+
+    void writeLiteral(uint8_t byte) {
+        writeSymbol(byte);
+    }
+
+    void writeMatch(int length) {
+        static const int lengthBase[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                         35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int lengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        int code = 28;
+        while (lengthBase[code] > length) {
+            --code;
+        }
+        writeSymbol(257 + code);
+        writeBits(length - lengthBase[code], lengthExtra[code]);
+        writeCode(0, 5); // Distance code 0: one byte back
+    }
+
+    void flushRun() {
+        if (runLength >= 3) {
+            writeMatch(runLength);
+        } else {
+            for (int i = 0; i < runLength; ++i) {
+                writeLiteral(previous);
+            }
+        }
+        runLength = 0;
+    }
+
+    void startBlock(bool last) {
+        writeBits(last ? 1 : 0, 1);
+        writeBits(1, 2); // Fixed Huffman codes
+    }
+};
+
+struct CrcTable {
+    uint32_t entries[256];
+
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+const CrcTable crcTable;
+
+bool writePngChunk(std::FILE* file, const char* type, const uint8_t* data, size_t length) {
+    uint8_t header[8] = {
+        static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+        static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length),
+        static_cast<uint8_t>(type[0]), static_cast<uint8_t>(type[1]),
+        static_cast<uint8_t>(type[2]), static_cast<uint8_t>(type[3])};
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (int i = 4; i < 8; ++i) {
+        crc = crcTable.entries[(crc ^ header[i]) & 0xFF] ^ (crc >> 8);
+    }
+    for (size_t i = 0; i < length; ++i) {
+        crc = crcTable.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    crc ^= 0xFFFFFFFFu;
+    uint8_t trailer[4] = {static_cast<uint8_t>(crc >> 24), static_cast<uint8_t>(crc >> 16),
+                          static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)};
+
+    return std::fwrite(header, 1, 8, file) == 8 &&
+           (length == 0 || std::fwrite(data, 1, length, file) == length) &&
+           std::fwrite(trailer, 1, 4, file) == 4;
+}
+
+// Write whole IDAT chunks from the front of the compressed buffer, all of it if final
+bool drainIdat(std::FILE* file, std::vector<uint8_t>& compressed, bool final) {
+    size_t offset = 0;
+    while (compressed.size() - offset >= IDAT_CHUNK_SIZE || (final && offset < compressed.size())) {
+        size_t length = std::min(IDAT_CHUNK_SIZE, compressed.size() - offset);
+        if (!writePngChunk(file, "IDAT", compressed.data() + offset, length)) {
+            return false;
+        }
+        offset += length;
+    }
+    compressed.erase(compressed.begin(), compressed.begin() + offset);
+    return true;
+}
+
+bool exportImage(const std::string& path, ImageFormat format, const uint64_t* words, int wordsPerRow,
+                 int width, int height, int cellPixels, std::string& error,
+                 const std::function<void(double)>& onProgress) {
+    cellPixels = std::max(cellPixels, 1);
+    uint64_t imageWidth = static_cast<uint64_t>(width) * cellPixels;
+    uint64_t imageHeight = static_cast<uint64_t>(height) * cellPixels;
+    if (width <= 0 || height <= 0 || imageWidth > 0x7FFFFFFF || imageHeight > 0x7FFFFFFF) {
+        error = "Image size out of range";
+        return false;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    // PNG rows start with a filter type byte; bit value 0 is black there, so rows are inverted
+    const bool png = format == IMAGE_PNG;
+    const size_t rowBytes = (imageWidth + 7) / 8;
+    const size_t lineBytes = rowBytes + (png ? 1 : 0);
+    const uint8_t padMask = static_cast<uint8_t>(0xFF00 >> (imageWidth & 7 ? imageWidth & 7 : 8));
+    const int bandRows = std::max(1, BAND_ROWS / cellPixels); // Board rows per band
+    std::vector<uint8_t> band(lineBytes * std::min(bandRows, height) * cellPixels);
+    std::vector<uint8_t> compressed;
+    DeflateWriter deflate(compressed);
+    bool ok = true;
+
+    if (png) {
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        uint8_t header[13] = {
+            static_cast<uint8_t>(imageWidth >> 24), static_cast<uint8_t>(imageWidth >> 16),
+            static_cast<uint8_t>(imageWidth >> 8), static_cast<uint8_t>(imageWidth),
+            static_cast<uint8_t>(imageHeight >> 24), static_cast<uint8_t>(imageHeight >> 16),
+            static_cast<uint8_t>(imageHeight >> 8), static_cast<uint8_t>(imageHeight),
+            1,  // Bit depth
+            0,  // Greyscale
+            0, 0, 0};
+        ok = std::fwrite(signature, 1, 8, file) == 8 && writePngChunk(file, "IHDR", header, sizeof(header));
+    } else {
+        ok = std::fprintf(file, "P4\n%llu %llu\n", static_cast<unsigned long long>(imageWidth),
+                          static_cast<unsigned long long>(imageHeight)) > 0;
+    }
+
+    for (int bandStart = 0; ok && bandStart < height; bandStart += bandRows) {
+        int bandEnd = std::min(bandStart + bandRows, height);
+        uint8_t* line = band.data();
+
+        for (int y = bandStart; y < bandEnd; ++y) {
+            uint8_t* pixels = line + (png ? 1 : 0);
+            packRow(words + static_cast<size_t>(y) * wordsPerRow, width, cellPixels, pixels, rowBytes);
+            if (png) {
+                line[0] = 0; // No filter
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    pixels[i] = ~pixels[i];
+                }
+                pixels[rowBytes - 1] &= padMask;
+            }
+            for (int repeat = 1; repeat < cellPixels; ++repeat) {
+                std::copy(line, line + lineBytes, line + lineBytes * repeat);
+            }
+            line += lineBytes * cellPixels;
+        }
+
+        size_t bandBytes = line - band.data();
+        if (png) {
+            deflate.write(band.data(), bandBytes);
+            deflate.endBlock();
+            ok = drainIdat(file, compressed, false);
+        } else {
+            ok = std::fwrite(band.data(), 1, bandBytes, file) == bandBytes;
+        }
+        if (onProgress) {
+            onProgress(static_cast<double>(bandEnd) / height);
+        }
+    }
+
+    if (ok && png) {
+        deflate.finish();
+        ok = drainIdat(file, compressed, true) && writePngChunk(file, "IEND", nullptr, 0);
+    }
+
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Failed to write " + path;
+    }
+    return ok;
+}
@@ -0,0 +1,25 @@
+#ifndef IMAGE_EXPORT_H
+#define IMAGE_EXPORT_H
+
+#include <functional>
+#include <string>
+#include <cstdint>
+
+enum ImageFormat {
+    IMAGE_PBM,  // Binary PBM, bit-packed like the grid itself
+    IMAGE_PNG   // 1-bit greyscale PNG
+};
+
+// Pick the format from the file extension, PBM unless it ends in .png
+ImageFormat imageFormatForPath(const std::string& path);
+
+// Write a bit-packed board as an image with live cells black, cellPixels pixels per cell
+// side. The board is walked in bands of rows, so memory stays at one band of output
+// whatever the board size; PNG data is deflated on the fly as the bands are written.
+// onProgress, if given, is called after each band with the fraction of rows written.
+// Returns false and fills error on failure.
+bool exportImage(const std::string& path, ImageFormat format, const uint64_t* words, int wordsPerRow,
+                 int width, int height, int cellPixels, std::string& error,
+                 const std::function<void(double)>& onProgress = nullptr);
+
+#endif // IMAGE_EXPORT_H
@@ -0,0 +1,377 @@
+#include "Macrocell.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+const int LEAF_LEVEL = 3;  // Leaves are 8x8 cells
+const int MAX_LEVEL = 62;  // Node coordinates must fit in 64-bit integers
+const int MAX_SIDE = 1 << 30;
+
+// Quadtree node; id 0 is the empty node of every level
+struct MacroNode {
+    int level;
+    uint32_t children[4]; // nw, ne, sw, se
+    uint64_t leaf;        // Level 3: cell (x, y) is bit y * 8 + x
+};
+
+// Live cell bounding box relative to a node's corner, exclusive at the far edges
+struct MacroBox {
+    int64_t x0, y0, x1, y1;
+};
+
+// Nodes are hash-consed: an identical leaf or quadrant is stored once and shared
+class MacroTree {
+public:
+    std::vector<MacroNode> nodes;
+
+    MacroTree() {
+        nodes.push_back(MacroNode{0, {0, 0, 0, 0}, 0});
+    }
+
+    uint32_t makeLeaf(uint64_t bits) {
+        return bits == 0 ? 0 : intern(MacroNode{LEAF_LEVEL, {0, 0, 0, 0}, bits});
+    }
+
+    uint32_t makeNode(int level, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+        return (nw | ne | sw | se) == 0 ? 0 : intern(MacroNode{level, {nw, ne, sw, se}, 0});
+    }
+
+private:
+    struct Key {
+        uint64_t a, b;
+        bool operator==(const Key& other) const { return a == other.a && b == other.b; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            uint64_t hash = (key.a ^ (key.b * 0x9E3779B97F4A7C15ULL)) * 0xFF51AFD7ED558CCDULL;
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+    };
+    std::unordered_map<Key, uint32_t, KeyHash> index;
+
+    uint32_t intern(const MacroNode& node) {
+        // Children ids already identify the level, so leaves and nodes only need telling apart
+        Key key = node.level == LEAF_LEVEL
+                      ? Key{node.leaf, ~0ULL}
+                      : Key{(static_cast<uint64_t>(node.children[0]) << 32) | node.children[1],
+                            (static_cast<uint64_t>(node.children[2]) << 32) | node.children[3]};
+        auto found = index.find(key);
+        if (found != index.end()) {
+            return found->second;
+        }
+        uint32_t id = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(node);
+        index.emplace(key, id);
+        return id;
+    }
+};
+
+// Parse a leaf line: rows of '.' and '*', each ended by '$'
+bool parseLeaf(const char* line, uint64_t& bits) {
+    bits = 0;
+    int x = 0;
+    int y = 0;
+    for (const char* c = line; *c != '\0' && *c != '\n' && *c != '\r'; ++c) {
+        if (*c == '$') {
+            ++y;
+            x = 0;
+        } else if (*c == '.' || *c == '*') {
+            if (x >= 8 || y >= 8) {
+                return false;
+            }
+            if (*c == '*') {
+                bits |= 1ULL << (y * 8 + x);
+            }
+            ++x;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<MacroBox> computeBoxes(const MacroTree& tree) {
+    const int64_t EMPTY = INT64_MAX;
+    std::vector<MacroBox> boxes(tree.nodes.size(), MacroBox{EMPTY, EMPTY, 0, 0});
+
+    // Children always precede their parents
+    for (size_t id = 1; id < tree.nodes.size(); ++id) {
+        const MacroNode& node = tree.nodes[id];
+        MacroBox& box = boxes[id];
+        if (node.level == LEAF_LEVEL) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if ((node.leaf >> bit) & 1) {
+                    int x = bit & 7, y = bit >> 3;
+                    box = MacroBox{std::min<int64_t>(box.x0, x), std::min<int64_t>(box.y0, y),
+                                   std::max<int64_t>(box.x1, x + 1), std::max<int64_t>(box.y1, y + 1)};
+                }
+            }
+            continue;
+        }
+        int64_t half = int64_t(1) << (node.level - 1);
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            uint32_t child = node.children[quadrant];
+            if (child == 0) {
+                continue;
+            }
+            int64_t dx = (quadrant & 1) ? half : 0;
+            int64_t dy = (quadrant & 2) ? half : 0;
+            const MacroBox& inner = boxes[child];
+            box = MacroBox{std::min(box.x0, inner.x0 + dx), std::min(box.y0, inner.y0 + dy),
+                           std::max(box.x1, inner.x1 + dx), std::max(box.y1, inner.y1 + dy)};
+        }
+    }
+    return boxes;
+}
+
+// OR the cells of a node whose corner is at (x, y), relative to the pattern window, into it
+void flattenNode(const MacroTree& tree, const std::vector<MacroBox>& boxes, uint32_t id, int64_t x, int64_t y, Pattern& pattern) {
+    if (id == 0) {
+        return;
+    }
+    const MacroBox& box = boxes[id];
+    if (x + box.x1 <= 0 || y + box.y1 <= 0 || x + box.x0 >= pattern.width || y + box.y0 >= pattern.height) {
+        return;
+    }
+
+    const MacroNode& node = tree.nodes[id];
+    if (node.level > LEAF_LEVEL) {
+        int64_t half = int64_t(1) << (node.level - 1);
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            flattenNode(tree, boxes, node.children[quadrant], x + ((quadrant & 1) ? half : 0), y + ((quadrant & 2) ? half : 0), pattern);
+        }
+        return;
+    }
+
+    for (int row = 0; row < 8; ++row) {
+        int64_t cellY = y + row;
+        uint64_t bits = (node.leaf >> (row * 8)) & 0xFF;
+        if (bits == 0 || cellY < 0 || cellY >= pattern.height) {
+            continue;
+        }
+        int64_t cellX = x;
+        if (cellX < 0) {
+            bits >>= -cellX;
+            cellX = 0;
+        }
+        if (cellX + 8 > pattern.width) {
+            bits &= (1ULL << (pattern.width - cellX)) - 1;
+        }
+        uint64_t* words = &pattern.words[static_cast<size_t>(cellY) * pattern.wordsPerRow];
+        words[cellX >> 6] |= bits << (cellX & 63);
+        if ((cellX & 63) > 56 && bits >> (64 - (cellX & 63)) != 0) {
+            words[(cellX >> 6) + 1] |= bits >> (64 - (cellX & 63));
+        }
+    }
+}
+
+bool readMacrocell(const std::string& path, Pattern& pattern, std::string& error, uint64_t maxCells) {
+    std::FILE* file = std::fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    MacroTree tree;
+    std::vector<uint32_t> fileNodes(1, 0); // File node numbers, from 1, to tree ids
+    std::vector<int> fileLevels(1, 0);
+    char line[1024];
+    bool ok = true;
+    bool first = true;
+
+    while (ok && std::fgets(line, sizeof(line), file) != nullptr) {
+        if (first) {
+            first = false;
+            if (std::strncmp(line, "[M2]", 4) != 0) {
+                error = path + " is not a Macrocell file";
+                ok = false;
+            }
+            continue;
+        }
+        if (line[0] == '#') {
+            if (line[1] == 'R') {
+                char rule[64] = "";
+                if (std::sscanf(line + 2, "%63s", rule) == 1) {
+                    pattern.rule = rule;
+                }
+            }
+            continue;
+        }
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0') {
+            continue;
+        }
+
+        if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+            uint64_t bits;
+            if (!parseLeaf(line, bits)) {
+                error = "Bad leaf in " + path + ": " + line;
+                ok = false;
+                break;
+            }
+            fileNodes.push_back(tree.makeLeaf(bits));
+            fileLevels.push_back(LEAF_LEVEL);
+            continue;
+        }
+
+        long long level, child[4];
+        if (std::sscanf(line, "%lld %lld %lld %lld %lld", &level, &child[0], &child[1], &child[2], &child[3]) != 5 ||
+            level <= LEAF_LEVEL || level > MAX_LEVEL) {
+            error = "Unsupported node in " + path + ": " + line;
+            ok = false;
+            break;
+        }
+        uint32_t ids[4];
+        for (int quadrant = 0; quadrant < 4 && ok; ++quadrant) {
+            // A child is 0 (empty) or an earlier node one level down
+            if (child[quadrant] < 0 || child[quadrant] >= static_cast<long long>(fileNodes.size()) ||
+                (child[quadrant] != 0 && fileLevels[child[quadrant]] != level - 1)) {
+                error = "Bad child reference in " + path + ": " + line;
+                ok = false;
+            } else {
+                ids[quadrant] = fileNodes[child[quadrant]];
+            }
+        }
+        if (ok) {
+            fileNodes.push_back(tree.makeNode(static_cast<int>(level), ids[0], ids[1], ids[2], ids[3]));
+            fileLevels.push_back(static_cast<int>(level));
+        }
+    }
+    std::fclose(file);
+    if (ok && fileNodes.size() < 2) {
+        error = path + " has no nodes";
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    // The last node is the root; flatten its live bounding box, cropped around the centre
+    uint32_t root = fileNodes.back();
+    std::vector<MacroBox> boxes = computeBoxes(tree);
+    pattern.cropped = false;
+    if (root == 0) {
+        pattern.width = pattern.height = pattern.wordsPerRow = 0;
+        pattern.words.clear();
+        return true;
+    }
+    const MacroBox& box = boxes[root];
+    int64_t width = box.x1 - box.x0;
+    int64_t height = box.y1 - box.y0;
+    int64_t side = std::max<int64_t>(1, static_cast<int64_t>(std::sqrt(static_cast<double>(maxCells))));
+    int64_t croppedWidth = std::min<int64_t>(width, MAX_SIDE);
+    int64_t croppedHeight = std::min<int64_t>(height, MAX_SIDE);
+    if (static_cast<double>(croppedWidth) * croppedHeight > static_cast<double>(maxCells)) {
+        // Keep the short side whole where possible and crop the long one
+        if (croppedWidth < croppedHeight) {
+            croppedWidth = std::min(croppedWidth, side);
+            croppedHeight = std::min<int64_t>(croppedHeight, maxCells / croppedWidth);
+        } else {
+            croppedHeight = std::min(croppedHeight, side);
+            croppedWidth = std::min<int64_t>(croppedWidth, maxCells / croppedHeight);
+        }
+    }
+    pattern.cropped = croppedWidth < width || croppedHeight < height;
+
+    pattern.width = static_cast<int>(croppedWidth);
+    pattern.height = static_cast<int>(croppedHeight);
+    pattern.wordsPerRow = (pattern.width + 63) / 64;
+    try {
+        pattern.words.assign(static_cast<size_t>(pattern.wordsPerRow) * pattern.height, 0);
+    } catch (const std::bad_alloc&) {
+        error = path + " is too large to load";
+        return false;
+    }
+    int64_t windowX = box.x0 + (width - croppedWidth) / 2;
+    int64_t windowY = box.y0 + (height - croppedHeight) / 2;
+    flattenNode(tree, boxes, root, -windowX, -windowY, pattern);
+    return true;
+}
+
+bool writeMacrocell(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+                    const std::string& rule, std::string& error) {
+    // Cut the board into 8x8 leaves; a leaf row is one byte of a word, as both are LSB first
+    MacroTree tree;
+    int levelWidth = (width + 7) / 8;
+    int levelHeight = (height + 7) / 8;
+    std::vector<uint32_t> level(static_cast<size_t>(levelWidth) * levelHeight);
+    for (int ty = 0; ty < levelHeight; ++ty) {
+        for (int tx = 0; tx < levelWidth; ++tx) {
+            uint64_t bits = 0;
+            for (int row = 0; row < 8 && ty * 8 + row < height; ++row) {
+                uint64_t word = words[static_cast<size_t>(ty * 8 + row) * wordsPerRow + (tx >> 3)];
+                bits |= ((word >> ((tx & 7) * 8)) & 0xFF) << (row * 8);
+            }
+            level[static_cast<size_t>(ty) * levelWidth + tx] = tree.makeLeaf(bits);
+        }
+    }
+
+    // Merge quadrants level by level until one node covers the board
+    int levelNumber = LEAF_LEVEL;
+    while (levelWidth > 1 || levelHeight > 1) {
+        int nextWidth = (levelWidth + 1) / 2;
+        int nextHeight = (levelHeight + 1) / 2;
+        std::vector<uint32_t> next(static_cast<size_t>(nextWidth) * nextHeight);
+        auto at = [&](int x, int y) { return x < levelWidth && y < levelHeight ? level[static_cast<size_t>(y) * levelWidth + x] : 0u; };
+        for (int y = 0; y < nextHeight; ++y) {
+            for (int x = 0; x < nextWidth; ++x) {
+                next[static_cast<size_t>(y) * nextWidth + x] =
+                    tree.makeNode(levelNumber + 1, at(2 * x, 2 * y), at(2 * x + 1, 2 * y), at(2 * x, 2 * y + 1), at(2 * x + 1, 2 * y + 1));
+            }
+        }
+        level.swap(next);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+        ++levelNumber;
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+    std::fprintf(file, "[M2] (GameOfLife)\n#R %s\n", rule.c_str());
+
+    // Interned ids are already in dependency order, so they double as file node numbers
+    for (size_t id = 1; id < tree.nodes.size(); ++id) {
+        const MacroNode& node = tree.nodes[id];
+        if (node.level > LEAF_LEVEL) {
+            std::fprintf(file, "%d %u %u %u %u\n", node.level, node.children[0], node.children[1], node.children[2], node.children[3]);
+            continue;
+        }
+        char text[80];
+        int length = 0;
+        int lastRow = 0;
+        for (int row = 0; row < 8; ++row) {
+            int bits = static_cast<int>((node.leaf >> (row * 8)) & 0xFF);
+            if (bits == 0) {
+                continue;
+            }
+            for (; lastRow < row; ++lastRow) {
+                text[length++] = '$';
+            }
+            for (int x = 0; bits >> x; ++x) {
+                text[length++] = (bits >> x) & 1 ? '*' : '.';
+            }
+        }
+        text[length++] = '$';
+        text[length] = '\0';
+        std::fprintf(file, "%s\n", text);
+    }
+    if (tree.nodes.size() == 1) {
+        std::fputs("$\n", file); // Empty board: a single empty leaf as the root
+    }
+
+    bool ok = !std::ferror(file);
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Failed to write " + path;
+    }
+    return ok;
+}
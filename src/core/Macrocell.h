@@ -0,0 +1,22 @@
+#ifndef MACROCELL_H
+#define MACROCELL_H
+
+#include <string>
+#include <cstdint>
+#include "PatternIO.h"
+
+// Largest board, in cells, that a Macrocell pattern is flattened into (128 MB of words)
+const uint64_t MACROCELL_MAX_CELLS = 1ULL << 30;
+
+// Golly's Macrocell format: 8x8 leaves and "level nw ne sw se" nodes of a quadtree, shared
+// wherever the pattern repeats. The file is read into a hash-consed tree, so a few MB can
+// describe a universe far bigger than memory; only the live cells' bounding box is
+// flattened into the pattern, cropped around its centre to maxCells if it is larger.
+// Sets pattern.cropped when cells were left out.
+bool readMacrocell(const std::string& path, Pattern& pattern, std::string& error, uint64_t maxCells = MACROCELL_MAX_CELLS);
+
+// Write a bit-packed board as a Macrocell file, sharing identical 8x8 tiles and quadrants
+bool writeMacrocell(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+                    const std::string& rule, std::string& error);
+
+#endif // MACROCELL_H
@@ -0,0 +1,429 @@
+#include "PatternIO.h"
+#include "Macrocell.h"
+#include "PlainFormats.h"
+#include "ImageExport.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+const size_t READ_CHUNK = 1 << 20;   // Bytes read from a pattern file at a time
+const size_t WRITE_BUFFER = 1 << 16; // Bytes buffered before a write
+const int RLE_LINE_LENGTH = 70;      // Longest line written, as other Life programs expect
+const long long MAX_PATTERN_SIDE = 1LL << 30;
+
+// Set cells [x, x + count) of a row, a word at a time
+void fillRun(uint64_t* row, long long x, long long count) {
+    while (count > 0) {
+        int offset = static_cast<int>(x & 63);
+        int span = static_cast<int>(std::min<long long>(64 - offset, count));
+        uint64_t bits = span == 64 ? ~0ULL : ((1ULL << span) - 1) << offset;
+        row[x >> 6] |= bits;
+        x += span;
+        count -= span;
+    }
+}
+
+// Parse "x = 3, y = 2, rule = B3/S23"
+bool parseRleHeader(const std::string& line, Pattern& pattern, std::string& error) {
+    long long width = -1;
+    long long height = -1;
+    size_t start = 0;
+    while (start < line.size()) {
+        size_t end = line.find(',', start);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        std::string field = line.substr(start, end - start);
+        start = end + 1;
+
+        size_t equals = field.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        std::string key = field.substr(0, equals);
+        std::string value = field.substr(equals + 1);
+        key.erase(std::remove_if(key.begin(), key.end(), ::isspace), key.end());
+        value.erase(std::remove_if(value.begin(), value.end(), ::isspace), value.end());
+
+        if (key == "x") {
+            width = std::atoll(value.c_str());
+        } else if (key == "y") {
+            height = std::atoll(value.c_str());
+        } else if (key == "rule") {
+            pattern.rule = value;
+        }
+    }
+
+    if (width < 0 || height < 0 || width > MAX_PATTERN_SIDE || height > MAX_PATTERN_SIDE) {
+        error = "Bad RLE header: " + line;
+        return false;
+    }
+    pattern.width = static_cast<int>(width);
+    pattern.height = static_cast<int>(height);
+    pattern.wordsPerRow = static_cast<int>((width + 63) / 64);
+    try {
+        pattern.words.assign(static_cast<size_t>(pattern.wordsPerRow) * pattern.height, 0);
+    } catch (const std::bad_alloc&) {
+        error = "Pattern too large: " + line;
+        return false;
+    }
+    return true;
+}
+
+bool readRle(const std::string& path, Pattern& pattern, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    // Before the header, lines are comments or blank; after it, the body is a token stream
+    enum { LINE_START, COMMENT, HEADER, BODY, DONE } state = LINE_START;
+    std::string header;
+    std::vector<char> buffer(READ_CHUNK);
+    long long count = 0; // Run count of the token being read, 0 if none given
+    long long x = 0;
+    long long y = 0;
+    bool ok = true;
+
+    while (ok && state != DONE) {
+        size_t length = std::fread(buffer.data(), 1, buffer.size(), file);
+        if (length == 0) {
+            break;
+        }
+
+        for (size_t i = 0; ok && i < length && state != DONE; ++i) {
+            char c = buffer[i];
+            switch (state) {
+                case LINE_START:
+                    if (c == '#') {
+                        state = COMMENT;
+                    } else if (c == 'x') {
+                        header = c;
+                        state = HEADER;
+                    } else if (!std::isspace(static_cast<unsigned char>(c))) {
+                        error = "Missing RLE header in " + path;
+                        ok = false;
+                    }
+                    break;
+                case COMMENT:
+                    if (c == '\n') {
+                        state = LINE_START;
+                    }
+                    break;
+                case HEADER:
+                    if (c == '\n' || c == '\r') {
+                        ok = parseRleHeader(header, pattern, error);
+                        state = BODY;
+                    } else {
+                        header += c;
+                    }
+                    break;
+                case BODY: {
+                    if (c >= '0' && c <= '9') {
+                        count = count * 10 + (c - '0');
+                        if (count > MAX_PATTERN_SIDE) {
+                            error = "Run too long in " + path;
+                            ok = false;
+                        }
+                        break;
+                    }
+                    if (std::isspace(static_cast<unsigned char>(c))) {
+                        break;
+                    }
+
+                    long long run = count > 0 ? count : 1;
+                    count = 0;
+                    if (c == 'b' || c == '.') {
+                        x += run;
+                    } else if (c == '$') {
+                        y += run;
+                        x = 0;
+                    } else if (c == '!') {
+                        state = DONE;
+                    } else if (std::isalpha(static_cast<unsigned char>(c))) {
+                        // 'o', or any state letter of a multi-state file, is alive
+                        if (x + run > pattern.width || y >= pattern.height) {
+                            error = "Pattern exceeds its header size in " + path;
+                            ok = false;
+                            break;
+                        }
+                        fillRun(&pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow], x, run);
+                        x += run;
+                    } else {
+                        error = std::string("Unexpected '") + c + "' in " + path;
+                        ok = false;
+                    }
+                    break;
+                }
+                case DONE:
+                    break;
+            }
+        }
+    }
+
+    if (ok && std::ferror(file)) {
+        error = "Failed to read " + path;
+        ok = false;
+    }
+    if (ok && state == HEADER) {
+        ok = parseRleHeader(header, pattern, error); // Header without a body: an empty pattern
+    } else if (ok && state != BODY && state != DONE) {
+        error = "Missing RLE header in " + path;
+        ok = false;
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// First cell at or after x in the row whose state is alive (or dead when alive is false), or width
+int findCell(const uint64_t* row, int x, int width, bool alive) {
+    while (x < width) {
+        uint64_t word = alive ? row[x >> 6] : ~row[x >> 6];
+        word &= ~0ULL << (x & 63);
+        if (word != 0) {
+            return std::min(width, (x & ~63) + __builtin_ctzll(word));
+        }
+        x = (x & ~63) + 64;
+    }
+    return width;
+}
+
+// Buffered token output with line wrapping
+class RleWriter {
+public:
+    explicit RleWriter(std::FILE* outputFile) : file(outputFile) {
+        buffer.reserve(WRITE_BUFFER + 64);
+    }
+
+    void write(const char* text) {
+        buffer += text;
+        flushIfFull();
+    }
+
+    void token(long long run, char tag) {
+        // Digits are formatted by hand; this runs once per run of cells
+        char text[24];
+        char* end = text + sizeof(text);
+        char* start = end;
+        *--start = tag;
+        if (run != 1) {
+            for (; run > 0; run /= 10) {
+                *--start = static_cast<char>('0' + run % 10);
+            }
+        }
+        int length = static_cast<int>(end - start);
+        if (lineLength + length > RLE_LINE_LENGTH) {
+            buffer += '\n';
+            lineLength = 0;
+        }
+        buffer.append(start, length);
+        lineLength += length;
+        flushIfFull();
+    }
+
+    bool finish() {
+        flush();
+        return ok;
+    }
+
+private:
+    std::FILE* file;
+    std::string buffer;
+    int lineLength = 0;
+    bool ok = true;
+
+    void flush() {
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            ok = false;
+        }
+        buffer.clear();
+    }
+
+    void flushIfFull() {
+        if (buffer.size() >= WRITE_BUFFER) {
+            flush();
+        }
+    }
+};
+
+bool writeRle(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+              const std::string& rule, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    RleWriter writer(file);
+    char header[128];
+    std::snprintf(header, sizeof(header), "x = %d, y = %d, rule = %s\n", width, height, rule.c_str());
+    writer.write(header);
+
+    // Runs are found a word at a time; empty rows and trailing dead cells cost no tokens
+    int lastRow = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint64_t* row = words + static_cast<size_t>(y) * wordsPerRow;
+        int x = findCell(row, 0, width, true);
+        if (x == width) {
+            continue;
+        }
+        if (y > lastRow) {
+            writer.token(y - lastRow, '$');
+        }
+        lastRow = y;
+
+        int deadStart = 0;
+        while (x < width) {
+            if (x > deadStart) {
+                writer.token(x - deadStart, 'b');
+            }
+            int end = findCell(row, x, width, false);
+            writer.token(end - x, 'o');
+            deadStart = end;
+            x = findCell(row, end, width, true);
+        }
+    }
+    writer.token(1, '!');
+    writer.write("\n");
+
+    bool ok = writer.finish();
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Failed to write " + path;
+    }
+    return ok;
+}
+
+bool readGridText(const std::string& path, Pattern& pattern, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    // Columns are collected as packed bits first, since the width is the line count
+    std::vector<std::vector<uint64_t>> columns;
+    std::vector<uint64_t> column;
+    long long cells = 0; // Cells read on the current line
+    long long height = -1;
+    bool ok = true;
+    std::vector<char> buffer(READ_CHUNK);
+
+    auto endLine = [&]() {
+        if (cells == 0) {
+            return; // Blank line
+        }
+        if (height >= 0 && cells != height) {
+            error = path + " is ragged or truncated at column " + std::to_string(columns.size());
+            ok = false;
+        }
+        height = cells;
+        columns.push_back(std::move(column));
+        column.clear();
+        cells = 0;
+    };
+
+    size_t length;
+    while (ok && (length = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+        for (size_t i = 0; ok && i < length; ++i) {
+            char c = buffer[i];
+            if (c == '0' || c == '1') {
+                if ((cells & 63) == 0) {
+                    column.push_back(0);
+                }
+                column.back() |= static_cast<uint64_t>(c - '0') << (cells & 63);
+                ++cells;
+            } else if (c == '\n') {
+                endLine();
+            } else if (c != ' ' && c != '\r' && c != '\t') {
+                error = std::string("Unexpected '") + c + "' in " + path;
+                ok = false;
+            }
+        }
+    }
+    if (ok) {
+        endLine();
+    }
+    std::fclose(file);
+    if (!ok) {
+        return false;
+    }
+
+    pattern.width = static_cast<int>(columns.size());
+    pattern.height = static_cast<int>(std::max(height, 0LL));
+    pattern.wordsPerRow = (pattern.width + 63) / 64;
+    pattern.words.assign(static_cast<size_t>(pattern.wordsPerRow) * pattern.height, 0);
+    for (int x = 0; x < pattern.width; ++x) {
+        for (int y = 0; y < pattern.height; ++y) {
+            if ((columns[x][y >> 6] >> (y & 63)) & 1) {
+                pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow + (x >> 6)] |= 1ULL << (x & 63);
+            }
+        }
+    }
+    return true;
+}
+
+bool hasExtension(const std::string& path, const char* extension) {
+    size_t length = std::char_traits<char>::length(extension);
+    return path.size() >= length && path.compare(path.size() - length, length, extension) == 0;
+}
+
+bool readPattern(const std::string& path, Pattern& pattern, std::string& error) {
+    if (hasExtension(path, ".mc")) {
+        return readMacrocell(path, pattern, error);
+    }
+    if (hasExtension(path, ".txt")) {
+        return readGridText(path, pattern, error);
+    }
+    if (hasExtension(path, ".cells")) {
+        return readCells(path, pattern, error);
+    }
+    if (hasExtension(path, ".lif") || hasExtension(path, ".life")) {
+        return readLife106(path, pattern, error);
+    }
+    if (hasExtension(path, ".pbm")) {
+        return readPbm(path, pattern, error);
+    }
+    return readRle(path, pattern, error);
+}
+
+bool writePattern(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+                  const std::string& rule, std::string& error) {
+    if (hasExtension(path, ".mc")) {
+        return writeMacrocell(path, words, wordsPerRow, width, height, rule, error);
+    }
+    if (hasExtension(path, ".cells")) {
+        return writeCells(path, words, wordsPerRow, width, height, error);
+    }
+    if (hasExtension(path, ".lif") || hasExtension(path, ".life")) {
+        return writeLife106(path, words, wordsPerRow, width, height, error);
+    }
+    if (hasExtension(path, ".pbm")) {
+        return exportImage(path, IMAGE_PBM, words, wordsPerRow, width, height, 1, error);
+    }
+    return writeRle(path, words, wordsPerRow, width, height, rule, error);
+}
+
+void blitPattern(const Pattern& pattern, uint64_t* words, int wordsPerRow, int width, int height, int x, int y) {
+    int shift = x & 63;
+    int firstWord = x >> 6;
+    for (int py = 0; py < pattern.height && y + py < height; ++py) {
+        const uint64_t* source = &pattern.words[static_cast<size_t>(py) * pattern.wordsPerRow];
+        uint64_t* row = words + static_cast<size_t>(y + py) * wordsPerRow;
+        for (int w = 0; w < pattern.wordsPerRow && firstWord + w < wordsPerRow; ++w) {
+            row[firstWord + w] |= source[w] << shift;
+            if (shift != 0 && firstWord + w + 1 < wordsPerRow) {
+                row[firstWord + w + 1] |= source[w] >> (64 - shift);
+            }
+        }
+        if (width & 63) {
+            row[wordsPerRow - 1] &= (1ULL << (width & 63)) - 1;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef PATTERN_IO_H
+#define PATTERN_IO_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// A pattern read from a file, in the grid's bit-packed row layout
+struct Pattern {
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> words;
+    std::string rule = "B3/S23"; // Empty for formats without one; the board keeps its rule
+    bool cropped = false; // Only part of a larger pattern is held
+};
+
+// Life RLE (x = .., y = .., rule = .. header, then run-length b/o/$ tokens up to '!').
+// The file is parsed in fixed-size chunks straight into the pattern's words, so only the
+// bit-packed pattern itself is held in memory. Returns false and fills error on failure.
+bool readRle(const std::string& path, Pattern& pattern, std::string& error);
+
+// Write a bit-packed board as RLE through a fixed-size buffer, one run per token
+bool writeRle(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+              const std::string& rule, std::string& error);
+
+// The text format of older versions: one line per column, "0 " or "1 " per cell.
+// The board size is taken from the file; ragged or short files are rejected.
+bool readGridText(const std::string& path, Pattern& pattern, std::string& error);
+
+// Read or write a pattern in the format given by the file extension: .mc is Macrocell,
+// .cells plaintext, .lif or .life Life 1.06, .pbm a bitmap (PlainFormats.h), .txt the old
+// text format (read only), anything else RLE
+bool readPattern(const std::string& path, Pattern& pattern, std::string& error);
+bool writePattern(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height,
+                  const std::string& rule, std::string& error);
+
+// OR the pattern into a board with its top-left corner at (x, y), x and y >= 0; whatever
+// falls outside the board is clipped
+void blitPattern(const Pattern& pattern, uint64_t* words, int wordsPerRow, int width, int height, int x, int y);
+
+#endif // PATTERN_IO_H
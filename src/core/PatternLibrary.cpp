@@ -0,0 +1,435 @@
+#include "PatternLibrary.h"
+#include "PatternIO.h"
+#include "BinarySnapshot.h"
+#include "BackgroundIO.h"
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+const char INDEX_NAME[] = ".patternindex";
+const char INDEX_HEADER[] = "#patternindex 1";
+const char THUMBNAIL_FOLDER[] = ".thumbnails";
+const char* const PATTERN_EXTENSIONS[] = { ".rle", ".mc", ".cells", ".lif", ".life", ".pbm" };
+const size_t MAX_THUMBNAIL_REQUESTS = 512; // Older requests are dropped; their rows scrolled away
+
+struct ThumbnailRequest {
+    std::string root;
+    LibraryEntry entry;
+};
+
+std::thread libraryThread;
+std::mutex libraryMutex;
+std::condition_variable libraryWake;
+bool libraryRunning = false;
+void (*updateCallback)() = nullptr;
+
+// Guarded by libraryMutex
+std::string pendingScan;
+bool scanPending = false;
+std::string libraryRoot;
+std::vector<LibraryEntry> libraryEntries;
+uint64_t libraryVersion = 0;
+LibraryStatus libraryStatus;
+std::deque<ThumbnailRequest> thumbnailRequests;
+std::vector<Thumbnail> finishedThumbnails;
+
+bool isPatternFile(const fs::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    for (const char* known : PATTERN_EXTENSIONS) {
+        if (extension == known) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Population, bounding box and hash of a pattern read from a file
+void describePattern(const Pattern& pattern, LibraryEntry& entry) {
+    entry.width = pattern.width;
+    entry.height = pattern.height;
+    entry.rule = pattern.rule;
+    entry.population = 0;
+    int minX = pattern.width, minY = pattern.height, maxX = -1, maxY = -1;
+    for (int y = 0; y < pattern.height; ++y) {
+        const uint64_t* row = &pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow];
+        for (int w = 0; w < pattern.wordsPerRow; ++w) {
+            if (row[w] == 0) {
+                continue;
+            }
+            entry.population += __builtin_popcountll(row[w]);
+            minX = std::min(minX, w * 64 + __builtin_ctzll(row[w]));
+            maxX = std::max(maxX, w * 64 + 63 - __builtin_clzll(row[w]));
+            minY = std::min(minY, y);
+            maxY = y;
+        }
+    }
+    entry.boxX = maxX < 0 ? 0 : minX;
+    entry.boxY = maxY < 0 ? 0 : minY;
+    entry.boxWidth = maxX < 0 ? 0 : maxX - minX + 1;
+    entry.boxHeight = maxY < 0 ? 0 : maxY - minY + 1;
+    uint64_t size = static_cast<uint64_t>(pattern.width) << 32 | static_cast<uint32_t>(pattern.height);
+    entry.hash = checksumWords(pattern.words.data(), pattern.words.size()) ^ (size * 0x9E3779B97F4A7C15ULL);
+}
+
+// One line per entry, tab separated, the path last since it may hold spaces
+std::map<std::string, LibraryEntry> readIndex(const fs::path& root) {
+    std::map<std::string, LibraryEntry> entries;
+    std::ifstream file(root / INDEX_NAME);
+    std::string line;
+    if (!std::getline(file, line) || line != INDEX_HEADER) {
+        return entries;
+    }
+    while (std::getline(file, line)) {
+        LibraryEntry entry;
+        const char* position = line.data();
+        const char* end = position + line.size();
+        bool ok = true;
+        auto number = [&](auto& value) {
+            auto parsed = std::from_chars(position, end, value);
+            ok = ok && parsed.ec == std::errc() && parsed.ptr < end && *parsed.ptr == '\t';
+            position = ok ? parsed.ptr + 1 : end;
+        };
+        number(entry.fileSize);
+        number(entry.modified);
+        number(entry.width);
+        number(entry.height);
+        number(entry.population);
+        number(entry.boxX);
+        number(entry.boxY);
+        number(entry.boxWidth);
+        number(entry.boxHeight);
+        number(entry.hash);
+        const char* tab = std::find(position, end, '\t');
+        if (!ok || tab == end) {
+            continue; // Damaged line: the file is read again
+        }
+        entry.rule.assign(position, tab);
+        entry.path.assign(tab + 1, end);
+        entries[entry.path] = std::move(entry);
+    }
+    return entries;
+}
+
+bool writeIndex(const fs::path& root, const std::vector<LibraryEntry>& entries, std::string& error) {
+    return writeFileAtomically((root / INDEX_NAME).string(), [&](const std::string& tempPath, std::string& writeError) {
+        std::ofstream file(tempPath, std::ios::binary);
+        file << INDEX_HEADER << '\n';
+        for (const LibraryEntry& entry : entries) {
+            file << entry.fileSize << '\t' << entry.modified << '\t' << entry.width << '\t' << entry.height << '\t'
+                 << entry.population << '\t' << entry.boxX << '\t' << entry.boxY << '\t' << entry.boxWidth << '\t'
+                 << entry.boxHeight << '\t' << entry.hash << '\t' << entry.rule << '\t' << entry.path << '\n';
+        }
+        file.close();
+        if (!file) {
+            writeError = "Failed to write " + tempPath;
+            return false;
+        }
+        return true;
+    }, error);
+}
+
+void setScanProgress(size_t seen, size_t parsed) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        libraryStatus.filesSeen = seen;
+        libraryStatus.filesParsed = parsed;
+    }
+    if (updateCallback != nullptr) {
+        updateCallback();
+    }
+}
+
+// Walk the tree, reusing index entries of files whose size and time are unchanged
+void runScan(const std::string& rootName) {
+    fs::path root(rootName);
+    std::map<std::string, LibraryEntry> indexed = readIndex(root);
+    std::vector<LibraryEntry> entries;
+    size_t parsed = 0;
+    size_t unreadable = 0;
+    std::error_code code;
+
+    if (!fs::is_directory(root, code)) {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        libraryStatus.scanning = false;
+        libraryStatus.message = rootName + " is not a folder";
+        libraryStatus.failed = true;
+        return;
+    }
+
+    auto options = fs::directory_options::skip_permission_denied;
+    for (fs::recursive_directory_iterator it(root, options, code), end; !code && it != end; it.increment(code)) {
+        if (it->is_directory(code) && it->path().filename().string()[0] == '.') {
+            it.disable_recursion_pending(); // The thumbnail cache and other hidden folders
+            continue;
+        }
+        if (!it->is_regular_file(code) || !isPatternFile(it->path())) {
+            continue;
+        }
+
+        LibraryEntry entry;
+        entry.path = it->path().lexically_relative(root).generic_string();
+        entry.fileSize = it->file_size(code);
+        entry.modified = static_cast<int64_t>(it->last_write_time(code).time_since_epoch().count());
+        auto known = indexed.find(entry.path);
+        if (known != indexed.end() && known->second.fileSize == entry.fileSize && known->second.modified == entry.modified) {
+            entries.push_back(std::move(known->second));
+        } else {
+            Pattern pattern;
+            std::string error;
+            if (!readPattern(it->path().string(), pattern, error)) {
+                ++unreadable;
+                continue;
+            }
+            describePattern(pattern, entry);
+            entries.push_back(std::move(entry));
+            ++parsed;
+        }
+        if (entries.size() % 256 == 0) {
+            setScanProgress(entries.size(), parsed);
+            std::lock_guard<std::mutex> lock(libraryMutex);
+            if (!libraryRunning) {
+                return;
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const LibraryEntry& a, const LibraryEntry& b) { return a.path < b.path; });
+
+    // Only rewrite the index when something changed, so read-only libraries still browse fine
+    std::string error;
+    bool changed = parsed > 0 || entries.size() != indexed.size();
+    bool saved = !changed || writeIndex(root, entries, error);
+
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    libraryRoot = rootName;
+    libraryEntries = std::move(entries);
+    ++libraryVersion;
+    libraryStatus.scanning = false;
+    libraryStatus.filesSeen = libraryEntries.size();
+    libraryStatus.filesParsed = parsed;
+    libraryStatus.message = std::to_string(libraryEntries.size()) + " patterns, " + std::to_string(parsed) + " read" +
+                            (unreadable > 0 ? ", " + std::to_string(unreadable) + " unreadable" : "") +
+                            (saved ? "" : " (index not saved: " + error + ")");
+    libraryStatus.failed = false;
+}
+
+fs::path thumbnailPath(const std::string& root, uint64_t hash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.pgm", static_cast<unsigned long long>(hash));
+    return fs::path(root) / THUMBNAIL_FOLDER / name;
+}
+
+// Scale the live cells' bounding box to fit the thumbnail, centred. Zoomed out, a pixel
+// shows the share of live cells in its block; zoomed in, each cell is a square of pixels.
+// entry describes this pattern; cells outside the pattern or its box are skipped all the same.
+void renderThumbnail(const Pattern& pattern, const LibraryEntry& entry, std::vector<uint8_t>& pixels) {
+    pixels.assign(THUMBNAIL_SIZE * THUMBNAIL_SIZE, 0);
+    int side = std::max(entry.boxWidth, entry.boxHeight);
+    if (side == 0) {
+        return;
+    }
+    int cellsPerPixel = (side + THUMBNAIL_SIZE - 1) / THUMBNAIL_SIZE;
+    int pixelsPerCell = std::max(THUMBNAIL_SIZE / side, 1);
+    int extentX = cellsPerPixel > 1 ? (entry.boxWidth + cellsPerPixel - 1) / cellsPerPixel : entry.boxWidth * pixelsPerCell;
+    int extentY = cellsPerPixel > 1 ? (entry.boxHeight + cellsPerPixel - 1) / cellsPerPixel : entry.boxHeight * pixelsPerCell;
+    int offsetX = (THUMBNAIL_SIZE - extentX) / 2;
+    int offsetY = (THUMBNAIL_SIZE - extentY) / 2;
+
+    std::vector<uint32_t> counts(pixels.size(), 0);
+    int top = std::max(entry.boxY, 0);
+    int bottom = std::min(entry.boxY + entry.boxHeight, pattern.height);
+    int right = std::min(entry.boxX + entry.boxWidth, pattern.width);
+    for (int y = top; y < bottom; ++y) {
+        const uint64_t* row = &pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow];
+        for (int w = 0; w < pattern.wordsPerRow; ++w) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                int x = w * 64 + __builtin_ctzll(bits);
+                if (x < entry.boxX || x >= right) {
+                    continue;
+                }
+                x -= entry.boxX;
+                int cy = y - entry.boxY;
+                if (cellsPerPixel > 1) {
+                    ++counts[(offsetY + cy / cellsPerPixel) * THUMBNAIL_SIZE + offsetX + x / cellsPerPixel];
+                    continue;
+                }
+                for (int py = 0; py < pixelsPerCell; ++py) {
+                    for (int px = 0; px < pixelsPerCell; ++px) {
+                        counts[(offsetY + cy * pixelsPerCell + py) * THUMBNAIL_SIZE + offsetX + x * pixelsPerCell + px] = 1;
+                    }
+                }
+            }
+        }
+    }
+    // In 64 bits: the block area and the scaled counts outgrow 32 bits on very large patterns
+    uint64_t full = cellsPerPixel > 1 ? static_cast<uint64_t>(cellsPerPixel) * cellsPerPixel : 1;
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        // A single live cell in a large block should still show
+        pixels[i] = counts[i] == 0 ? 0 : static_cast<uint8_t>(std::max<uint64_t>(static_cast<uint64_t>(counts[i]) * 255 / full, 64));
+    }
+}
+
+// Thumbnails are binary PGM images named after the pattern hash
+bool readCachedThumbnail(const fs::path& path, std::vector<uint8_t>& pixels) {
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int width = 0, height = 0, maxValue = 0;
+    if (!(file >> magic >> width >> height >> maxValue) || magic != "P5" || width != THUMBNAIL_SIZE ||
+        height != THUMBNAIL_SIZE || maxValue != 255) {
+        return false;
+    }
+    file.get();
+    pixels.resize(THUMBNAIL_SIZE * THUMBNAIL_SIZE);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(pixels.data()), pixels.size()));
+}
+
+void runThumbnail(const ThumbnailRequest& request) {
+    Thumbnail thumbnail;
+    thumbnail.hash = request.entry.hash;
+    fs::path cachePath = thumbnailPath(request.root, request.entry.hash);
+    if (!readCachedThumbnail(cachePath, thumbnail.pixels)) {
+        Pattern pattern;
+        std::string error;
+        if (!readPattern((fs::path(request.root) / request.entry.path).string(), pattern, error)) {
+            thumbnail.pixels.assign(THUMBNAIL_SIZE * THUMBNAIL_SIZE, 0); // Shown empty rather than asked for again
+        } else {
+            // The file may have changed since it was indexed: render what it holds now, and
+            // cache that only if it is still what the index's hash names
+            LibraryEntry current;
+            describePattern(pattern, current);
+            renderThumbnail(pattern, current, thumbnail.pixels);
+            if (current.hash == request.entry.hash) {
+                std::error_code code;
+                fs::create_directories(cachePath.parent_path(), code);
+                writeFileAtomically(cachePath.string(), [&](const std::string& tempPath, std::string& writeError) {
+                    std::ofstream file(tempPath, std::ios::binary);
+                    file << "P5\n" << THUMBNAIL_SIZE << ' ' << THUMBNAIL_SIZE << "\n255\n";
+                    file.write(reinterpret_cast<const char*>(thumbnail.pixels.data()), thumbnail.pixels.size());
+                    file.close();
+                    if (!file) {
+                        writeError = "Failed to write " + tempPath;
+                    }
+                    return static_cast<bool>(file);
+                }, error); // A cache that cannot be written only costs a render next time
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    finishedThumbnails.push_back(std::move(thumbnail));
+}
+
+void libraryLoop() {
+    while (true) {
+        std::string scanRoot;
+        ThumbnailRequest request;
+        bool scan = false;
+        {
+            std::unique_lock<std::mutex> lock(libraryMutex);
+            libraryWake.wait(lock, [] { return scanPending || !thumbnailRequests.empty() || !libraryRunning; });
+            if (!libraryRunning) {
+                return;
+            }
+            // A scan goes first, since it may replace the entries the thumbnails are for
+            if (scanPending) {
+                scanRoot = pendingScan;
+                scanPending = false;
+                scan = true;
+            } else {
+                request = std::move(thumbnailRequests.front());
+                thumbnailRequests.pop_front();
+            }
+        }
+        if (scan) {
+            runScan(scanRoot);
+        } else {
+            runThumbnail(request);
+        }
+        if (updateCallback != nullptr) {
+            updateCallback();
+        }
+    }
+}
+
+void startLibrary(void (*onUpdate)()) {
+    updateCallback = onUpdate;
+    libraryRunning = true;
+    libraryThread = std::thread(libraryLoop);
+}
+
+void stopLibrary() {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        libraryRunning = false;
+    }
+    libraryWake.notify_one();
+    if (libraryThread.joinable()) {
+        libraryThread.join();
+    }
+}
+
+void scanLibrary(const std::string& root) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        pendingScan = root;
+        scanPending = true;
+        thumbnailRequests.clear();
+        libraryStatus.scanning = true;
+        libraryStatus.filesSeen = 0;
+        libraryStatus.filesParsed = 0;
+    }
+    libraryWake.notify_one();
+}
+
+LibraryStatus getLibraryStatus() {
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    return libraryStatus;
+}
+
+bool getLibraryEntries(std::vector<LibraryEntry>& entries, uint64_t& version) {
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    if (version == libraryVersion) {
+        return false;
+    }
+    entries = libraryEntries;
+    version = libraryVersion;
+    return true;
+}
+
+void requestThumbnail(const LibraryEntry& entry) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        auto queued = std::find_if(thumbnailRequests.begin(), thumbnailRequests.end(),
+                                   [&](const ThumbnailRequest& request) { return request.entry.hash == entry.hash; });
+        if (queued != thumbnailRequests.end()) {
+            thumbnailRequests.erase(queued); // Asked for again: move it to the front
+        }
+        ThumbnailRequest request;
+        request.root = libraryRoot;
+        request.entry = entry;
+        thumbnailRequests.push_front(std::move(request));
+        if (thumbnailRequests.size() > MAX_THUMBNAIL_REQUESTS) {
+            thumbnailRequests.pop_back();
+        }
+    }
+    libraryWake.notify_one();
+}
+
+void takeThumbnails(std::vector<Thumbnail>& thumbnails) {
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    thumbnails = std::move(finishedThumbnails);
+    finishedThumbnails.clear();
+}
+
+std::string getLibraryPath(const LibraryEntry& entry) {
+    std::lock_guard<std::mutex> lock(libraryMutex);
+    return (fs::path(libraryRoot) / entry.path).string();
+}
@@ -0,0 +1,64 @@
+#ifndef PATTERN_LIBRARY_H
+#define PATTERN_LIBRARY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// A pattern file found under the library folder
+struct LibraryEntry {
+    std::string path;          // Relative to the library folder
+    uint64_t fileSize = 0;     // Size and modification time tell whether the file changed
+    int64_t modified = 0;      // since it was indexed
+    int width = 0;
+    int height = 0;
+    std::string rule;          // Empty if the format has none
+    uint64_t population = 0;
+    int boxX = 0;              // Bounding box of the live cells
+    int boxY = 0;
+    int boxWidth = 0;
+    int boxHeight = 0;
+    uint64_t hash = 0;         // Of the cells; names the cached thumbnail
+};
+
+const int THUMBNAIL_SIZE = 64; // Pixels per thumbnail side
+
+// A rendered thumbnail: THUMBNAIL_SIZE x THUMBNAIL_SIZE bytes of live-cell density
+struct Thumbnail {
+    uint64_t hash = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct LibraryStatus {
+    bool scanning = false;
+    size_t filesSeen = 0;      // Pattern files found by the current or last scan
+    size_t filesParsed = 0;    // Of those, new or changed files that had to be read
+    std::string message;       // Outcome of the last scan
+    bool failed = false;
+};
+
+// The library runs on its own thread, which scans folders and renders thumbnails. onUpdate
+// is called from that thread when a scan or thumbnail is done, e.g. to wake the UI.
+void startLibrary(void (*onUpdate)());
+void stopLibrary();
+
+// Index every pattern file under root. The index is kept in root/.patternindex, so later
+// scans only read files that are new or changed; thumbnails are cached in root/.thumbnails.
+void scanLibrary(const std::string& root);
+
+LibraryStatus getLibraryStatus();
+
+// Copy the entries of the last finished scan, sorted by path, if they changed since version.
+// Returns false and leaves entries alone otherwise.
+bool getLibraryEntries(std::vector<LibraryEntry>& entries, uint64_t& version);
+
+// Queue a thumbnail; the most recent requests are rendered first, so the rows on screen
+// come before rows scrolled past. Asking again for a queued one moves it to the front, and
+// the oldest requests are dropped when many pile up, so ask every frame until it arrives.
+void requestThumbnail(const LibraryEntry& entry);
+void takeThumbnails(std::vector<Thumbnail>& thumbnails); // Move out the finished ones
+
+// Full path of an entry, for loading it
+std::string getLibraryPath(const LibraryEntry& entry);
+
+#endif // PATTERN_LIBRARY_H
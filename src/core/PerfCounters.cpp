@@ -0,0 +1,199 @@
+#include "PerfCounters.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+double PerfReading::getIpc() const {
+    if (!available[PERF_CYCLES] || !available[PERF_INSTRUCTIONS] || counts[PERF_CYCLES] == 0.0) {
+        return 0.0;
+    }
+    return counts[PERF_INSTRUCTIONS] / counts[PERF_CYCLES];
+}
+
+PerfCounters::PerfCounters() {
+    for (int& fd : fds) {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+#ifdef __linux__
+// Why perf_event_open refused a hardware counter, for the status display
+std::string describeOpenError(int code) {
+    switch (code) {
+        case ENOENT:
+        case EOPNOTSUPP:
+            return "no hardware counters on this CPU or virtual machine";
+        case EACCES:
+        case EPERM: {
+            std::ifstream in("/proc/sys/kernel/perf_event_paranoid");
+            std::string level;
+            in >> level;
+            return "not permitted" + (level.empty() ? std::string() : " (kernel.perf_event_paranoid is " + level + ")");
+        }
+        case ENOSYS:
+            return "perf_event_open is not available here";
+        default:
+            return std::string("perf_event_open: ") + std::strerror(code);
+    }
+}
+
+bool PerfCounters::open(bool newThreads) {
+    close();
+    const struct {
+        uint32_t type;
+        uint64_t config;
+    } events[PERF_COUNTER_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    };
+    // Separate counters rather than one group: a group cannot be read once inherited by
+    // other threads, and a counter the CPU lacks then costs only itself
+    bool any = false;
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[counter].type;
+        attr.config = events[counter].config;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.inherit = newThreads ? 1 : 0;
+        attr.exclude_kernel = 1; // User space only, which unprivileged processes may count
+        attr.exclude_hv = 1;
+        fds[counter] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        if (fds[counter] >= 0) {
+            any = true;
+        } else if (error.empty() && counter != PERF_TASK_CLOCK) {
+            error = describeOpenError(errno);
+        }
+    }
+    if (!any && error.empty()) {
+        error = "perf_event_open is not available here";
+    }
+    return any;
+}
+
+void PerfCounters::close() {
+    for (int& fd : fds) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    error.clear();
+    started = false;
+}
+
+void PerfCounters::readCounts(double* counts) const {
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        uint64_t values[3] = {}; // Count, time enabled, time running
+        counts[counter] = 0.0;
+        if (fds[counter] < 0 || read(fds[counter], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+            continue;
+        }
+        counts[counter] = static_cast<double>(values[0]) * (static_cast<double>(values[1]) / values[2]);
+    }
+}
+#else
+bool PerfCounters::open(bool) {
+    error = "hardware counters need Linux";
+    return false;
+}
+
+void PerfCounters::close() {
+    started = false;
+}
+
+void PerfCounters::readCounts(double* counts) const {
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        counts[counter] = 0.0;
+    }
+}
+#endif
+
+bool PerfCounters::isOpen() const {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+    if (!isOpen()) {
+        return;
+    }
+    readCounts(startCounts);
+    started = true;
+}
+
+void PerfCounters::stop(uint64_t units) {
+    if (!started) {
+        return;
+    }
+    double counts[PERF_COUNTER_COUNT];
+    readCounts(counts);
+    for (int counter = 0; counter < PERF_COUNTER_COUNT; ++counter) {
+        if (fds[counter] >= 0) {
+            reading.available[counter] = true;
+            reading.counts[counter] += counts[counter] > startCounts[counter] ? counts[counter] - startCounts[counter] : 0.0;
+        }
+    }
+    reading.units += units;
+    started = false;
+}
+
+PerfReading PerfCounters::takeReading() {
+    PerfReading taken = reading;
+    reading = PerfReading();
+    return taken;
+}
+
+// 1234567 -> "1.23M"
+std::string formatCount(double count) {
+    const char* suffixes[] = { "", "k", "M", "G", "T" };
+    int suffix = 0;
+    while (count >= 1000.0 && suffix < 4) {
+        count /= 1000.0;
+        ++suffix;
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), suffix == 0 ? "%.0f%s" : "%.3g%s", count, suffixes[suffix]);
+    return text;
+}
+
+std::string describeCounters(const PerfReading& reading, const char* unit) {
+    auto perUnit = [&](PerfCounter counter) {
+        return reading.available[counter] ? formatCount(reading.perUnit(counter)) : std::string("n/a");
+    };
+    std::string text = perUnit(PERF_CYCLES) + " cycles/" + unit + ", IPC ";
+    if (reading.available[PERF_CYCLES] && reading.available[PERF_INSTRUCTIONS]) {
+        char ipc[16];
+        std::snprintf(ipc, sizeof(ipc), "%.2f", reading.getIpc());
+        text += ipc;
+    } else {
+        text += "n/a";
+    }
+    text += ", misses/" + std::string(unit) + " L1D " + perUnit(PERF_L1D_MISSES) + " LLC " + perUnit(PERF_LLC_MISSES) +
+            " branch " + perUnit(PERF_BRANCH_MISSES);
+    if (reading.available[PERF_TASK_CLOCK]) {
+        char cpu[48];
+        std::snprintf(cpu, sizeof(cpu), ", %.3g ms CPU/%s", reading.perUnit(PERF_TASK_CLOCK) / 1e6, unit);
+        text += cpu;
+    }
+    return text;
+}
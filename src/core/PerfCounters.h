@@ -0,0 +1,76 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+// Hardware performance counters (Linux perf_event_open) around sections of code, such as
+// the step kernels. The counters follow the thread that opens them and, if asked, every
+// thread it starts afterwards, so engines stepping on worker threads are counted in full,
+// provided the workers start after open. Where the kernel, a container or the CPU offers no
+// hardware counters they stay unavailable and only the software task clock is counted;
+// elsewhere than Linux nothing is.
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,    // Level 1 data cache read misses
+    PERF_LLC_MISSES,    // Last level cache misses
+    PERF_BRANCH_MISSES, // Mispredicted branches
+    PERF_TASK_CLOCK,    // Nanoseconds on a CPU, summed over threads; software, so nearly always there
+    PERF_COUNTER_COUNT
+};
+
+// Names as written into JSON
+const char* const PERF_COUNTER_NAMES[] = { "cycles", "instructions", "l1dMisses", "llcMisses", "branchMisses", "taskClockNs" };
+
+// Counts summed over the measured sections. Counts the kernel had to multiplex with other
+// users of the counters are scaled up to the whole section, as perf does.
+struct PerfReading {
+    bool available[PERF_COUNTER_COUNT] = {};
+    double counts[PERF_COUNTER_COUNT] = {};
+    uint64_t units = 0; // What the sections measured, e.g. generations or frames
+
+    double perUnit(PerfCounter counter) const { return units == 0 ? 0.0 : counts[counter] / units; }
+    // Instructions per cycle, 0 without both counters
+    double getIpc() const;
+};
+
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Open every counter the system offers for the calling thread, and with newThreads the
+    // threads it starts from now on; false if none. getError says why hardware counters
+    // are missing, if they are.
+    bool open(bool newThreads);
+    void close();
+    bool isOpen() const;
+    const std::string& getError() const { return error; }
+
+    // Count a section; stop adds it to the reading as units units. Each reads every
+    // counter, a few microseconds in all, so tiny sections are best measured in batches.
+    void start();
+    void stop(uint64_t units);
+
+    const PerfReading& getReading() const { return reading; }
+    // The reading so far, starting a new one
+    PerfReading takeReading();
+
+private:
+    void readCounts(double* counts) const;
+
+    int fds[PERF_COUNTER_COUNT];
+    double startCounts[PERF_COUNTER_COUNT] = {};
+    bool started = false;
+    PerfReading reading;
+    std::string error;
+};
+
+// One line for status displays: "2.10M cycles/gen, IPC 2.85, misses/gen L1D 12.0k LLC 310
+// branch 1.20k, 0.75 ms CPU/gen", with n/a for counters not available
+std::string describeCounters(const PerfReading& reading, const char* unit);
+
+#endif // PERF_COUNTERS_H
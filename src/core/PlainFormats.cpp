@@ -0,0 +1,397 @@
+#include "PlainFormats.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+const size_t READ_CHUNK = 1 << 20;   // Bytes read from a pattern file at a time
+const size_t WRITE_BUFFER = 1 << 16; // Bytes buffered before a write
+const long long MAX_PATTERN_SIDE = 1LL << 30;
+
+// Call onLine(begin, end) for every line of the file without its line break, reading the
+// file in large chunks; a line cut by a chunk boundary is carried over to the next chunk.
+// Stops when onLine returns false, which must then have filled error.
+template <typename OnLine>
+bool forEachLine(const std::string& path, std::string& error, OnLine onLine) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    std::vector<char> buffer(READ_CHUNK);
+    size_t kept = 0; // Bytes of an unfinished line at the start of the buffer
+    bool ok = true;
+    while (ok) {
+        if (kept == buffer.size()) {
+            buffer.resize(buffer.size() * 2); // A line longer than the buffer
+        }
+        size_t length = std::fread(buffer.data() + kept, 1, buffer.size() - kept, file);
+        const char* line = buffer.data();
+        const char* end = line + kept + length;
+        while (ok) {
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+            if (newline == nullptr) {
+                break;
+            }
+            ok = onLine(line, newline > line && newline[-1] == '\r' ? newline - 1 : newline);
+            line = newline + 1;
+        }
+        kept = end - line;
+        if (length == 0) {
+            if (ok && kept > 0) {
+                ok = onLine(line, line[kept - 1] == '\r' ? end - 1 : end); // No break after the last line
+            }
+            break;
+        }
+        std::memmove(buffer.data(), line, kept);
+    }
+    if (ok && std::ferror(file)) {
+        error = "Failed to read " + path;
+        ok = false;
+    }
+    std::fclose(file);
+    return ok;
+}
+
+bool allocatePattern(Pattern& pattern, long long width, long long height, const std::string& path, std::string& error) {
+    if (width > MAX_PATTERN_SIDE || height > MAX_PATTERN_SIDE) {
+        error = "Pattern too large in " + path;
+        return false;
+    }
+    pattern.width = static_cast<int>(width);
+    pattern.height = static_cast<int>(height);
+    pattern.wordsPerRow = static_cast<int>((width + 63) / 64);
+    pattern.rule.clear();
+    try {
+        pattern.words.assign(static_cast<size_t>(pattern.wordsPerRow) * pattern.height, 0);
+    } catch (const std::bad_alloc&) {
+        error = "Pattern too large in " + path;
+        return false;
+    }
+    return true;
+}
+
+// Buffered output for the text writers
+class TextWriter {
+public:
+    explicit TextWriter(std::FILE* outputFile) : file(outputFile) {
+        buffer.reserve(WRITE_BUFFER + 64);
+    }
+
+    void write(const char* text, size_t length) {
+        buffer.append(text, length);
+        if (buffer.size() >= WRITE_BUFFER) {
+            flush();
+        }
+    }
+
+    bool finish() {
+        flush();
+        return ok;
+    }
+
+private:
+    std::FILE* file;
+    std::string buffer;
+    bool ok = true;
+
+    void flush() {
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            ok = false;
+        }
+        buffer.clear();
+    }
+};
+
+bool closeWritten(std::FILE* file, bool ok, const std::string& path, std::string& error) {
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        error = "Failed to write " + path;
+    }
+    return ok;
+}
+
+// Text of eight cells for each byte of a row, lowest bit first
+struct CellText {
+    char cells[256][8];
+    CellText() {
+        for (int byte = 0; byte < 256; ++byte) {
+            for (int bit = 0; bit < 8; ++bit) {
+                cells[byte][bit] = (byte >> bit) & 1 ? 'O' : '.';
+            }
+        }
+    }
+};
+
+// PBM bytes hold the leftmost pixel in the high bit, grid words in the low bit
+struct ReversedBits {
+    uint8_t bytes[256] = {};
+    ReversedBits() {
+        for (int byte = 0; byte < 256; ++byte) {
+            for (int bit = 0; bit < 8; ++bit) {
+                bytes[byte] |= ((byte >> bit) & 1) << (7 - bit);
+            }
+        }
+    }
+};
+
+bool readCells(const std::string& path, Pattern& pattern, std::string& error) {
+    // Rows are packed as they are read, since the width is only known at the end
+    std::vector<std::vector<uint64_t>> rows;
+    size_t width = 0;
+    bool ok = forEachLine(path, error, [&](const char* begin, const char* end) {
+        if (begin < end && *begin == '!') {
+            return true;
+        }
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+            --end;
+        }
+        std::vector<uint64_t> row((end - begin + 63) / 64, 0);
+        for (const char* c = begin; c < end; ++c) {
+            if (*c == 'O' || *c == '*') {
+                size_t x = c - begin;
+                row[x >> 6] |= 1ULL << (x & 63);
+            } else if (*c != '.') {
+                error = std::string("Unexpected '") + *c + "' in " + path;
+                return false;
+            }
+        }
+        width = std::max(width, static_cast<size_t>(end - begin));
+        rows.push_back(std::move(row));
+        return true;
+    });
+    if (!ok || !allocatePattern(pattern, static_cast<long long>(width), static_cast<long long>(rows.size()), path, error)) {
+        return false;
+    }
+    for (size_t y = 0; y < rows.size(); ++y) {
+        std::copy(rows[y].begin(), rows[y].end(), pattern.words.begin() + y * pattern.wordsPerRow);
+    }
+    return true;
+}
+
+bool writeCells(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    static const CellText cellText;
+    TextWriter writer(file);
+    std::vector<char> line(static_cast<size_t>(wordsPerRow) * 64 + 1);
+    for (int y = 0; y < height; ++y) {
+        // Dead cells after the last live one are left out
+        const uint64_t* row = words + static_cast<size_t>(y) * wordsPerRow;
+        int length = 0;
+        for (int w = wordsPerRow - 1; w >= 0; --w) {
+            if (row[w] != 0) {
+                length = std::min(width, w * 64 + 64 - __builtin_clzll(row[w]));
+                break;
+            }
+        }
+        for (int x = 0; x < length; x += 8) {
+            std::memcpy(&line[x], cellText.cells[(row[x >> 6] >> (x & 63)) & 0xFF], 8);
+        }
+        line[length] = '\n';
+        writer.write(line.data(), length + 1);
+    }
+    return closeWritten(file, writer.finish(), path, error);
+}
+
+bool readLife106(const std::string& path, Pattern& pattern, std::string& error) {
+    // Coordinates are gathered first, since the bounding box is only known at the end
+    std::vector<int32_t> coordinates;
+    long long minX = 0, minY = 0, maxX = -1, maxY = -1;
+    bool first = true;
+    bool ok = forEachLine(path, error, [&](const char* begin, const char* end) {
+        if (first) {
+            first = false;
+            if (end - begin < 10 || std::strncmp(begin, "#Life 1.0", 9) != 0 || begin[9] != '6') {
+                error = path + " is not a Life 1.06 file" + (end - begin >= 10 && begin[9] == '5' ? " (Life 1.05 is not supported)" : "");
+                return false;
+            }
+            return true;
+        }
+        while (begin < end && (*begin == ' ' || *begin == '\t')) {
+            ++begin;
+        }
+        if (begin == end || *begin == '#') {
+            return true;
+        }
+
+        long long x, y;
+        auto parsedX = std::from_chars(begin, end, x);
+        const char* next = parsedX.ptr;
+        while (next < end && (*next == ' ' || *next == '\t')) {
+            ++next;
+        }
+        auto parsedY = std::from_chars(next, end, y);
+        if (parsedX.ec != std::errc() || parsedY.ec != std::errc() || next == parsedX.ptr ||
+            x < -MAX_PATTERN_SIDE || x > MAX_PATTERN_SIDE || y < -MAX_PATTERN_SIDE || y > MAX_PATTERN_SIDE) {
+            error = "Bad coordinates in " + path + ": " + std::string(begin, end);
+            return false;
+        }
+        if (maxX < minX) {
+            minX = maxX = x;
+            minY = maxY = y;
+        } else {
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+        coordinates.push_back(static_cast<int32_t>(x));
+        coordinates.push_back(static_cast<int32_t>(y));
+        return true;
+    });
+    if (ok && first) {
+        error = path + " is empty";
+        ok = false;
+    }
+    if (!ok || !allocatePattern(pattern, maxX - minX + 1, maxY - minY + 1, path, error)) {
+        return false;
+    }
+    for (size_t i = 0; i < coordinates.size(); i += 2) {
+        size_t x = static_cast<size_t>(coordinates[i] - minX);
+        size_t y = static_cast<size_t>(coordinates[i + 1] - minY);
+        pattern.words[y * pattern.wordsPerRow + (x >> 6)] |= 1ULL << (x & 63);
+    }
+    return true;
+}
+
+bool writeLife106(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    TextWriter writer(file);
+    writer.write("#Life 1.06\n", 11);
+    char line[32]; // Two numbers of at most 10 digits each, a space and a line break
+    for (int y = 0; y < height; ++y) {
+        const uint64_t* row = words + static_cast<size_t>(y) * wordsPerRow;
+        for (int w = 0; w < wordsPerRow; ++w) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                int x = w * 64 + __builtin_ctzll(bits);
+                if (x >= width) {
+                    break;
+                }
+                char* end = std::to_chars(line, line + 12, x).ptr;
+                *end++ = ' ';
+                end = std::to_chars(end, end + 12, y).ptr;
+                *end++ = '\n';
+                writer.write(line, end - line);
+            }
+        }
+    }
+    return closeWritten(file, writer.finish(), path, error);
+}
+
+// Next header token of a PBM file: whitespace and '#' comments are skipped
+bool nextPbmToken(const char* data, size_t length, size_t& position, size_t& tokenStart) {
+    while (position < length) {
+        char c = data[position];
+        if (c == '#') {
+            while (position < length && data[position] != '\n') {
+                ++position;
+            }
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            ++position;
+        } else {
+            break;
+        }
+    }
+    tokenStart = position;
+    while (position < length && data[position] != ' ' && data[position] != '\t' && data[position] != '\r' &&
+           data[position] != '\n' && data[position] != '#') {
+        ++position;
+    }
+    return position > tokenStart;
+}
+
+bool readPbm(const std::string& path, Pattern& pattern, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "Failed to open " + path;
+        return false;
+    }
+
+    // The header fits in the first chunk
+    std::vector<char> buffer(READ_CHUNK);
+    size_t length = std::fread(buffer.data(), 1, buffer.size(), file);
+    size_t position = 0;
+    size_t token;
+    long long width = -1, height = -1;
+    bool ok = nextPbmToken(buffer.data(), length, position, token) && position - token == 2 && buffer[token] == 'P' &&
+              (buffer[token + 1] == '1' || buffer[token + 1] == '4');
+    bool raw = ok && buffer[token + 1] == '4';
+    for (long long* side : {&width, &height}) {
+        ok = ok && nextPbmToken(buffer.data(), length, position, token) &&
+             std::from_chars(&buffer[token], &buffer[position], *side).ptr == &buffer[position] && *side >= 0;
+    }
+    if (!ok) {
+        std::fclose(file);
+        error = path + " is not a PBM file";
+        return false;
+    }
+    if (!allocatePattern(pattern, width, height, path, error)) {
+        std::fclose(file);
+        return false;
+    }
+
+    if (raw) {
+        // Rows of bytes, leftmost pixel in the high bit, after a single whitespace character
+        static const ReversedBits reversed;
+        size_t rowBytes = static_cast<size_t>((width + 7) / 8);
+        std::vector<uint8_t> row(rowBytes);
+        std::fseek(file, static_cast<long>(position + 1), SEEK_SET);
+        for (int y = 0; ok && y < pattern.height; ++y) {
+            ok = std::fread(row.data(), 1, rowBytes, file) == rowBytes;
+            uint64_t* words = &pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow];
+            for (size_t i = 0; ok && i < rowBytes; ++i) {
+                words[i >> 3] |= static_cast<uint64_t>(reversed.bytes[row[i]]) << ((i & 7) * 8);
+            }
+            if (ok && (width & 63) != 0) {
+                words[pattern.wordsPerRow - 1] &= (1ULL << (width & 63)) - 1; // Padding bits
+            }
+        }
+    } else {
+        // One '0' or '1' per pixel, whitespace anywhere between them
+        long long cell = 0;
+        long long cells = width * height;
+        while (cell < cells) {
+            for (; position < length && cell < cells; ++position) {
+                char c = buffer[position];
+                if (c == '0' || c == '1') {
+                    if (c == '1') {
+                        size_t x = static_cast<size_t>(cell % width);
+                        pattern.words[static_cast<size_t>(cell / width) * pattern.wordsPerRow + (x >> 6)] |= 1ULL << (x & 63);
+                    }
+                    ++cell;
+                } else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+                    error = std::string("Unexpected '") + c + "' in " + path;
+                    std::fclose(file);
+                    return false;
+                }
+            }
+            if (cell < cells) {
+                length = std::fread(buffer.data(), 1, buffer.size(), file);
+                position = 0;
+                if (length == 0) {
+                    break;
+                }
+            }
+        }
+        ok = cell == cells;
+    }
+    std::fclose(file);
+    if (!ok) {
+        error = path + " is truncated";
+    }
+    return ok;
+}
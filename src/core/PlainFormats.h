@@ -0,0 +1,25 @@
+#ifndef PLAIN_FORMATS_H
+#define PLAIN_FORMATS_H
+
+#include <string>
+#include <cstdint>
+#include "PatternIO.h"
+
+// Simple pattern formats found in pattern collections. None of them carries a rule, so the
+// patterns read come with an empty rule and the board keeps its own. Files are scanned in
+// large chunks and numbers parsed with std::from_chars, never token by token from a stream.
+
+// Plaintext .cells: '!' comment lines, then one line per row, '.' dead and 'O' alive.
+// Rows may be ragged; missing cells are dead.
+bool readCells(const std::string& path, Pattern& pattern, std::string& error);
+bool writeCells(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height, std::string& error);
+
+// Life 1.06: a "#Life 1.06" line, then one "x y" line per live cell. Coordinates may be
+// negative; the pattern is their bounding box.
+bool readLife106(const std::string& path, Pattern& pattern, std::string& error);
+bool writeLife106(const std::string& path, const uint64_t* words, int wordsPerRow, int width, int height, std::string& error);
+
+// Plain (P1) or raw (P4) PBM bitmaps, black pixels alive, as written by exportImage
+bool readPbm(const std::string& path, Pattern& pattern, std::string& error);
+
+#endif // PLAIN_FORMATS_H
@@ -0,0 +1,211 @@
+#include "PopulationPyramid.h"
+#include <algorithm>
+
+void PopulationPyramid::resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    levels.clear();
+
+    // Level 0 is the tile map, every further level groups 8x8 blocks until one block covers the board
+    Level level;
+    level.width = (width + TILE_SIZE - 1) / TILE_SIZE;
+    level.height = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tiles.assign(static_cast<size_t>(level.width) * level.height, 0);
+    levels.push_back(level);
+
+    while (levels.back().width > 1 || levels.back().height > 1) {
+        Level parent;
+        parent.width = (levels.back().width + TILE_SIZE - 1) / TILE_SIZE;
+        parent.height = (levels.back().height + TILE_SIZE - 1) / TILE_SIZE;
+        parent.counts.assign(static_cast<size_t>(parent.width) * parent.height, 0);
+        levels.push_back(parent);
+    }
+}
+
+// Count the live cells of one tile: a byte of the same word in eight consecutive rows
+int PopulationPyramid::tileCount(const uint64_t* words, int wordsPerRow, int tileX, int tileY) const {
+    int word = tileX >> BLOCK_SHIFT;
+    int shift = (tileX & (TILE_SIZE - 1)) * 8;
+    int yEnd = std::min((tileY + 1) * TILE_SIZE, height);
+
+    int count = 0;
+    for (int y = tileY * TILE_SIZE; y < yEnd; ++y) {
+        count += __builtin_popcountll((words[static_cast<size_t>(y) * wordsPerRow + word] >> shift) & 0xFF);
+    }
+    return count;
+}
+
+void PopulationPyramid::rebuild(const uint64_t* words, int wordsPerRow) {
+    const Level& tileLevel = levels[0];
+    for (int ty = 0; ty < tileLevel.height; ++ty) {
+        for (int tx = 0; tx < tileLevel.width; ++tx) {
+            tiles[static_cast<size_t>(ty) * tileLevel.width + tx] = static_cast<uint8_t>(tileCount(words, wordsPerRow, tx, ty));
+        }
+    }
+
+    // Sum each level into its parent
+    for (size_t l = 1; l < levels.size(); ++l) {
+        Level& parent = levels[l];
+        const Level& child = levels[l - 1];
+        std::fill(parent.counts.begin(), parent.counts.end(), 0);
+
+        for (int by = 0; by < child.height; ++by) {
+            for (int bx = 0; bx < child.width; ++bx) {
+                size_t index = static_cast<size_t>(by) * child.width + bx;
+                uint64_t count = l == 1 ? tiles[index] : child.counts[index];
+                parent.counts[static_cast<size_t>(by >> BLOCK_SHIFT) * parent.width + (bx >> BLOCK_SHIFT)] += count;
+            }
+        }
+    }
+}
+
+void PopulationPyramid::updateTiles(const uint64_t* words, int wordsPerRow, const std::vector<uint32_t>& changedTiles) {
+    const int tilesPerRow = levels[0].width;
+
+    for (uint32_t tile : changedTiles) {
+        int tx = static_cast<int>(tile % tilesPerRow);
+        int ty = static_cast<int>(tile / tilesPerRow);
+        int count = tileCount(words, wordsPerRow, tx, ty);
+        int delta = count - tiles[tile];
+        if (delta == 0) {
+            continue;
+        }
+
+        // Only the ancestors of a changed tile need their counts adjusted
+        tiles[tile] = static_cast<uint8_t>(count);
+        for (size_t l = 1; l < levels.size(); ++l) {
+            int shift = BLOCK_SHIFT * static_cast<int>(l);
+            levels[l].counts[static_cast<size_t>(ty >> shift) * levels[l].width + (tx >> shift)] += delta;
+        }
+    }
+}
+
+void PopulationPyramid::addCell(int x, int y, int delta) {
+    int tx = x >> BLOCK_SHIFT;
+    int ty = y >> BLOCK_SHIFT;
+    tiles[static_cast<size_t>(ty) * levels[0].width + tx] += delta;
+
+    for (size_t l = 1; l < levels.size(); ++l) {
+        int shift = BLOCK_SHIFT * static_cast<int>(l);
+        levels[l].counts[static_cast<size_t>(ty >> shift) * levels[l].width + (tx >> shift)] += delta;
+    }
+}
+
+uint64_t PopulationPyramid::getBlockPopulation(int level, int blockX, int blockY) const {
+    if (level < 0 || level >= getLevelCount() || blockX < 0 || blockX >= levels[level].width ||
+        blockY < 0 || blockY >= levels[level].height) {
+        return 0;
+    }
+
+    size_t index = static_cast<size_t>(blockY) * levels[level].width + blockX;
+    return level == 0 ? tiles[index] : levels[level].counts[index];
+}
+
+uint64_t PopulationPyramid::getPopulation() const {
+    uint64_t population = 0;
+    int top = getLevelCount() - 1;
+    for (int by = 0; by < levels[top].height; ++by) {
+        for (int bx = 0; bx < levels[top].width; ++bx) {
+            population += getBlockPopulation(top, bx, by);
+        }
+    }
+    return population;
+}
+
+// Count the live cells of one block inside the query rectangle, descending only into
+// blocks that are populated and partially covered
+uint64_t PopulationPyramid::countBlock(const uint64_t* words, int wordsPerRow, int level, int blockX, int blockY,
+                                       int x0, int y0, int x1, int y1, bool stopAtFirst) const {
+    uint64_t population = getBlockPopulation(level, blockX, blockY);
+    if (population == 0) {
+        return 0;
+    }
+
+    int64_t size = getBlockSize(level);
+    int64_t bx0 = blockX * size;
+    int64_t by0 = blockY * size;
+    int64_t bx1 = std::min<int64_t>(bx0 + size, width);
+    int64_t by1 = std::min<int64_t>(by0 + size, height);
+    if (bx0 >= x0 && bx1 <= x1 && by0 >= y0 && by1 <= y1) {
+        return population;
+    }
+
+    // Inside the query rectangle, so back within int
+    int cx0 = static_cast<int>(std::max<int64_t>(x0, bx0));
+    int cy0 = static_cast<int>(std::max<int64_t>(y0, by0));
+    int cx1 = static_cast<int>(std::min<int64_t>(x1, bx1));
+    int cy1 = static_cast<int>(std::min<int64_t>(y1, by1));
+
+    if (level == 0) {
+        // A tile never straddles a word, so the covered columns are one mask
+        uint64_t mask = (cx1 - cx0 == 64 ? ~0ULL : ((1ULL << (cx1 - cx0)) - 1)) << (cx0 & 63);
+        uint64_t count = 0;
+        for (int y = cy0; y < cy1; ++y) {
+            count += __builtin_popcountll(words[static_cast<size_t>(y) * wordsPerRow + (cx0 >> 6)] & mask);
+            if (stopAtFirst && count > 0) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    int64_t childSize = getBlockSize(level - 1);
+    uint64_t count = 0;
+    for (int cy = static_cast<int>(cy0 / childSize); cy <= (cy1 - 1) / childSize; ++cy) {
+        for (int cx = static_cast<int>(cx0 / childSize); cx <= (cx1 - 1) / childSize; ++cx) {
+            count += countBlock(words, wordsPerRow, level - 1, cx, cy, x0, y0, x1, y1, stopAtFirst);
+            if (stopAtFirst && count > 0) {
+                return count;
+            }
+        }
+    }
+    return count;
+}
+
+uint64_t PopulationPyramid::countLiveCells(const uint64_t* words, int wordsPerRow, int x0, int y0, int x1, int y1) const {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width);
+    y1 = std::min(y1, height);
+    if (x0 >= x1 || y0 >= y1) {
+        return 0;
+    }
+
+    int top = getLevelCount() - 1;
+    int64_t size = getBlockSize(top);
+    uint64_t count = 0;
+    for (int by = static_cast<int>(y0 / size); by <= (y1 - 1) / size; ++by) {
+        for (int bx = static_cast<int>(x0 / size); bx <= (x1 - 1) / size; ++bx) {
+            count += countBlock(words, wordsPerRow, top, bx, by, x0, y0, x1, y1, false);
+        }
+    }
+    return count;
+}
+
+bool PopulationPyramid::isRegionEmpty(const uint64_t* words, int wordsPerRow, int x0, int y0, int x1, int y1) const {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width);
+    y1 = std::min(y1, height);
+    if (x0 >= x1 || y0 >= y1) {
+        return true;
+    }
+
+    // Start from the finest level whose blocks are still at least as large as the region's
+    // longer side, so the region spans at most 2x2 of them and an empty one is normally
+    // settled by a handful of block counts
+    int level = getLevelCount() - 1;
+    while (level > 0 && getBlockSize(level - 1) >= std::max(x1 - x0, y1 - y0)) {
+        --level;
+    }
+
+    int64_t size = getBlockSize(level);
+    for (int by = static_cast<int>(y0 / size); by <= (y1 - 1) / size; ++by) {
+        for (int bx = static_cast<int>(x0 / size); bx <= (x1 - 1) / size; ++bx) {
+            if (countBlock(words, wordsPerRow, level, bx, by, x0, y0, x1, y1, true) > 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef POPULATION_PYRAMID_H
+#define POPULATION_PYRAMID_H
+
+#include <vector>
+#include <cstdint>
+
+// Multi-resolution live-cell counts over a bit-packed board.
+// Level 0 counts 8x8 tiles, level 1 counts 64x64 blocks, level 2 512x512 blocks and so on,
+// each level grouping 8x8 blocks of the level below, up to a level that covers the board
+// with a single block. Rows are packed 64 cells per word, bit (x % 64) of word (x / 64).
+class PopulationPyramid {
+public:
+    static const int BLOCK_SHIFT = 3;  // log2 of the fan-out per axis between levels
+    static const int TILE_SIZE = 1 << BLOCK_SHIFT;
+
+    void resize(int width, int height);
+
+    // Recount every tile from scratch, used after bulk edits
+    void rebuild(const uint64_t* words, int wordsPerRow);
+
+    // Recount the given tiles (indices into the level 0 map) and push the differences upwards
+    void updateTiles(const uint64_t* words, int wordsPerRow, const std::vector<uint32_t>& tiles);
+
+    // Adjust the counts for a single cell that was set (+1) or cleared (-1)
+    void addCell(int x, int y, int delta);
+
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+    // In 64 bits: the top blocks of boards past 2^30 cells a side outgrow an int
+    int64_t getBlockSize(int level) const { return static_cast<int64_t>(TILE_SIZE) << (BLOCK_SHIFT * level); }
+    int getLevelWidth(int level) const { return levels[level].width; }
+    int getLevelHeight(int level) const { return levels[level].height; }
+    int getTilesPerRow() const { return levels.empty() ? 0 : levels[0].width; }
+    uint64_t getBlockPopulation(int level, int blockX, int blockY) const;
+    uint64_t getPopulation() const;
+
+    // Region queries over the half-open rectangle [x0, x1) x [y0, y1); empty blocks are
+    // skipped whole and fully covered blocks are answered from their count
+    uint64_t countLiveCells(const uint64_t* words, int wordsPerRow, int x0, int y0, int x1, int y1) const;
+    bool isRegionEmpty(const uint64_t* words, int wordsPerRow, int x0, int y0, int x1, int y1) const;
+
+private:
+    struct Level {
+        int width = 0;   // Blocks per row
+        int height = 0;  // Block rows
+        std::vector<uint64_t> counts;  // Unused on level 0, which lives in the tile map
+    };
+
+    int tileCount(const uint64_t* words, int wordsPerRow, int tileX, int tileY) const;
+    uint64_t countBlock(const uint64_t* words, int wordsPerRow, int level, int blockX, int blockY,
+                        int x0, int y0, int x1, int y1, bool stopAtFirst) const;
+
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> tiles;  // Level 0 counts, at most 64 per tile
+    std::vector<Level> levels;
+};
+
+#endif // POPULATION_PYRAMID_H
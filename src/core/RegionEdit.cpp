@@ -0,0 +1,168 @@
+#include "RegionEdit.h"
+#include <algorithm>
+#include <random>
+
+// 64 bits of a row starting at bit, dead past the row's last word
+inline uint64_t loadBits(const uint64_t* row, int wordCount, int64_t bit) {
+    int64_t word = bit >> 6;
+    int shift = static_cast<int>(bit & 63);
+    uint64_t low = word < wordCount ? row[word] >> shift : 0;
+    uint64_t high = shift != 0 && word + 1 < wordCount ? row[word + 1] << (64 - shift) : 0;
+    return low | high;
+}
+
+// Mask of bits [from, to) of word w
+inline uint64_t spanMask(int64_t w, int64_t from, int64_t to) {
+    int64_t start = std::max<int64_t>(from - w * 64, 0);
+    int64_t end = std::min<int64_t>(to - w * 64, 64);
+    uint64_t upTo = end == 64 ? ~0ULL : (1ULL << end) - 1;
+    return upTo & ~((1ULL << start) - 1);
+}
+
+// Copy count bits from sourceBit of one row to targetBit of another, a target word at a time
+void copyBits(const uint64_t* source, int sourceWords, int64_t sourceBit, uint64_t* target, int64_t targetBit, int64_t count, bool merge) {
+    if (count <= 0) {
+        return;
+    }
+    int64_t end = targetBit + count;
+    for (int64_t w = targetBit >> 6; w <= (end - 1) >> 6; ++w) {
+        // Bit 0 of target word w lines up with this bit of the source
+        int64_t offset = sourceBit + (w * 64 - targetBit);
+        uint64_t bits = offset >= 0 ? loadBits(source, sourceWords, offset) : loadBits(source, sourceWords, sourceBit) << (targetBit - w * 64);
+        uint64_t mask = spanMask(w, targetBit, end);
+        target[w] = merge ? target[w] | (bits & mask) : (target[w] & ~mask) | (bits & mask);
+    }
+}
+
+Pattern extractRegion(const uint64_t* words, int wordsPerRow, int width, int height, int x, int y, int w, int h) {
+    Pattern pattern;
+    pattern.width = std::max(w, 0);
+    pattern.height = std::max(h, 0);
+    pattern.wordsPerRow = (pattern.width + 63) / 64;
+    pattern.words.assign(static_cast<size_t>(pattern.wordsPerRow) * pattern.height, 0);
+    pattern.rule.clear();
+
+    int x0 = std::max(x, 0);
+    int x1 = std::min(x + pattern.width, width);
+    for (int row = std::max(y, 0); row < std::min(y + pattern.height, height) && x0 < x1; ++row) {
+        copyBits(words + static_cast<size_t>(row) * wordsPerRow, wordsPerRow, x0,
+                 &pattern.words[static_cast<size_t>(row - y) * pattern.wordsPerRow], x0 - x, x1 - x0, false);
+    }
+    return pattern;
+}
+
+void stampPattern(const Pattern& pattern, uint64_t* words, int wordsPerRow, int width, int height, int x, int y, bool merge) {
+    int x0 = std::max(x, 0);
+    int x1 = std::min(x + pattern.width, width);
+    for (int row = std::max(y, 0); row < std::min(y + pattern.height, height) && x0 < x1; ++row) {
+        copyBits(&pattern.words[static_cast<size_t>(row - y) * pattern.wordsPerRow], pattern.wordsPerRow, x0 - x,
+                 words + static_cast<size_t>(row) * wordsPerRow, x0, x1 - x0, merge);
+    }
+}
+
+void fillRegion(uint64_t* words, int wordsPerRow, int width, int height, int x, int y, int w, int h, RegionEdit edit, uint64_t seed) {
+    int x0 = std::max(x, 0);
+    int x1 = std::min(x + w, width);
+    if (x0 >= x1) {
+        return;
+    }
+    std::mt19937_64 random(seed);
+    for (int row = std::max(y, 0); row < std::min(y + h, height); ++row) {
+        uint64_t* cells = words + static_cast<size_t>(row) * wordsPerRow;
+        for (int word = x0 >> 6; word <= (x1 - 1) >> 6; ++word) {
+            uint64_t mask = spanMask(word, x0, x1);
+            switch (edit) {
+                case EDIT_CLEAR:
+                    cells[word] &= ~mask;
+                    break;
+                case EDIT_FILL:
+                    cells[word] |= mask;
+                    break;
+                case EDIT_INVERT:
+                    cells[word] ^= mask;
+                    break;
+                case EDIT_RANDOM:
+                    cells[word] = (cells[word] & ~mask) | (random() & mask);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+// Transpose a 64x64 bit matrix in place, row r being word r: swap the off-diagonal 32x32
+// blocks, then the 16x16 blocks within each quarter, and so on down to single bits
+void transpose64(uint64_t* rows) {
+    uint64_t mask = 0x00000000FFFFFFFFULL;
+    for (int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            uint64_t swap = ((rows[k] >> j) ^ rows[k | j]) & mask;
+            rows[k] ^= swap << j;
+            rows[k | j] ^= swap;
+        }
+    }
+}
+
+Pattern transposePattern(const Pattern& pattern) {
+    Pattern result;
+    result.width = pattern.height;
+    result.height = pattern.width;
+    result.wordsPerRow = (result.width + 63) / 64;
+    result.words.assign(static_cast<size_t>(result.wordsPerRow) * result.height, 0);
+    result.rule = pattern.rule;
+
+    // Block (bx, by) of 64x64 cells becomes block (by, bx), transposed
+    uint64_t block[64];
+    for (int by = 0; by < result.wordsPerRow; ++by) {
+        for (int bx = 0; bx < pattern.wordsPerRow; ++bx) {
+            for (int r = 0; r < 64; ++r) {
+                int row = by * 64 + r;
+                block[r] = row < pattern.height ? pattern.words[static_cast<size_t>(row) * pattern.wordsPerRow + bx] : 0;
+            }
+            transpose64(block);
+            for (int r = 0; r < 64 && bx * 64 + r < result.height; ++r) {
+                result.words[static_cast<size_t>(bx * 64 + r) * result.wordsPerRow + by] = block[r];
+            }
+        }
+    }
+    return result;
+}
+
+inline uint64_t reverseBits(uint64_t value) {
+    value = ((value >> 1) & 0x5555555555555555ULL) | ((value & 0x5555555555555555ULL) << 1);
+    value = ((value >> 2) & 0x3333333333333333ULL) | ((value & 0x3333333333333333ULL) << 2);
+    value = ((value >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((value & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(value);
+}
+
+void flipPattern(Pattern& pattern, bool horizontal) {
+    if (!horizontal) {
+        for (int row = 0; row < pattern.height / 2; ++row) {
+            std::swap_ranges(pattern.words.begin() + static_cast<size_t>(row) * pattern.wordsPerRow,
+                             pattern.words.begin() + static_cast<size_t>(row + 1) * pattern.wordsPerRow,
+                             pattern.words.begin() + static_cast<size_t>(pattern.height - 1 - row) * pattern.wordsPerRow);
+        }
+        return;
+    }
+    // Reverse the words of a row and the bits of each, then shift out the padding that the
+    // unused tail of the last word turned into
+    std::vector<uint64_t> reversed(pattern.wordsPerRow);
+    int padding = pattern.wordsPerRow * 64 - pattern.width;
+    for (int row = 0; row < pattern.height; ++row) {
+        uint64_t* cells = &pattern.words[static_cast<size_t>(row) * pattern.wordsPerRow];
+        for (int w = 0; w < pattern.wordsPerRow; ++w) {
+            reversed[w] = reverseBits(cells[pattern.wordsPerRow - 1 - w]);
+        }
+        for (int w = 0; w < pattern.wordsPerRow; ++w) {
+            cells[w] = loadBits(reversed.data(), pattern.wordsPerRow, static_cast<int64_t>(w) * 64 + padding);
+        }
+    }
+}
+
+// Clockwise is a transpose mirrored left to right, counterclockwise one mirrored top to bottom
+Pattern rotatePattern(const Pattern& pattern, bool clockwise) {
+    Pattern result = transposePattern(pattern);
+    flipPattern(result, clockwise);
+    return result;
+}
@@ -0,0 +1,40 @@
+#ifndef REGION_EDIT_H
+#define REGION_EDIT_H
+
+#include <cstdint>
+#include "PatternIO.h"
+
+// Rectangle edits on bit-packed boards and patterns (the layout of PatternIO.h). Everything
+// works on whole 64-bit words: rows are copied by shifting word pairs into place, fills use
+// masked word writes and rotations 64x64 bit-matrix transposes, so a million-cell rectangle
+// costs tens of thousands of word operations rather than a million cell calls.
+
+enum RegionEdit {
+    EDIT_CLEAR,
+    EDIT_FILL,
+    EDIT_INVERT,
+    EDIT_RANDOM,            // Each cell alive with 50% chance, from a seed
+    EDIT_ROTATE_CLOCKWISE,  // Rotations keep the top-left corner, so the rectangle turns on it
+    EDIT_ROTATE_COUNTERCLOCKWISE,
+    EDIT_FLIP_HORIZONTAL,   // Mirror left to right
+    EDIT_FLIP_VERTICAL,     // Mirror top to bottom
+    EDIT_COUNT
+};
+
+// The w x h rectangle with its top-left corner at (x, y), which may reach past the board;
+// cells outside the board are dead. The pattern has no rule.
+Pattern extractRegion(const uint64_t* words, int wordsPerRow, int width, int height, int x, int y, int w, int h);
+
+// Write a pattern with its top-left corner at (x, y), clipped to the board, so x and y may
+// be negative. merge ORs the live cells in; otherwise the pattern's dead cells are written too.
+void stampPattern(const Pattern& pattern, uint64_t* words, int wordsPerRow, int width, int height, int x, int y, bool merge);
+
+// Clear, fill, invert or randomize the rectangle, clipped to the board
+void fillRegion(uint64_t* words, int wordsPerRow, int width, int height, int x, int y, int w, int h, RegionEdit edit, uint64_t seed);
+
+// Patterns turned or mirrored as a whole
+Pattern transposePattern(const Pattern& pattern); // Cell (x, y) moves to (y, x)
+Pattern rotatePattern(const Pattern& pattern, bool clockwise);
+void flipPattern(Pattern& pattern, bool horizontal);
+
+#endif // REGION_EDIT_H
@@ -0,0 +1,503 @@
+#include "SessionLog.h"
+#include "GameOfLife.h"
+#include "PatternIO.h"
+#include "BinarySnapshot.h"
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+
+const char SESSION_LOG_MAGIC[8] = {'G', 'O', 'L', 'L', 'O', 'G', '1', '\n'};
+
+// Records are a type byte, the generation as a signed varint delta from the generation the
+// previous event left the board at, then the fields of the type:
+//   Start           width, height, rule, seeded byte, then the 8-byte seed or the words as
+//                   runs of (zero words, literal words, the literals as 8 bytes each)
+//   Paint           signed x, signed y, size, state byte
+//   Reset           8-byte seed
+//   Place           path, signed x, signed y, then as the other loads
+//   Loads           path, next generation, width, height, 8-byte checksum
+//   End             width, height, 8-byte checksum
+//   Edit            signed x, signed y, width, height, edit, seed
+//   Paste           signed x, signed y, width, height, merge byte, the words as in Start
+// Unsigned numbers are LEB128 varints, signed ones zigzag encoded first, strings a varint
+// length and the bytes.
+
+FILE* sessionFile = nullptr;
+uint64_t sessionGeneration = 0; // Generation the last logged event left the board at
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void putSigned(std::string& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void putWord(std::string& out, uint64_t value) {
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<char>(value >> (i * 8));
+    }
+    out.append(bytes, 8);
+}
+
+void putString(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out += value;
+}
+
+// Most boards are largely empty, so runs of zero words are only counted
+void putWords(std::string& out, const std::vector<uint64_t>& words) {
+    size_t i = 0;
+    while (i < words.size()) {
+        size_t zeros = i;
+        while (zeros < words.size() && words[zeros] == 0) {
+            ++zeros;
+        }
+        size_t literals = zeros;
+        while (literals < words.size() && words[literals] != 0) {
+            ++literals;
+        }
+        putVarint(out, zeros - i);
+        putVarint(out, literals - zeros);
+        for (size_t w = zeros; w < literals; ++w) {
+            putWord(out, words[w]);
+        }
+        i = literals;
+    }
+}
+
+// Reads fields from a record, failing once past the end, so a truncated record is noticed
+struct LogReader {
+    const unsigned char* data;
+    size_t size;
+    size_t offset = 0;
+    bool failed = false;
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (offset >= size) {
+                break;
+            }
+            unsigned char byte = data[offset++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return static_cast<int64_t>((value >> 1) ^ (0 - (value & 1)));
+    }
+
+    int integer() {
+        int64_t value = signedVarint();
+        if (value < INT32_MIN || value > INT32_MAX) {
+            failed = true;
+            return 0;
+        }
+        return static_cast<int>(value);
+    }
+
+    uint64_t word() {
+        if (size - offset < 8) {
+            failed = true;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(data[offset++]) << (i * 8);
+        }
+        return value;
+    }
+
+    uint8_t byte() {
+        if (offset >= size) {
+            failed = true;
+            return 0;
+        }
+        return data[offset++];
+    }
+
+    std::string string() {
+        uint64_t length = varint();
+        if (failed || length > size - offset) {
+            failed = true;
+            return std::string();
+        }
+        std::string value(reinterpret_cast<const char*>(data + offset), length);
+        offset += length;
+        return value;
+    }
+};
+
+// Generation an event leaves the board at
+uint64_t generationAfter(const SessionEvent& event) {
+    switch (event.type) {
+        case SessionEventType::Reset:
+            return 0;
+        case SessionEventType::Load:
+        case SessionEventType::Place:
+        case SessionEventType::LoadSnapshot:
+        case SessionEventType::LoadCheckpoint:
+            return event.nextGeneration;
+        default:
+            return event.generation;
+    }
+}
+
+uint64_t boardChecksum() {
+    return checksumWords(getGrid().data(), getGrid().size());
+}
+
+// Encode and append one record, flushed so it survives a crash
+void writeEvent(const SessionEvent& event) {
+    std::string record;
+    record += static_cast<char>(event.type);
+    putSigned(record, static_cast<int64_t>(event.generation - sessionGeneration));
+    switch (event.type) {
+        case SessionEventType::Start:
+            putVarint(record, static_cast<uint64_t>(event.width));
+            putVarint(record, static_cast<uint64_t>(event.height));
+            putString(record, event.rule);
+            record += static_cast<char>(event.seeded);
+            if (event.seeded) {
+                putWord(record, event.seed);
+            } else {
+                putWords(record, event.words);
+            }
+            break;
+        case SessionEventType::Paint:
+            putSigned(record, event.x);
+            putSigned(record, event.y);
+            putVarint(record, static_cast<uint64_t>(event.size));
+            record += static_cast<char>(event.state);
+            break;
+        case SessionEventType::Clear:
+            break;
+        case SessionEventType::Reset:
+            putWord(record, event.seed);
+            break;
+        case SessionEventType::Load:
+        case SessionEventType::Place:
+        case SessionEventType::LoadSnapshot:
+        case SessionEventType::LoadCheckpoint:
+            putString(record, event.path);
+            if (event.type == SessionEventType::Place) {
+                putSigned(record, event.x);
+                putSigned(record, event.y);
+            }
+            putVarint(record, event.nextGeneration);
+            putVarint(record, static_cast<uint64_t>(event.width));
+            putVarint(record, static_cast<uint64_t>(event.height));
+            putWord(record, event.checksum);
+            break;
+        case SessionEventType::End:
+            putVarint(record, static_cast<uint64_t>(event.width));
+            putVarint(record, static_cast<uint64_t>(event.height));
+            putWord(record, event.checksum);
+            break;
+        case SessionEventType::Edit:
+        case SessionEventType::Paste:
+            putSigned(record, event.x);
+            putSigned(record, event.y);
+            putVarint(record, static_cast<uint64_t>(event.width));
+            putVarint(record, static_cast<uint64_t>(event.height));
+            if (event.type == SessionEventType::Edit) {
+                putVarint(record, static_cast<uint64_t>(event.edit));
+                putVarint(record, event.seed);
+            } else {
+                record += static_cast<char>(event.state);
+                putWords(record, event.words);
+            }
+            break;
+    }
+    std::fwrite(record.data(), 1, record.size(), sessionFile);
+    std::fflush(sessionFile);
+    sessionGeneration = generationAfter(event);
+}
+
+bool startSessionLog(const std::string& path, uint64_t generation, std::string& error) {
+    if (sessionFile != nullptr) {
+        stopSessionLog(generation);
+    }
+    sessionFile = std::fopen(path.c_str(), "wb");
+    if (sessionFile == nullptr) {
+        error = "Cannot write " + path;
+        return false;
+    }
+    std::fwrite(SESSION_LOG_MAGIC, 1, sizeof(SESSION_LOG_MAGIC), sessionFile);
+    sessionGeneration = 0; // Start is a delta from 0, i.e. its generation as is
+
+    SessionEvent start;
+    start.type = SessionEventType::Start;
+    start.generation = generation;
+    start.width = getGridWidth();
+    start.height = getGridHeight();
+    start.rule = getRule();
+    start.seeded = getBoardSeed(start.seed);
+    if (!start.seeded) {
+        start.words.assign(getGrid().begin(), getGrid().end());
+    }
+    writeEvent(start);
+    return true;
+}
+
+bool isSessionLogging() {
+    return sessionFile != nullptr;
+}
+
+void logSessionEvent(SessionEvent event) {
+    if (sessionFile == nullptr) {
+        return;
+    }
+    bool load = event.type == SessionEventType::Load || event.type == SessionEventType::Place ||
+                event.type == SessionEventType::LoadSnapshot || event.type == SessionEventType::LoadCheckpoint;
+    if (load || event.type == SessionEventType::End) {
+        event.width = getGridWidth();
+        event.height = getGridHeight();
+        event.checksum = boardChecksum();
+    }
+    writeEvent(event);
+}
+
+void stopSessionLog(uint64_t generation) {
+    if (sessionFile == nullptr) {
+        return;
+    }
+    SessionEvent end;
+    end.type = SessionEventType::End;
+    end.generation = generation;
+    logSessionEvent(end);
+    std::fclose(sessionFile);
+    sessionFile = nullptr;
+}
+
+// Words of a width x height pattern or board, as written by putWords
+bool readWords(LogReader& reader, int width, int height, std::vector<uint64_t>& words) {
+    size_t count = static_cast<size_t>(height) * ((width + 63) / 64);
+    words.clear();
+    while (words.size() < count && !reader.failed) {
+        uint64_t zeros = reader.varint();
+        uint64_t literals = reader.varint();
+        uint64_t left = count - words.size();
+        if (zeros + literals == 0 || zeros > left || literals > left - zeros || literals > (reader.size - reader.offset) / 8) {
+            return false;
+        }
+        words.resize(words.size() + zeros, 0);
+        for (uint64_t i = 0; i < literals; ++i) {
+            words.push_back(reader.word());
+        }
+    }
+    return !reader.failed;
+}
+
+// Decode one record; returns false if it is cut short or malformed
+bool readEvent(LogReader& reader, uint64_t previousGeneration, SessionEvent& event) {
+    event = SessionEvent();
+    uint8_t type = reader.byte();
+    if (type < static_cast<uint8_t>(SessionEventType::Start) || type > static_cast<uint8_t>(SessionEventType::Paste)) {
+        return false;
+    }
+    event.type = static_cast<SessionEventType>(type);
+    event.generation = previousGeneration + static_cast<uint64_t>(reader.signedVarint());
+    switch (event.type) {
+        case SessionEventType::Start: {
+            event.width = static_cast<int>(reader.varint());
+            event.height = static_cast<int>(reader.varint());
+            event.rule = reader.string();
+            event.seeded = reader.byte() != 0;
+            if (reader.failed || event.width <= 0 || event.height <= 0) {
+                return false;
+            }
+            if (event.seeded) {
+                event.seed = reader.word();
+                break;
+            }
+            if (!readWords(reader, event.width, event.height, event.words)) {
+                return false;
+            }
+            break;
+        }
+        case SessionEventType::Paint:
+            event.x = reader.integer();
+            event.y = reader.integer();
+            event.size = static_cast<int>(reader.varint());
+            event.state = reader.byte() != 0;
+            break;
+        case SessionEventType::Clear:
+            break;
+        case SessionEventType::Reset:
+            event.seed = reader.word();
+            break;
+        case SessionEventType::Load:
+        case SessionEventType::Place:
+        case SessionEventType::LoadSnapshot:
+        case SessionEventType::LoadCheckpoint:
+            event.path = reader.string();
+            if (event.type == SessionEventType::Place) {
+                event.x = reader.integer();
+                event.y = reader.integer();
+            }
+            event.nextGeneration = reader.varint();
+            event.width = static_cast<int>(reader.varint());
+            event.height = static_cast<int>(reader.varint());
+            event.checksum = reader.word();
+            break;
+        case SessionEventType::End:
+            event.width = static_cast<int>(reader.varint());
+            event.height = static_cast<int>(reader.varint());
+            event.checksum = reader.word();
+            break;
+        case SessionEventType::Edit:
+        case SessionEventType::Paste:
+            event.x = reader.integer();
+            event.y = reader.integer();
+            event.width = static_cast<int>(reader.varint());
+            event.height = static_cast<int>(reader.varint());
+            if (reader.failed || event.width < 0 || event.height < 0) {
+                return false;
+            }
+            if (event.type == SessionEventType::Edit) {
+                event.edit = static_cast<int>(reader.varint());
+                event.seed = reader.varint();
+                if (event.edit < 0 || event.edit >= EDIT_COUNT) {
+                    return false;
+                }
+            } else {
+                event.state = reader.byte() != 0;
+                if (!readWords(reader, event.width, event.height, event.words)) {
+                    return false;
+                }
+            }
+            break;
+    }
+    return !reader.failed;
+}
+
+bool readSessionLog(const std::string& path, std::vector<SessionEvent>& events, std::string& error) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "Cannot read " + path;
+        return false;
+    }
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    std::fclose(file);
+
+    if (data.size() < sizeof(SESSION_LOG_MAGIC) || std::memcmp(data.data(), SESSION_LOG_MAGIC, sizeof(SESSION_LOG_MAGIC)) != 0) {
+        error = path + " is not a session log";
+        return false;
+    }
+    LogReader reader{data.data(), data.size(), sizeof(SESSION_LOG_MAGIC)};
+    events.clear();
+    uint64_t generation = 0;
+    while (reader.offset < reader.size) {
+        SessionEvent event;
+        if (!readEvent(reader, generation, event)) {
+            break; // Cut short by a crash: keep what came before
+        }
+        if (events.empty() != (event.type == SessionEventType::Start)) {
+            error = path + ": events must follow exactly one Start";
+            return false;
+        }
+        generation = generationAfter(event);
+        events.push_back(std::move(event));
+        if (events.back().type == SessionEventType::End) {
+            break;
+        }
+    }
+    if (events.empty()) {
+        error = path + " has no starting board";
+        return false;
+    }
+    return true;
+}
+
+// The board must match the one recorded when the event was logged
+bool checkBoard(const SessionEvent& event, const std::string& what, std::string& error) {
+    if (getGridWidth() != event.width || getGridHeight() != event.height || boardChecksum() != event.checksum) {
+        error = "Replay diverged at generation " + std::to_string(event.generation) + ": " + what;
+        return false;
+    }
+    return true;
+}
+
+bool applySessionEvent(const SessionEvent& event, uint64_t& generation, std::string& error) {
+    switch (event.type) {
+        case SessionEventType::Start: {
+            if (!setRule(event.rule)) {
+                error = "Unknown rule in session log: " + event.rule;
+                return false;
+            }
+            size_t count = static_cast<size_t>(event.height) * ((event.width + 63) / 64);
+            if (event.seeded) {
+                setGrid(event.width, event.height, std::vector<uint64_t>(count, 0));
+                initializeGrid(event.seed);
+            } else {
+                setGrid(event.width, event.height, event.words);
+            }
+            break;
+        }
+        case SessionEventType::Paint:
+            paintCells(event.x, event.y, event.size, event.state);
+            break;
+        case SessionEventType::Clear:
+            clearGrid();
+            break;
+        case SessionEventType::Reset:
+            initializeGrid(event.seed);
+            break;
+        case SessionEventType::Load:
+        case SessionEventType::Place:
+        case SessionEventType::LoadSnapshot:
+        case SessionEventType::LoadCheckpoint: {
+            Pattern pattern;
+            uint64_t ignored;
+            bool ok = event.type == SessionEventType::LoadCheckpoint ? readLatestCheckpoint(event.path, pattern, ignored, error)
+                      : event.type == SessionEventType::LoadSnapshot ? readBinarySnapshot(event.path, pattern, ignored, error)
+                                                                     : readPattern(event.path, pattern, error);
+            if (ok) {
+                ok = event.type == SessionEventType::Load    ? placePattern(pattern, error)
+                     : event.type == SessionEventType::Place ? placePatternAt(pattern, event.x, event.y, error)
+                                                             : replaceBoard(pattern, error);
+            }
+            if (!ok || !checkBoard(event, event.path + " no longer holds the board it loaded then", error)) {
+                return false;
+            }
+            break;
+        }
+        case SessionEventType::Edit:
+            editRegion(event.x, event.y, event.width, event.height, static_cast<RegionEdit>(event.edit), event.seed);
+            break;
+        case SessionEventType::Paste: {
+            Pattern pattern;
+            pattern.width = event.width;
+            pattern.height = event.height;
+            pattern.wordsPerRow = (event.width + 63) / 64;
+            pattern.words = event.words;
+            pastePattern(pattern, event.x, event.y, event.state);
+            break;
+        }
+        case SessionEventType::End:
+            if (!checkBoard(event, "the final board differs from the recorded one", error)) {
+                return false;
+            }
+            break;
+    }
+    generation = generationAfter(event);
+    return true;
+}
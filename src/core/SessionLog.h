@@ -0,0 +1,61 @@
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Session logs record every change made to the board, each with the generation it was made
+// at, so replaying them and stepping in between rebuilds the session bit for bit. Stepping
+// is deterministic, so only the edits are stored: a random board is its seed, a brush stroke
+// a few bytes and a loaded file its path plus a checksum of the board it produced.
+const char SESSION_LOG_EXTENSION[] = ".gollog";
+
+enum class SessionEventType : uint8_t {
+    Start = 1,      // The board the log starts from: a seed, or the cells themselves
+    Paint,          // paintCells(x, y, size, state)
+    Clear,
+    Reset,          // A new random board from seed, at generation 0
+    Load,           // Pattern centred on a board grown to fit, at generation 0
+    Place,          // Pattern placed at (x, y) in the running board
+    LoadSnapshot,   // Binary snapshot, restoring its generation
+    LoadCheckpoint, // Newest checkpoint of the directory at path, restoring its generation
+    End,            // Last generation of the session, with its board checksum
+    Edit,           // editRegion(x, y, width, height, edit, seed)
+    Paste           // pastePattern of width x height words at (x, y), merged if state is set
+};
+
+struct SessionEvent {
+    SessionEventType type = SessionEventType::Start;
+    uint64_t generation = 0;     // When the event happened
+    uint64_t nextGeneration = 0; // Loads: the generation the board continued from
+    int x = 0;
+    int y = 0;
+    int size = 1;
+    bool state = false;
+    int edit = 0;                // Edit: a RegionEdit
+    bool seeded = false;         // Start: seed is set instead of words
+    uint64_t seed = 0;
+    int width = 0;               // Start, loads and End: the board afterwards; Edit and Paste:
+    int height = 0;              // the rectangle
+    std::string rule;            // Start
+    std::string path;            // Loads
+    uint64_t checksum = 0;       // Loads and End: checksumWords of the board afterwards
+    std::vector<uint64_t> words; // Start without a seed, Paste
+};
+
+// Writing, on the thread that owns the board. Every record is flushed as it is written, so
+// the log of a session that crashed is still good up to its last edit.
+bool startSessionLog(const std::string& path, uint64_t generation, std::string& error); // Records the current board
+bool isSessionLogging();
+void logSessionEvent(SessionEvent event); // Fills in the board size and checksum of loads
+void stopSessionLog(uint64_t generation);  // Records End and closes the log
+
+// A log missing its End record, e.g. after a crash, reads up to its last complete event
+bool readSessionLog(const std::string& path, std::vector<SessionEvent>& events, std::string& error);
+
+// Replay one event at its generation. Loaded files are read again and must produce the same
+// board as when the log was written; End fails if the replayed board differs.
+bool applySessionEvent(const SessionEvent& event, uint64_t& generation, std::string& error);
+
+#endif // SESSION_LOG_H
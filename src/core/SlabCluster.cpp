@@ -0,0 +1,637 @@
+#include "SlabCluster.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#ifndef _WIN32
+#include <atomic>
+#include <cerrno>
+#include <new>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool isClusterSupported() {
+    return false;
+}
+
+SlabCluster::~SlabCluster() {}
+
+bool SlabCluster::start(const Pattern&, uint64_t, const ClusterSettings&, std::string& error) {
+    error = "Multi-process runs need fork, which this system does not have";
+    return false;
+}
+
+bool SlabCluster::step(uint64_t, std::string& error) {
+    error = "No worker processes";
+    return false;
+}
+
+bool SlabCluster::gather(Pattern&, std::string& error) {
+    error = "No worker processes";
+    return false;
+}
+
+bool SlabCluster::collectReports(std::string& error) {
+    error = "No worker processes";
+    return false;
+}
+
+void SlabCluster::killWorkers() {}
+
+void SlabCluster::stop() {}
+
+#else
+
+bool isClusterSupported() {
+    return true;
+}
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL; // A dead peer is an error, not a SIGPIPE
+#else
+const int SEND_FLAGS = 0;
+#endif
+const int RING_SLOTS = 2;
+const size_t CACHE_LINE = 64;
+
+enum class ClusterCommand : uint32_t {
+    Step = 1,
+    Gather,
+    Quit
+};
+
+struct CommandMessage {
+    ClusterCommand command;
+    uint32_t reserved;
+    uint64_t generations;
+};
+
+// Sent by a worker after every command, with its totals so far
+struct WorkerReport {
+    uint32_t ok;
+    uint32_t reserved;
+    uint64_t population;
+    uint64_t exchanges;
+    uint64_t haloBytes;
+    uint64_t stepNanoseconds;
+    uint64_t exchangeNanoseconds;
+    uint64_t engineGenerations[ENGINE_COUNT];
+};
+
+bool writeAll(int fd, const void* data, size_t bytes) {
+    const char* next = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t written = send(fd, next, bytes, SEND_FLAGS);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        next += written;
+        bytes -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, void* data, size_t bytes) {
+    char* next = static_cast<char*>(data);
+    while (bytes > 0) {
+        ssize_t got = recv(fd, next, bytes, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        next += got;
+        bytes -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// One direction of a link between neighbouring workers in shared memory: RING_SLOTS slots of
+// one halo each, and counters of the halos written and read, on their own cache lines.
+// The counters are lock-free atomics, which work across processes.
+struct RingHeader {
+    alignas(CACHE_LINE) std::atomic<uint64_t> written;
+    alignas(CACHE_LINE) std::atomic<uint64_t> read;
+};
+
+size_t ringBytes(size_t haloBytes) {
+    size_t slotBytes = (haloBytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    return sizeof(RingHeader) + RING_SLOTS * slotBytes;
+}
+
+// Spin briefly, then yield, then sleep; a worker whose coordinator is gone exits
+template <typename Ready>
+void waitFor(Ready ready, pid_t coordinator) {
+    for (uint64_t spins = 0; !ready(); ++spins) {
+        if (spins < 256) {
+            continue;
+        }
+        if (spins < 1024) {
+            sched_yield();
+            continue;
+        }
+        timespec pause = { 0, 20000 };
+        nanosleep(&pause, nullptr);
+        if ((spins & 1023) == 0 && getppid() != coordinator) {
+            _exit(1);
+        }
+    }
+}
+
+class Ring {
+public:
+    Ring(void* memory, size_t haloBytes)
+        : header(static_cast<RingHeader*>(memory)),
+          slots(static_cast<uint8_t*>(memory) + sizeof(RingHeader)),
+          slotBytes((haloBytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE),
+          haloBytes(haloBytes) {}
+
+    void send(const void* data, pid_t coordinator) {
+        uint64_t next = header->written.load(std::memory_order_relaxed);
+        waitFor([&] { return next - header->read.load(std::memory_order_acquire) < RING_SLOTS; }, coordinator);
+        std::memcpy(slots + (next % RING_SLOTS) * slotBytes, data, haloBytes);
+        header->written.store(next + 1, std::memory_order_release);
+    }
+
+    void receive(void* data, pid_t coordinator) {
+        uint64_t next = header->read.load(std::memory_order_relaxed);
+        waitFor([&] { return header->written.load(std::memory_order_acquire) > next; }, coordinator);
+        std::memcpy(data, slots + (next % RING_SLOTS) * slotBytes, haloBytes);
+        header->read.store(next + 1, std::memory_order_release);
+    }
+
+private:
+    RingHeader* header;
+    uint8_t* slots;
+    size_t slotBytes;
+    size_t haloBytes;
+};
+
+// Send out to and receive in from both neighbours over non-blocking sockets at once, so two
+// neighbours sending to each other never wait on each other's full buffers
+bool exchangeSockets(const int fds[2], const uint8_t* const out[2], uint8_t* const in[2], size_t bytes) {
+    size_t sent[2] = { 0, 0 };
+    size_t received[2] = { 0, 0 };
+    while (true) {
+        pollfd polls[2];
+        int count = 0;
+        int sides[2];
+        for (int side = 0; side < 2; ++side) {
+            if (fds[side] < 0) {
+                continue;
+            }
+            short events = (sent[side] < bytes ? POLLOUT : 0) | (received[side] < bytes ? POLLIN : 0);
+            if (events != 0) {
+                polls[count] = { fds[side], events, 0 };
+                sides[count++] = side;
+            }
+        }
+        if (count == 0) {
+            return true;
+        }
+        if (poll(polls, count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        for (int i = 0; i < count; ++i) {
+            int side = sides[i];
+            if (polls[i].revents & (POLLERR | POLLNVAL)) {
+                return false;
+            }
+            if ((polls[i].revents & POLLOUT) && sent[side] < bytes) {
+                ssize_t done = send(fds[side], out[side] + sent[side], bytes - sent[side], SEND_FLAGS);
+                if (done < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    return false;
+                }
+                sent[side] += done > 0 ? static_cast<size_t>(done) : 0;
+            }
+            if ((polls[i].revents & (POLLIN | POLLHUP)) && received[side] < bytes) {
+                ssize_t done = recv(fds[side], in[side] + received[side], bytes - received[side], 0);
+                if (done == 0 || (done < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    return false; // The neighbour is gone
+                }
+                received[side] += done > 0 ? static_cast<size_t>(done) : 0;
+            }
+        }
+    }
+}
+
+// The state of one worker process. Side 0 is the neighbour above, side 1 the one below.
+struct SlabWorker {
+    int control = -1;
+    pid_t coordinator = 0;
+    int y0 = 0, y1 = 0;         // Owned rows
+    int u0 = 0, u1 = 0;         // Rows of the universe, owned plus halos
+    int halo = 0;
+    bool hasNeighbour[2] = { false, false };
+    HaloTransport transport = HALO_SHARED_MEMORY;
+    Ring* sendRings[2] = { nullptr, nullptr };
+    Ring* receiveRings[2] = { nullptr, nullptr };
+    int sockets[2] = { -1, -1 };
+    std::vector<uint64_t> incoming[2];
+    int validFor = 0;           // Generations the halos stay exact for
+    WorkerReport report = {};
+};
+
+// Swap halos with the neighbours: the owned rows next to each border go out, the
+// neighbours' come in and overwrite the halo rows
+bool exchangeHalos(SlabWorker& worker, Universe& universe) {
+    const size_t haloWords = static_cast<size_t>(worker.halo) * universe.getWordsPerRow();
+    const size_t haloBytes = haloWords * sizeof(uint64_t);
+    const uint64_t* words = universe.getWords().data();
+    const uint8_t* out[2] = {
+        reinterpret_cast<const uint8_t*>(words + static_cast<size_t>(worker.y0 - worker.u0) * universe.getWordsPerRow()),
+        reinterpret_cast<const uint8_t*>(words + static_cast<size_t>(worker.y1 - worker.halo - worker.u0) * universe.getWordsPerRow())
+    };
+    uint8_t* in[2];
+    for (int side = 0; side < 2; ++side) {
+        worker.incoming[side].resize(haloWords);
+        in[side] = reinterpret_cast<uint8_t*>(worker.incoming[side].data());
+    }
+
+    if (worker.transport == HALO_SHARED_MEMORY) {
+        // A ring has room for the next halo whenever the previous one was received
+        for (int side = 0; side < 2; ++side) {
+            if (worker.hasNeighbour[side]) {
+                worker.sendRings[side]->send(out[side], worker.coordinator);
+            }
+        }
+        for (int side = 0; side < 2; ++side) {
+            if (worker.hasNeighbour[side]) {
+                worker.receiveRings[side]->receive(in[side], worker.coordinator);
+            }
+        }
+    } else if (!exchangeSockets(worker.sockets, out, in, haloBytes)) {
+        return false;
+    }
+
+    if (worker.hasNeighbour[0]) {
+        universe.writeRows(0, worker.halo, worker.incoming[0].data());
+    }
+    if (worker.hasNeighbour[1]) {
+        universe.writeRows(worker.y1 - worker.u0, worker.halo, worker.incoming[1].data());
+    }
+    worker.report.haloBytes += haloBytes * (worker.hasNeighbour[0] + worker.hasNeighbour[1]);
+    ++worker.report.exchanges;
+    return true;
+}
+
+// Step in runs of at most the halo's worth of generations, swapping halos in between
+bool stepWorker(SlabWorker& worker, Universe& universe, uint64_t generations) {
+    using Clock = std::chrono::steady_clock;
+    while (generations > 0) {
+        if (worker.validFor == 0) {
+            auto exchangeStart = Clock::now();
+            if (!exchangeHalos(worker, universe)) {
+                return false;
+            }
+            worker.validFor = worker.halo;
+            worker.report.exchangeNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - exchangeStart).count();
+        }
+        uint64_t run = std::min<uint64_t>(generations, static_cast<uint64_t>(worker.validFor));
+        auto stepStart = Clock::now();
+        universe.step(run);
+        worker.report.stepNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - stepStart).count();
+        worker.validFor -= static_cast<int>(run);
+        generations -= run;
+    }
+    return true;
+}
+
+// The body of a worker process, which never returns
+[[noreturn]] void runWorker(SlabWorker& worker, const Pattern& board, const ClusterSettings& settings) {
+    const int rows = worker.u1 - worker.u0;
+    Universe universe(board.width, rows);
+    universe.setBoard(board.width, rows, std::vector<uint64_t>(board.words.begin() + static_cast<size_t>(worker.u0) * board.wordsPerRow,
+                                                               board.words.begin() + static_cast<size_t>(worker.u1) * board.wordsPerRow));
+    if (!board.rule.empty()) {
+        universe.setRule(board.rule);
+    }
+    EngineCosts costs = settings.costs;
+    costs.threads = std::max(costs.threads / settings.processes, 1);
+    universe.setEngineCosts(costs);
+    universe.setStepEngine(settings.engine);
+    worker.validFor = worker.halo; // The halos start out as the board's own rows
+
+    CommandMessage message;
+    while (readAll(worker.control, &message, sizeof(message))) {
+        if (message.command == ClusterCommand::Quit) {
+            break;
+        }
+        bool ok = message.command != ClusterCommand::Step || stepWorker(worker, universe, message.generations);
+        worker.report.ok = ok ? 1 : 0;
+        worker.report.population = universe.countLiveCells(0, worker.y0 - worker.u0, board.width, worker.y1 - worker.u0);
+        UniverseStats universeStats = universe.getStats();
+        std::copy(std::begin(universeStats.engineGenerations), std::end(universeStats.engineGenerations), worker.report.engineGenerations);
+        if (!writeAll(worker.control, &worker.report, sizeof(worker.report)) || !ok) {
+            break;
+        }
+        if (message.command == ClusterCommand::Gather) {
+            const uint64_t* owned = universe.getWords().data() + static_cast<size_t>(worker.y0 - worker.u0) * universe.getWordsPerRow();
+            size_t bytes = static_cast<size_t>(worker.y1 - worker.y0) * universe.getWordsPerRow() * sizeof(uint64_t);
+            if (!writeAll(worker.control, owned, bytes)) {
+                break;
+            }
+        }
+    }
+    _exit(0); // Skips the coordinator's atexit handlers and destructors, which are not ours
+}
+
+SlabCluster::~SlabCluster() {
+    stop();
+}
+
+bool SlabCluster::start(const Pattern& board, uint64_t generation, const ClusterSettings& requested, std::string& error) {
+    stop();
+    if (board.height < 1) {
+        error = "The board is empty";
+        return false;
+    }
+    settings = requested;
+    settings.processes = std::max(std::min(settings.processes, board.height), 1);
+    settings.halo = std::max(std::min(settings.halo, board.height / settings.processes), 1);
+    width = board.width;
+    height = board.height;
+    rule = board.rule;
+    stats = ClusterStats();
+    stats.generation = generation;
+
+    const int processes = settings.processes;
+    const size_t haloBytes = static_cast<size_t>(settings.halo) * board.wordsPerRow * sizeof(uint64_t);
+    const int links = processes - 1;
+
+    // Everything the workers share is set up before the first fork, so every worker
+    // inherits it; each then closes what is not its own
+    std::vector<int> descriptors;
+    std::vector<int> controls(static_cast<size_t>(processes) * 2, -1); // Coordinator end, worker end
+    std::vector<int> haloSockets(static_cast<size_t>(links) * 2, -1);  // Link i: worker i's end, worker i + 1's end
+    auto closeAll = [&] {
+        for (int fd : descriptors) {
+            close(fd);
+        }
+    };
+    for (int i = 0; i < processes; ++i) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, &controls[i * 2]) != 0) {
+            error = std::string("Cannot create a control socket: ") + std::strerror(errno);
+            closeAll();
+            return false;
+        }
+        descriptors.insert(descriptors.end(), { controls[i * 2], controls[i * 2 + 1] });
+    }
+    if (settings.transport == HALO_SOCKET) {
+        for (int link = 0; link < links; ++link) {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, &haloSockets[link * 2]) != 0) {
+                error = std::string("Cannot create a halo socket: ") + std::strerror(errno);
+                closeAll();
+                return false;
+            }
+            descriptors.insert(descriptors.end(), { haloSockets[link * 2], haloSockets[link * 2 + 1] });
+        }
+    } else if (links > 0) {
+        // Two rings per link, downwards and upwards
+        sharedBytes = ringBytes(haloBytes) * links * 2;
+        sharedMemory = mmap(nullptr, sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (sharedMemory == MAP_FAILED) {
+            sharedMemory = nullptr;
+            error = std::string("Cannot map shared memory for the halos: ") + std::strerror(errno);
+            closeAll();
+            return false;
+        }
+        for (int ring = 0; ring < links * 2; ++ring) {
+            new (static_cast<uint8_t*>(sharedMemory) + ring * ringBytes(haloBytes)) RingHeader{ {0}, {0} };
+        }
+    }
+
+    pid_t coordinator = getpid();
+    for (int i = 0; i < processes; ++i) {
+        Worker worker;
+        worker.y0 = static_cast<int>(static_cast<int64_t>(height) * i / processes);
+        worker.y1 = static_cast<int>(static_cast<int64_t>(height) * (i + 1) / processes);
+        worker.control = controls[i * 2];
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            error = std::string("Cannot start a worker process: ") + std::strerror(errno);
+            for (const Worker& started : workers) {
+                kill(started.pid, SIGKILL);
+                waitpid(started.pid, nullptr, 0);
+            }
+            workers.clear();
+            closeAll();
+            if (sharedMemory != nullptr) {
+                munmap(sharedMemory, sharedBytes);
+                sharedMemory = nullptr;
+            }
+            return false;
+        }
+        if (pid == 0) {
+            // Only this thread exists here; the parent's engine pool and locks must not be used
+            SlabWorker slab;
+            slab.control = controls[i * 2 + 1];
+            slab.coordinator = coordinator;
+            slab.y0 = worker.y0;
+            slab.y1 = worker.y1;
+            slab.halo = settings.halo;
+            slab.transport = settings.transport;
+            slab.hasNeighbour[0] = i > 0;
+            slab.hasNeighbour[1] = i + 1 < processes;
+            slab.u0 = slab.hasNeighbour[0] ? slab.y0 - slab.halo : slab.y0;
+            slab.u1 = slab.hasNeighbour[1] ? slab.y1 + slab.halo : slab.y1;
+            std::vector<int> keep = { slab.control };
+            if (settings.transport == HALO_SOCKET) {
+                slab.sockets[0] = slab.hasNeighbour[0] ? haloSockets[(i - 1) * 2 + 1] : -1;
+                slab.sockets[1] = slab.hasNeighbour[1] ? haloSockets[i * 2] : -1;
+                for (int side = 0; side < 2; ++side) {
+                    if (slab.sockets[side] >= 0) {
+                        fcntl(slab.sockets[side], F_SETFL, fcntl(slab.sockets[side], F_GETFL) | O_NONBLOCK);
+                        keep.push_back(slab.sockets[side]);
+                    }
+                }
+            } else {
+                // Ring 2 * link carries halos down the link, ring 2 * link + 1 up it
+                auto ring = [&](int index) {
+                    return new Ring(static_cast<uint8_t*>(sharedMemory) + index * ringBytes(haloBytes), haloBytes);
+                };
+                if (slab.hasNeighbour[0]) {
+                    slab.sendRings[0] = ring((i - 1) * 2 + 1);
+                    slab.receiveRings[0] = ring((i - 1) * 2);
+                }
+                if (slab.hasNeighbour[1]) {
+                    slab.sendRings[1] = ring(i * 2);
+                    slab.receiveRings[1] = ring(i * 2 + 1);
+                }
+            }
+            for (int fd : descriptors) {
+                if (std::find(keep.begin(), keep.end(), fd) == keep.end()) {
+                    close(fd);
+                }
+            }
+            runWorker(slab, board, settings);
+        }
+        worker.pid = pid;
+        workers.push_back(worker);
+        stats.slabRows.push_back(worker.y1 - worker.y0);
+    }
+
+    // The coordinator keeps only its ends of the control sockets
+    for (int fd : descriptors) {
+        bool coordinatorEnd = false;
+        for (const Worker& worker : workers) {
+            coordinatorEnd |= worker.control == fd;
+        }
+        if (!coordinatorEnd) {
+            close(fd);
+        }
+    }
+    for (uint64_t word : board.words) {
+        stats.population += __builtin_popcountll(word);
+    }
+    return true;
+}
+
+// Read every worker's report and total them. The reports are taken as they come, so a worker
+// that died is noticed even while the others wait on it for a halo.
+bool SlabCluster::collectReports(std::string& error) {
+    ClusterStats totals;
+    totals.generation = stats.generation;
+    totals.slabRows = stats.slabRows;
+    std::vector<bool> reported(workers.size(), false);
+    for (size_t left = workers.size(); left > 0;) {
+        std::vector<pollfd> polls;
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            if (!reported[i]) {
+                polls.push_back({ workers[i].control, POLLIN, 0 });
+                pending.push_back(i);
+            }
+        }
+        if (poll(polls.data(), polls.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = std::string("Cannot wait for the worker processes: ") + std::strerror(errno);
+            return false;
+        }
+        for (size_t p = 0; p < polls.size(); ++p) {
+            if (polls[p].revents == 0) {
+                continue;
+            }
+            size_t i = pending[p];
+            WorkerReport report;
+            if (!readAll(workers[i].control, &report, sizeof(report)) || !report.ok) {
+                error = "Worker process " + std::to_string(i) + " failed";
+                return false;
+            }
+            totals.population += report.population;
+            totals.exchanges = std::max(totals.exchanges, report.exchanges);
+            totals.haloBytes += report.haloBytes;
+            totals.stepSeconds = std::max(totals.stepSeconds, report.stepNanoseconds * 1e-9);
+            totals.exchangeSeconds = std::max(totals.exchangeSeconds, report.exchangeNanoseconds * 1e-9);
+            for (int kind = 0; kind < ENGINE_COUNT; ++kind) {
+                totals.engineGenerations[kind] += report.engineGenerations[kind];
+            }
+            reported[i] = true;
+            --left;
+        }
+    }
+    stats = totals;
+    return true;
+}
+
+bool SlabCluster::step(uint64_t generations, std::string& error) {
+    if (workers.empty()) {
+        error = "No worker processes";
+        return false;
+    }
+    CommandMessage message = { ClusterCommand::Step, 0, generations };
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (!writeAll(workers[i].control, &message, sizeof(message))) {
+            error = "Worker process " + std::to_string(i) + " is gone";
+            killWorkers();
+            return false;
+        }
+    }
+    if (!collectReports(error)) {
+        killWorkers();
+        return false;
+    }
+    stats.generation += generations;
+    return true;
+}
+
+bool SlabCluster::gather(Pattern& board, std::string& error) {
+    if (workers.empty()) {
+        error = "No worker processes";
+        return false;
+    }
+    board.width = width;
+    board.height = height;
+    board.wordsPerRow = (width + 63) / 64;
+    board.words.assign(static_cast<size_t>(board.wordsPerRow) * height, 0);
+    board.rule = rule;
+    board.cropped = false;
+
+    // Each worker's report is followed by its rows, read in worker order
+    CommandMessage message = { ClusterCommand::Gather, 0, 0 };
+    ClusterStats totals = stats;
+    totals.population = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        WorkerReport report;
+        const Worker& worker = workers[i];
+        uint64_t* rows = &board.words[static_cast<size_t>(worker.y0) * board.wordsPerRow];
+        size_t bytes = static_cast<size_t>(worker.y1 - worker.y0) * board.wordsPerRow * sizeof(uint64_t);
+        if (!writeAll(worker.control, &message, sizeof(message)) || !readAll(worker.control, &report, sizeof(report)) ||
+            !readAll(worker.control, rows, bytes)) {
+            error = "Worker process " + std::to_string(i) + " is gone";
+            killWorkers();
+            return false;
+        }
+        totals.population += report.population;
+    }
+    stats = totals;
+    return true;
+}
+
+void SlabCluster::killWorkers() {
+    for (const Worker& worker : workers) {
+        kill(worker.pid, SIGKILL);
+    }
+    stop();
+}
+
+void SlabCluster::stop() {
+    CommandMessage message = { ClusterCommand::Quit, 0, 0 };
+    for (Worker& worker : workers) {
+        if (!writeAll(worker.control, &message, sizeof(message))) {
+            kill(worker.pid, SIGKILL);
+        }
+        close(worker.control);
+    }
+    for (Worker& worker : workers) {
+        int status;
+        while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+    workers.clear();
+    if (sharedMemory != nullptr) {
+        munmap(sharedMemory, sharedBytes);
+        sharedMemory = nullptr;
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef SLAB_CLUSTER_H
+#define SLAB_CLUSTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Universe.h"
+#include "PatternIO.h"
+
+// A board stepped by several processes. The board is cut into slabs of whole rows, one per
+// worker process, and each worker keeps its own Universe of its slab plus `halo` rows of
+// each neighbour's. A halo of h rows stays exact for h generations, so the workers swap the
+// rows next to their borders every h generations and step on their own in between. The
+// coordinator (the process that called start) only sends commands and collects reports
+// and boards. Needs fork, so POSIX only; isClusterSupported says whether this build has it.
+enum HaloTransport {
+    HALO_SHARED_MEMORY, // Ring buffers in memory shared by the workers of one host
+    HALO_SOCKET,        // Unix-domain socket pairs, standing in for a network between hosts
+    HALO_TRANSPORT_COUNT
+};
+const char* const HALO_TRANSPORT_NAMES[] = { "shm", "socket" };
+
+struct ClusterSettings {
+    int processes = 2;
+    int halo = 8; // Rows of each neighbour kept, and generations between exchanges
+    HaloTransport transport = HALO_SHARED_MEMORY;
+    StepEngine engine = ENGINE_AUTO;
+    EngineCosts costs; // Threads are shared out among the workers
+};
+
+// Steps and waits are summed over the run; the times are those of the slowest worker
+struct ClusterStats {
+    uint64_t generation = 0;
+    uint64_t population = 0;
+    uint64_t exchanges = 0;      // Per worker
+    uint64_t haloBytes = 0;      // Sent by all workers together
+    double stepSeconds = 0.0;    // Stepping
+    double exchangeSeconds = 0.0; // Sending halos and waiting for the neighbours'
+    uint64_t engineGenerations[ENGINE_COUNT] = {}; // Generations of each engine, summed over the slabs
+    std::vector<int> slabRows;   // Rows owned by each worker
+};
+
+bool isClusterSupported();
+
+class SlabCluster {
+public:
+    SlabCluster() = default;
+    ~SlabCluster();
+    SlabCluster(const SlabCluster&) = delete;
+    SlabCluster& operator=(const SlabCluster&) = delete;
+
+    // Fork the workers, each taking its slab of board. Start it before other threads, since
+    // the workers are forked copies of this process. The number of processes and the halo
+    // are reduced if the board is too short for them.
+    bool start(const Pattern& board, uint64_t generation, const ClusterSettings& settings, std::string& error);
+    bool isRunning() const { return !workers.empty(); }
+    const ClusterSettings& getSettings() const { return settings; }
+
+    bool step(uint64_t generations, std::string& error);
+    bool gather(Pattern& board, std::string& error); // The whole board and rule, from every worker
+    const ClusterStats& getStats() const { return stats; } // As of the last step or gather
+
+    // Ask the workers to exit and wait for them; also done on destruction
+    void stop();
+
+private:
+    struct Worker {
+        int pid = -1;
+        int control = -1; // Socket to the worker
+        int y0 = 0;       // Owned rows [y0, y1)
+        int y1 = 0;
+    };
+    bool collectReports(std::string& error);
+    void killWorkers(); // After a failure, since the others may be waiting on the failed one
+
+    std::vector<Worker> workers;
+    ClusterSettings settings;
+    ClusterStats stats;
+    int width = 0;
+    int height = 0;
+    std::string rule;
+    void* sharedMemory = nullptr;
+    size_t sharedBytes = 0;
+};
+
+#endif // SLAB_CLUSTER_H
@@ -0,0 +1,403 @@
+#include "StepEngines.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// The sparse engine stands aside on boards with more than one live cell in this many; it
+// keeps some 150 bytes per live cell, a few times the board itself at that density
+const uint64_t SPARSE_CELLS_PER_LIVE = 64;
+const int SPARSE_MIN_RADIX_BITS = 8;  // Key bits sorted per pass: about log2 of the keys, so
+const int SPARSE_MAX_RADIX_BITS = 16; // the counts stay smaller than the keys they sort
+
+// Every word, on the calling thread
+class DenseEngine : public Engine {
+public:
+    StepEngine getKind() const override { return ENGINE_DENSE; }
+
+    bool canStep(const Universe&) const override { return true; }
+
+    double predictCost(const Universe& universe) const override {
+        return universe.getWords().size() * universe.getEngineCosts().denseWord;
+    }
+
+    uint64_t step(Universe& universe, std::vector<uint32_t>& tiles) override {
+        universe.stepWords(0, universe.getHeight(), 0, universe.getWordsPerRow(), tiles);
+        return universe.getWords().size();
+    }
+};
+
+// Worker threads of the threaded engine. The caller runs a band of rows itself and waits for
+// the workers to finish theirs, so a generation costs one wake-up and one wait. The workers
+// are started by the thread that uses them: one started elsewhere, such as a board placed by
+// the UI thread before the simulation thread took over, is restarted, so the workers are
+// that thread's children and the performance counters it opens follow them (PerfCounters.h).
+class StepWorkers {
+public:
+    ~StepWorkers() { resize(0); }
+
+    int size() const { return static_cast<int>(threads.size()); }
+
+    void resize(int count) {
+        if (count == size() && (count == 0 || owner == std::this_thread::get_id())) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        startCondition.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+        stopping = false;
+        owner = std::this_thread::get_id();
+        // A worker that starts after the next run has begun must still take its job, so the
+        // round it has seen is the one before
+        for (int i = 0; i < count; ++i) {
+            threads.emplace_back([this, i, seen = round] { work(i + 1, seen); });
+        }
+    }
+
+    // Call job(0) here and job(1) ... job(size()) on the workers
+    void run(const std::function<void(int)>& task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            pending = size();
+            ++round;
+        }
+        startCondition.notify_all();
+        task(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    void work(int index, uint64_t seen) {
+        while (true) {
+            const std::function<void(int)>* task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                startCondition.wait(lock, [&] { return stopping || round != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = round;
+                task = job;
+            }
+            (*task)(index);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                doneCondition.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::thread::id owner;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    const std::function<void(int)>* job = nullptr;
+    uint64_t round = 0;
+    int pending = 0;
+    bool stopping = false;
+};
+
+// Every word, in bands of whole tile rows so no two threads touch the same tile. The workers
+// are started on the first generation the engine steps.
+class ThreadedEngine : public Engine {
+public:
+    StepEngine getKind() const override { return ENGINE_THREADED; }
+
+    bool canStep(const Universe& universe) const override { return universe.getEngineCosts().threads > 1; }
+
+    double predictCost(const Universe& universe) const override {
+        const EngineCosts& costs = universe.getEngineCosts();
+        return costs.threadedGeneration + universe.getWords().size() * costs.threadedWord;
+    }
+
+    uint64_t step(Universe& universe, std::vector<uint32_t>& tiles) override {
+        const int threads = universe.getEngineCosts().threads;
+        workers.resize(threads - 1);
+        bandTiles.resize(threads);
+        workers.run([&](int band) {
+            int y0, y1;
+            getBand(universe, band, y0, y1);
+            bandTiles[band].clear();
+            universe.stepWords(y0, y1, 0, universe.getWordsPerRow(), bandTiles[band]);
+        });
+        for (const auto& band : bandTiles) {
+            tiles.insert(tiles.end(), band.begin(), band.end());
+        }
+        return universe.getWords().size();
+    }
+
+    // Band i is written by the thread that steps band i, which is the same one every
+    // generation; the threads are not pinned, but rarely move between nodes
+    bool placeRows(const Universe& universe, const std::function<void(int, int)>& write) override {
+        const int threads = universe.getEngineCosts().threads;
+        if (threads <= 1) {
+            return false;
+        }
+        workers.resize(threads - 1);
+        workers.run([&](int band) {
+            int y0, y1;
+            getBand(universe, band, y0, y1);
+            write(y0, y1);
+        });
+        return true;
+    }
+
+private:
+    static void getBand(const Universe& universe, int band, int& y0, int& y1) {
+        const int threads = universe.getEngineCosts().threads;
+        const int height = universe.getHeight();
+        int tileRows = (height + PopulationPyramid::TILE_SIZE - 1) / PopulationPyramid::TILE_SIZE;
+        y0 = std::min(tileRows * band / threads * PopulationPyramid::TILE_SIZE, height);
+        y1 = std::min(tileRows * (band + 1) / threads * PopulationPyramid::TILE_SIZE, height);
+    }
+
+    StepWorkers workers;
+    std::vector<std::vector<uint32_t>> bandTiles; // Changed tiles found by each band
+};
+
+// The words next to the tiles that changed last generation. A cell whose neighbourhood did
+// not change keeps its state, and the next board still holds the generation before, which
+// equals this one wherever nothing changed, so every other word of it is already right. The
+// channels age every cell, so they need every word stepped.
+class ActiveEngine : public Engine {
+public:
+    StepEngine getKind() const override { return ENGINE_ACTIVE; }
+
+    bool canStep(const Universe& universe) const override {
+        return universe.hasStepHistory() && !universe.getAuxChannelsEnabled();
+    }
+
+    // Collect the active words as (tile row, word) indices
+    void prepare(const Universe& universe) override {
+        const int wordsPerRow = universe.getWordsPerRow();
+        const int tilesPerRow = universe.getPyramid().getTilesPerRow();
+        const int tileRows = universe.getPyramid().getLevelHeight(0);
+        activeMask.resize(static_cast<size_t>(tileRows) * wordsPerRow, 0);
+        activeWords.clear();
+        for (uint32_t tile : universe.getChangedTiles()) {
+            int ty = static_cast<int>(tile / tilesPerRow);
+            int tx = static_cast<int>(tile % tilesPerRow);
+            int w = tx >> 3;
+            // A change reaches one cell into the neighbouring word only from the word's edge tiles
+            int w0 = (tx & 7) == 0 ? std::max(w - 1, 0) : w;
+            int w1 = (tx & 7) == 7 ? std::min(w + 1, wordsPerRow - 1) : w;
+            for (int row = std::max(ty - 1, 0); row <= std::min(ty + 1, tileRows - 1); ++row) {
+                for (int word = w0; word <= w1; ++word) {
+                    uint32_t index = static_cast<uint32_t>(row * wordsPerRow + word);
+                    if (!activeMask[index]) {
+                        activeMask[index] = 1;
+                        activeWords.push_back(index);
+                    }
+                }
+            }
+        }
+    }
+
+    void finish() override {
+        for (uint32_t index : activeWords) {
+            activeMask[index] = 0;
+        }
+        activeWords.clear();
+    }
+
+    double predictCost(const Universe& universe) const override {
+        const EngineCosts& costs = universe.getEngineCosts();
+        return costs.activeGeneration + activeWords.size() * PopulationPyramid::TILE_SIZE * costs.activeWord;
+    }
+
+    uint64_t step(Universe& universe, std::vector<uint32_t>& tiles) override {
+        const int wordsPerRow = universe.getWordsPerRow();
+        for (uint32_t index : activeWords) {
+            int y0 = static_cast<int>(index / wordsPerRow) * PopulationPyramid::TILE_SIZE;
+            int w = static_cast<int>(index % wordsPerRow);
+            universe.stepWords(y0, std::min(y0 + PopulationPyramid::TILE_SIZE, universe.getHeight()), w, w + 1, tiles);
+        }
+        return activeWords.size() * PopulationPyramid::TILE_SIZE;
+    }
+
+private:
+    std::vector<uint8_t> activeMask;    // By (tile row, word): stepped this generation
+    std::vector<uint32_t> activeWords;  // The set entries of activeMask
+};
+
+// Only the live cells. Each adds a key for itself and one for each of its neighbours on the
+// board; radix sorting the keys brings those of each cell into a run, whose length is the
+// cell's neighbour count, so a generation costs in proportion to the population rather than
+// the board's area. The live cells are found through the populated blocks of the pyramid.
+// The next board, which holds the generation before, is cleared only in the tiles where that
+// generation can have had live cells: those live now and those the last generation changed.
+class SparseEngine : public Engine {
+public:
+    StepEngine getKind() const override { return ENGINE_SPARSE; }
+
+    // A rule with birth on no neighbours (B0) would have every empty cell stepped
+    bool canStep(const Universe& universe) const override {
+        uint64_t cells = static_cast<uint64_t>(universe.getWidth()) * universe.getHeight();
+        return universe.hasStepHistory() && !universe.getAuxChannelsEnabled() && (universe.getBirthMask() & 1) == 0 &&
+               universe.getPyramid().getPopulation() * SPARSE_CELLS_PER_LIVE <= cells;
+    }
+
+    // The last generation's changed tiles, before Universe clears them for this one
+    void prepare(const Universe& universe) override {
+        population = universe.getPyramid().getPopulation();
+        staleTiles = universe.getChangedTiles();
+    }
+
+    double predictCost(const Universe& universe) const override {
+        const EngineCosts& costs = universe.getEngineCosts();
+        return costs.sparseGeneration + population * costs.sparseCell;
+    }
+
+    uint64_t step(Universe& universe, std::vector<uint32_t>& tiles) override {
+        const PopulationPyramid& pyramid = universe.getPyramid();
+        const int tilesPerRow = pyramid.getTilesPerRow();
+        xBits = bitWidth(static_cast<uint64_t>(std::max(universe.getWidth() - 1, 0)));
+        next = universe.getNextWords();
+        for (uint32_t tile : staleTiles) {
+            clearTile(universe, static_cast<int>(tile % tilesPerRow), static_cast<int>(tile / tilesPerRow));
+        }
+        keys.clear();
+        const int top = pyramid.getLevelCount() - 1;
+        for (int by = 0; by < pyramid.getLevelHeight(top); ++by) {
+            for (int bx = 0; bx < pyramid.getLevelWidth(top); ++bx) {
+                addBlock(universe, top, bx, by);
+            }
+        }
+        sortKeys(1 + xBits + bitWidth(static_cast<uint64_t>(std::max(universe.getHeight() - 1, 0))));
+
+        // Each run: the cell's neighbours, then its own key if it is alive
+        const uint16_t birthMask = universe.getBirthMask();
+        const uint16_t survivalMask = universe.getSurvivalMask();
+        const int wordsPerRow = universe.getWordsPerRow();
+        const uint64_t xMask = (1ULL << xBits) - 1;
+        uint64_t cells = 0;
+        for (size_t i = 0; i < keys.size(); ++cells) {
+            const uint64_t cell = keys[i] >> 1;
+            int neighbours = 0;
+            while (i < keys.size() && keys[i] == cell << 1) {
+                ++neighbours;
+                ++i;
+            }
+            const bool alive = i < keys.size() && keys[i] == (cell << 1 | 1);
+            i += alive ? 1 : 0;
+            const bool lives = (((alive ? survivalMask : birthMask) >> neighbours) & 1) != 0;
+            const int x = static_cast<int>(cell & xMask);
+            const int y = static_cast<int>(cell >> xBits);
+            if (lives) {
+                next[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] |= 1ULL << (x & 63);
+            }
+            if (lives != alive) {
+                universe.addChangedTile(static_cast<uint32_t>((y >> PopulationPyramid::BLOCK_SHIFT) * tilesPerRow + (x >> 3)), tiles);
+            }
+        }
+        return (cells + 63) / 64; // Cells stepped, in words' worth
+    }
+
+private:
+    static int bitWidth(uint64_t value) { return value == 0 ? 0 : 64 - __builtin_clzll(value); }
+
+    uint64_t key(int x, int y) const { return ((static_cast<uint64_t>(y) << xBits) | static_cast<uint64_t>(x)) << 1; }
+
+    void clearTile(const Universe& universe, int tx, int ty) {
+        const int wordsPerRow = universe.getWordsPerRow();
+        const uint64_t mask = ~(0xFFULL << ((tx & 7) * 8));
+        const int y0 = ty * PopulationPyramid::TILE_SIZE;
+        for (int y = y0; y < std::min(y0 + PopulationPyramid::TILE_SIZE, universe.getHeight()); ++y) {
+            next[static_cast<size_t>(y) * wordsPerRow + (tx >> 3)] &= mask;
+        }
+    }
+
+    // The keys of the live cells of a block and its neighbours, skipping empty blocks whole
+    void addBlock(const Universe& universe, int level, int bx, int by) {
+        const PopulationPyramid& pyramid = universe.getPyramid();
+        if (pyramid.getBlockPopulation(level, bx, by) == 0) {
+            return;
+        }
+        if (level > 0) {
+            for (int cy = 0; cy < PopulationPyramid::TILE_SIZE; ++cy) {
+                for (int cx = 0; cx < PopulationPyramid::TILE_SIZE; ++cx) {
+                    addBlock(universe, level - 1, (bx << PopulationPyramid::BLOCK_SHIFT) + cx, (by << PopulationPyramid::BLOCK_SHIFT) + cy);
+                }
+            }
+            return;
+        }
+        clearTile(universe, bx, by);
+        const int width = universe.getWidth();
+        const int height = universe.getHeight();
+        const int wordsPerRow = universe.getWordsPerRow();
+        const int y0 = by * PopulationPyramid::TILE_SIZE;
+        for (int y = y0; y < std::min(y0 + PopulationPyramid::TILE_SIZE, height); ++y) {
+            uint64_t bits = (universe.getWords()[static_cast<size_t>(y) * wordsPerRow + (bx >> 3)] >> ((bx & 7) * 8)) & 0xFF;
+            while (bits) {
+                const int x = bx * 8 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                keys.push_back(key(x, y) | 1);
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ++ny) {
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); ++nx) {
+                        if (nx != x || ny != y) {
+                            keys.push_back(key(nx, ny));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Least significant digit first, so each pass keeps the order of the one before; the
+    // digits split the key bits evenly over as few passes as the key count allows
+    void sortKeys(int bits) {
+        int digitBits = std::min(std::max(bitWidth(keys.size()), SPARSE_MIN_RADIX_BITS), SPARSE_MAX_RADIX_BITS);
+        int passes = (bits + digitBits - 1) / digitBits;
+        digitBits = passes == 0 ? 0 : (bits + passes - 1) / passes;
+        const size_t buckets = size_t(1) << digitBits;
+        sorted.resize(keys.size());
+        counts.resize(buckets);
+        for (int shift = 0; shift < bits; shift += digitBits) {
+            std::fill(counts.begin(), counts.end(), 0);
+            for (uint64_t key : keys) {
+                ++counts[(key >> shift) & (buckets - 1)];
+            }
+            size_t offset = 0;
+            for (size_t& count : counts) {
+                size_t bucket = count;
+                count = offset;
+                offset += bucket;
+            }
+            for (uint64_t key : keys) {
+                sorted[counts[(key >> shift) & (buckets - 1)]++] = key;
+            }
+            keys.swap(sorted);
+        }
+    }
+
+    uint64_t population = 0;
+    std::vector<uint32_t> staleTiles; // Changed by the last generation
+    std::vector<uint64_t> keys;       // (y, x, alive) of the live cells and their neighbours
+    std::vector<uint64_t> sorted;
+    std::vector<size_t> counts;
+    uint64_t* next = nullptr;
+    int xBits = 0;
+};
+
+std::unique_ptr<Engine> createEngine(StepEngine kind) {
+    switch (kind) {
+        case ENGINE_THREADED:
+            return std::make_unique<ThreadedEngine>();
+        case ENGINE_ACTIVE:
+            return std::make_unique<ActiveEngine>();
+        case ENGINE_SPARSE:
+            return std::make_unique<SparseEngine>();
+        default:
+            return std::make_unique<DenseEngine>();
+    }
+}
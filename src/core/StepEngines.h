@@ -0,0 +1,10 @@
+#ifndef STEP_ENGINES_H
+#define STEP_ENGINES_H
+
+#include <memory>
+#include "Universe.h"
+
+// The engine of each StepEngine below ENGINE_COUNT; every universe owns one of each
+std::unique_ptr<Engine> createEngine(StepEngine kind);
+
+#endif // STEP_ENGINES_H
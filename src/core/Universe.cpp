@@ -0,0 +1,685 @@
+#include "Universe.h"
+#include "StepEngines.h"
+#include "PatternIO.h"
+#include <random>
+#include <algorithm>
+#include <cctype>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const uint16_t CONWAY_BIRTH = 1 << 3;
+const uint16_t CONWAY_SURVIVAL = (1 << 2) | (1 << 3);
+const uint8_t HEAT_GAIN = 64; // Heat added by a change, before saturation
+
+// For every byte value, a word with 0xFF in each byte whose bit is set
+struct ByteMaskTable {
+    uint64_t masks[256];
+    ByteMaskTable() {
+        for (int value = 0; value < 256; ++value) {
+            masks[value] = 0;
+            for (int bit = 0; bit < 8; ++bit) {
+                if (value & (1 << bit)) {
+                    masks[value] |= 0xFFULL << (bit * 8);
+                }
+            }
+        }
+    }
+};
+const ByteMaskTable byteMasks;
+
+Universe::Universe(int width, int height)
+    : width(0), height(0), wordsPerRow(0), birthMask(CONWAY_BIRTH), survivalMask(CONWAY_SURVIVAL) {
+    for (int kind = 0; kind < ENGINE_COUNT; ++kind) {
+        engines[kind] = createEngine(static_cast<StepEngine>(kind));
+    }
+    setBoard(width, height, std::vector<uint64_t>());
+}
+
+Universe::~Universe() = default;
+
+// Mask of the valid cells in the last word of a row
+uint64_t Universe::lastWordMask() const {
+    int tailBits = width & 63;
+    return tailBits == 0 ? ~0ULL : (1ULL << tailBits) - 1;
+}
+
+void Universe::rebuildPyramid() {
+    pyramid.rebuild(grid.data(), wordsPerRow);
+}
+
+// Called by every change to the board other than a step
+void Universe::markEdited() {
+    boardSeeded = false;
+    stepHistoryValid = false;
+}
+
+// Reset the channels to match the current grid, used after bulk edits
+void Universe::resetAuxChannels() {
+    if (!auxChannelsEnabled) {
+        return;
+    }
+    for (size_t word = 0; word < grid.size(); ++word) {
+        for (int bit = 0; bit < 64; ++bit) {
+            auxPlanes[AUX_AGE][word * 64 + bit] = (grid[word] >> bit) & 1;
+        }
+    }
+    std::fill(auxPlanes[AUX_LAST_CHANGE].begin(), auxPlanes[AUX_LAST_CHANGE].end(), 0);
+    std::fill(auxPlanes[AUX_HEAT].begin(), auxPlanes[AUX_HEAT].end(), 0);
+}
+
+void Universe::setAuxChannelsEnabled(bool enabled) {
+    auxChannelsEnabled = enabled;
+    for (auto& plane : auxPlanes) {
+        if (enabled) {
+            plane.assign(grid.size() * 64, 0);
+        } else {
+            std::vector<uint8_t>().swap(plane);
+        }
+    }
+    resetAuxChannels();
+}
+
+// Advance the channels of the 64 cells of one word, given which of them are alive in the new
+// generation and which changed. Bits are widened to byte masks through a table, then every
+// channel is a saturating add masked by them.
+void Universe::updateAuxWord(size_t word, uint64_t alive, uint64_t changed) {
+    alignas(16) uint64_t aliveBytes[8];
+    alignas(16) uint64_t changedBytes[8];
+    for (int i = 0; i < 8; ++i) {
+        aliveBytes[i] = byteMasks.masks[(alive >> (i * 8)) & 0xFF];
+        changedBytes[i] = byteMasks.masks[(changed >> (i * 8)) & 0xFF];
+    }
+
+    uint8_t* age = &auxPlanes[AUX_AGE][word * 64];
+    uint8_t* lastChange = &auxPlanes[AUX_LAST_CHANGE][word * 64];
+    uint8_t* heat = &auxPlanes[AUX_HEAT][word * 64];
+    const uint8_t* aliveMask = reinterpret_cast<const uint8_t*>(aliveBytes);
+    const uint8_t* changedMask = reinterpret_cast<const uint8_t*>(changedBytes);
+
+#ifdef __SSE2__
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i gain = _mm_set1_epi8(static_cast<char>(HEAT_GAIN));
+    const __m128i lowFiveBits = _mm_set1_epi8(0x1F);
+    for (int i = 0; i < 64; i += 16) {
+        __m128i aliveVector = _mm_load_si128(reinterpret_cast<const __m128i*>(aliveMask + i));
+        __m128i changedVector = _mm_load_si128(reinterpret_cast<const __m128i*>(changedMask + i));
+
+        // Age counts up while alive and is zero while dead, so a birth starts at 1
+        __m128i ageVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(age + i));
+        ageVector = _mm_and_si128(_mm_adds_epu8(ageVector, one), aliveVector);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(age + i), ageVector);
+
+        __m128i lastChangeVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lastChange + i));
+        lastChangeVector = _mm_andnot_si128(changedVector, _mm_adds_epu8(lastChangeVector, one));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lastChange + i), lastChangeVector);
+
+        // Heat decays by an eighth per generation (a byte-wise shift is a 16-bit shift and a mask)
+        __m128i heatVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(heat + i));
+        __m128i decay = _mm_and_si128(_mm_srli_epi16(heatVector, 3), lowFiveBits);
+        heatVector = _mm_adds_epu8(_mm_sub_epi8(heatVector, decay), _mm_and_si128(changedVector, gain));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(heat + i), heatVector);
+    }
+#else
+    for (int i = 0; i < 64; ++i) {
+        age[i] = static_cast<uint8_t>(std::min(age[i] + 1, 255) & aliveMask[i]);
+        lastChange[i] = static_cast<uint8_t>(std::min(lastChange[i] + 1, 255) & ~changedMask[i]);
+        int decayed = heat[i] - (heat[i] >> 3);
+        heat[i] = static_cast<uint8_t>(std::min(decayed + (changedMask[i] & HEAT_GAIN), 255));
+    }
+#endif
+}
+
+bool Universe::getSeed(uint64_t& seed) const {
+    seed = boardSeed;
+    return boardSeeded;
+}
+
+void Universe::randomize(uint64_t seed) {
+    std::mt19937_64 gen(seed);
+
+    // Every bit of a uniform 64-bit draw is alive with 50% chance
+    for (int y = 0; y < height; ++y) {
+        uint64_t* row = &grid[static_cast<size_t>(y) * wordsPerRow];
+        for (int w = 0; w < wordsPerRow; ++w) {
+            row[w] = gen();
+        }
+        row[wordsPerRow - 1] &= lastWordMask();
+    }
+    rebuildPyramid();
+    resetAuxChannels();
+    stepHistoryValid = false;
+    boardSeed = seed;
+    boardSeeded = true;
+}
+
+// Parse the digits of one half of a rule into a count mask
+bool parseCounts(const std::string& digits, uint16_t& mask) {
+    mask = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '8') {
+            return false;
+        }
+        mask |= 1 << (c - '0');
+    }
+    return true;
+}
+
+bool parseRule(const std::string& rule, uint16_t& birthMask, uint16_t& survivalMask) {
+    // Topology suffixes such as ":T100,100" are ignored, the board is always bounded
+    std::string text = rule.substr(0, rule.find(':'));
+    for (char& c : text) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    size_t slash = text.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    std::string first = text.substr(0, slash);
+    std::string second = text.substr(slash + 1);
+
+    uint16_t birth, survival;
+    bool ok;
+    if (!first.empty() && first[0] == 'B' && !second.empty() && second[0] == 'S') {
+        ok = parseCounts(first.substr(1), birth) && parseCounts(second.substr(1), survival);
+    } else if (!first.empty() && first[0] == 'S' && !second.empty() && second[0] == 'B') {
+        ok = parseCounts(first.substr(1), survival) && parseCounts(second.substr(1), birth);
+    } else {
+        ok = parseCounts(first, survival) && parseCounts(second, birth); // S/B without letters
+    }
+    if (ok) {
+        birthMask = birth;
+        survivalMask = survival;
+    }
+    return ok;
+}
+
+std::string formatRule(uint16_t birthMask, uint16_t survivalMask) {
+    std::string rule = "B";
+    for (int n = 0; n <= 8; ++n) {
+        if (birthMask & (1 << n)) {
+            rule += static_cast<char>('0' + n);
+        }
+    }
+    rule += "/S";
+    for (int n = 0; n <= 8; ++n) {
+        if (survivalMask & (1 << n)) {
+            rule += static_cast<char>('0' + n);
+        }
+    }
+    return rule;
+}
+
+bool Universe::setRule(const std::string& rule) {
+    if (!parseRule(rule, birthMask, survivalMask)) {
+        return false;
+    }
+    stepHistoryValid = false; // Settled regions may not be settled under the new rule
+    return true;
+}
+
+std::string Universe::getRule() const {
+    return formatRule(birthMask, survivalMask);
+}
+
+// Cells whose 4-bit neighbour count is one of the counts in mask
+inline uint64_t matchCounts(uint16_t mask, uint64_t sum0, uint64_t sum1, uint64_t sum2, uint64_t sum3) {
+    uint64_t match = 0;
+    for (int n = 0; n <= 8; ++n) {
+        if (mask & (1 << n)) {
+            match |= ((n & 1) ? sum0 : ~sum0) & ((n & 2) ? sum1 : ~sum1) &
+                     ((n & 4) ? sum2 : ~sum2) & ((n & 8) ? sum3 : ~sum3);
+        }
+    }
+    return match;
+}
+
+// Step one word of 64 cells: the eight neighbour bit-planes are summed with carry-save
+// adders into a 4-bit count per cell, then compared against the rule (with a shortcut for
+// B3/S23, and count by count for other rules). Rows beyond the edges are null, all dead.
+inline uint64_t stepWord(const uint64_t* above, const uint64_t* row, const uint64_t* below, int w, int wordsPerRow,
+                         uint16_t birthMask, uint16_t survivalMask, bool conway) {
+    auto west = [&](const uint64_t* r) { return r ? (r[w] << 1) | (w > 0 ? r[w - 1] >> 63 : 0) : 0; };
+    auto east = [&](const uint64_t* r) { return r ? (r[w] >> 1) | (w + 1 < wordsPerRow ? r[w + 1] << 63 : 0) : 0; };
+    auto centre = [&](const uint64_t* r) { return r ? r[w] : 0; };
+
+    // Row above and row below: three cells each, summed to two bits
+    uint64_t a = west(above), b = centre(above), c = east(above);
+    uint64_t top0 = a ^ b ^ c;
+    uint64_t top1 = (a & b) | (c & (a ^ b));
+    a = west(below), b = centre(below), c = east(below);
+    uint64_t bottom0 = a ^ b ^ c;
+    uint64_t bottom1 = (a & b) | (c & (a ^ b));
+    // Own row: the two side cells
+    a = west(row), c = east(row);
+    uint64_t middle0 = a ^ c;
+    uint64_t middle1 = a & c;
+
+    // Sum of the three partial counts, as bits of weight 1, 2, 4 and 8
+    uint64_t sum0 = top0 ^ middle0 ^ bottom0;
+    uint64_t carry0 = (top0 & middle0) | (bottom0 & (top0 ^ middle0));
+    uint64_t twos = top1 ^ middle1 ^ bottom1;
+    uint64_t fours = (top1 & middle1) | (bottom1 & (top1 ^ middle1));
+    uint64_t sum1 = twos ^ carry0;
+    uint64_t carry1 = twos & carry0;
+    uint64_t sum2 = fours ^ carry1;
+    uint64_t sum3 = fours & carry1;
+
+    uint64_t alive = row[w];
+    if (conway) {
+        uint64_t lowZero = ~(sum2 | sum3);
+        uint64_t three = sum0 & sum1 & lowZero;
+        uint64_t two = ~sum0 & sum1 & lowZero;
+        return three | (alive & two);
+    }
+    return (matchCounts(birthMask, sum0, sum1, sum2, sum3) & ~alive) |
+           (matchCounts(survivalMask, sum0, sum1, sum2, sum3) & alive);
+}
+
+void stepRow(const uint64_t* above, const uint64_t* row, const uint64_t* below, uint64_t* out, int width,
+             uint16_t birthMask, uint16_t survivalMask) {
+    const int wordsPerRow = (width + 63) / 64;
+    const bool conway = birthMask == CONWAY_BIRTH && survivalMask == CONWAY_SURVIVAL;
+    for (int w = 0; w < wordsPerRow; ++w) {
+        out[w] = stepWord(above, row, below, w, wordsPerRow, birthMask, survivalMask, conway);
+    }
+    if (width & 63) {
+        out[wordsPerRow - 1] &= (1ULL << (width & 63)) - 1;
+    }
+}
+
+// One byte of the word per tile: a tile is noted once per generation however many of its
+// words changed
+void Universe::stepWords(int y0, int y1, int w0, int w1, std::vector<uint32_t>& tiles) {
+    const uint64_t tailMask = lastWordMask();
+    const int tilesPerRow = pyramid.getTilesPerRow();
+    const bool conway = birthMask == CONWAY_BIRTH && survivalMask == CONWAY_SURVIVAL;
+
+    for (int y = y0; y < y1; ++y) {
+        const uint64_t* above = y > 0 ? &grid[static_cast<size_t>(y - 1) * wordsPerRow] : nullptr;
+        const uint64_t* row = &grid[static_cast<size_t>(y) * wordsPerRow];
+        const uint64_t* below = y + 1 < height ? &grid[static_cast<size_t>(y + 1) * wordsPerRow] : nullptr;
+        uint64_t* out = &nextGrid[static_cast<size_t>(y) * wordsPerRow];
+
+        for (int w = w0; w < w1; ++w) {
+            uint64_t next = stepWord(above, row, below, w, wordsPerRow, birthMask, survivalMask, conway);
+            if (w == wordsPerRow - 1) {
+                next &= tailMask;
+            }
+            out[w] = next;
+
+            uint64_t diff = next ^ row[w];
+            if (auxChannelsEnabled) {
+                updateAuxWord(static_cast<size_t>(y) * wordsPerRow + w, next, diff);
+            }
+            while (diff) {
+                int tx = w * 8 + (__builtin_ctzll(diff) >> 3);
+                uint32_t tile = static_cast<uint32_t>((y >> PopulationPyramid::BLOCK_SHIFT) * tilesPerRow + tx);
+                if (!tileChanged[tile]) {
+                    tileChanged[tile] = 1;
+                    tiles.push_back(tile);
+                }
+                diff &= ~(0xFFULL << ((tx & 7) * 8));
+            }
+        }
+    }
+}
+
+void Universe::addChangedTile(uint32_t tile, std::vector<uint32_t>& tiles) {
+    if (!tileChanged[tile]) {
+        tileChanged[tile] = 1;
+        tiles.push_back(tile);
+    }
+}
+
+// One generation, with the engine set by setStepEngine or, on auto, the one the calibrated
+// costs predict to be fastest for this generation: dense boards go to the threaded or dense
+// sweep, boards where little changes to the active engine and nearly empty ones to the
+// sparse engine. The auxiliary channels, when
+// enabled, are advanced in the same pass.
+void Universe::stepGeneration() {
+    bool available[ENGINE_COUNT];
+    for (int kind = 0; kind < ENGINE_COUNT; ++kind) {
+        available[kind] = engines[kind]->canStep(*this);
+        if (available[kind]) {
+            engines[kind]->prepare(*this);
+        }
+    }
+    StepEngine engine = ENGINE_DENSE;
+    if (engineSetting == ENGINE_AUTO) {
+        double bestCost = engines[ENGINE_DENSE]->predictCost(*this);
+        for (int kind = 0; kind < ENGINE_COUNT; ++kind) {
+            if (!available[kind]) {
+                continue;
+            }
+            double cost = engines[kind]->predictCost(*this);
+            if (cost < bestCost) {
+                engine = static_cast<StepEngine>(kind);
+                bestCost = cost;
+            }
+        }
+    } else if (available[engineSetting]) {
+        engine = engineSetting;
+    }
+
+    for (uint32_t tile : changedTiles) {
+        tileChanged[tile] = 0;
+    }
+    changedTiles.clear();
+    lastSteppedWords = engines[engine]->step(*this, changedTiles);
+    for (int kind = 0; kind < ENGINE_COUNT; ++kind) {
+        if (available[kind]) {
+            engines[kind]->finish();
+        }
+    }
+    lastStepEngine = engine;
+    ++engineGenerations[engine];
+
+    grid.swap(nextGrid);
+    pyramid.updateTiles(grid.data(), wordsPerRow, changedTiles);
+    ++generation;
+    boardSeeded = false;
+    stepHistoryValid = true;
+}
+
+void Universe::step(uint64_t generations) {
+    for (uint64_t i = 0; i < generations; ++i) {
+        stepGeneration();
+    }
+}
+
+void Universe::setStepEngine(StepEngine engine) {
+    engineSetting = engine;
+}
+
+void Universe::setEngineCosts(const EngineCosts& costs) {
+    bool threadsChanged = std::max(costs.threads, 1) != engineCosts.threads;
+    engineCosts = costs;
+    engineCosts.threads = std::max(engineCosts.threads, 1);
+    if (threadsChanged && grid.isMapped()) {
+        // The bands of rows move to other threads, so the board moves with them
+        GridBuffer oldGrid = std::move(grid);
+        GridBuffer oldNextGrid = std::move(nextGrid);
+        placeBuffers(oldGrid.data(), oldGrid.size(), oldNextGrid.data());
+    }
+}
+
+GridPlacement Universe::getPlacement() const {
+    GridPlacement placement;
+    addPlacement(grid, placement);
+    addPlacement(nextGrid, placement);
+    return placement;
+}
+
+// Make new board buffers holding words (zero past count) and, if given, history as the
+// generation before, each band of rows written first by the thread that steps it
+void Universe::placeBuffers(const uint64_t* words, size_t count, const uint64_t* history) {
+    const size_t size = static_cast<size_t>(wordsPerRow) * height;
+    GridBuffer placedGrid(size);
+    GridBuffer placedNextGrid(size);
+    auto write = [&](int y0, int y1) {
+        size_t begin = static_cast<size_t>(y0) * wordsPerRow;
+        size_t end = static_cast<size_t>(y1) * wordsPerRow;
+        size_t copied = std::min(std::max(count, begin), end);
+        std::copy(words + begin, words + copied, placedGrid.begin() + begin);
+        std::fill(placedGrid.begin() + copied, placedGrid.begin() + end, 0);
+        if (history != nullptr) {
+            std::copy(history + begin, history + end, placedNextGrid.begin() + begin);
+        } else {
+            std::fill(placedNextGrid.begin() + begin, placedNextGrid.begin() + end, 0);
+        }
+    };
+    bool placed = engineCosts.threads > 1 && engines[ENGINE_THREADED]->placeRows(*this, write);
+    if (!placed) {
+        write(0, height);
+    }
+    grid = std::move(placedGrid);
+    nextGrid = std::move(placedNextGrid);
+}
+
+UniverseStats Universe::getStats() const {
+    UniverseStats stats;
+    stats.width = width;
+    stats.height = height;
+    stats.generation = generation;
+    stats.population = pyramid.getPopulation();
+    stats.changed = !changedTiles.empty();
+    stats.lastEngine = lastStepEngine;
+    stats.lastSteppedWords = lastSteppedWords;
+    std::copy(std::begin(engineGenerations), std::end(engineGenerations), stats.engineGenerations);
+    return stats;
+}
+
+void Universe::clear() {
+    markEdited();
+    std::fill(grid.begin(), grid.end(), 0);  // Set each cell to dead
+    rebuildPyramid();
+    resetAuxChannels();
+}
+
+bool Universe::getCell(int x, int y) const {
+    if (x >= 0 && x < width && y >= 0 && y < height) {
+        return (grid[static_cast<size_t>(y) * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+    }
+    return false;
+}
+
+void Universe::setCell(int x, int y, bool state) {
+    if (x >= 0 && x < width && y >= 0 && y < height) {
+        uint64_t& word = grid[static_cast<size_t>(y) * wordsPerRow + (x >> 6)];
+        uint64_t bit = 1ULL << (x & 63);
+        if (((word & bit) != 0) != state) {
+            word ^= bit;
+            markEdited();
+            pyramid.addCell(x, y, state ? 1 : -1);
+
+            if (auxChannelsEnabled) {
+                size_t cell = (static_cast<size_t>(y) * wordsPerRow + (x >> 6)) * 64 + (x & 63);
+                auxPlanes[AUX_AGE][cell] = state ? 1 : 0;
+                auxPlanes[AUX_LAST_CHANGE][cell] = 0;
+                auxPlanes[AUX_HEAT][cell] = static_cast<uint8_t>(std::min(auxPlanes[AUX_HEAT][cell] + HEAT_GAIN, 255));
+            }
+        }
+    }
+}
+
+void Universe::paintCells(int x, int y, int size, bool state) {
+    for (int dx = 0; dx < size; ++dx) {
+        for (int dy = 0; dy < size; ++dy) {
+            setCell(x + dx, y + dy, state);
+        }
+    }
+}
+
+// The words under a rectangle before a bulk edit, to find the cells it changed
+struct Universe::RegionBackup {
+    int y0 = 0, y1 = 0;  // Rows
+    int w0 = 0, w1 = 0;  // Words of each row, half-open
+    std::vector<uint64_t> words;
+};
+
+Universe::RegionBackup Universe::backupRegion(int x0, int y0, int x1, int y1) const {
+    RegionBackup backup;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, width);
+    backup.y0 = std::max(y0, 0);
+    backup.y1 = std::min(y1, height);
+    if (x0 >= x1 || backup.y0 >= backup.y1) {
+        return backup;
+    }
+    backup.w0 = x0 >> 6;
+    backup.w1 = ((x1 - 1) >> 6) + 1;
+    for (int y = backup.y0; y < backup.y1; ++y) {
+        const uint64_t* row = &grid[static_cast<size_t>(y) * wordsPerRow];
+        backup.words.insert(backup.words.end(), row + backup.w0, row + backup.w1);
+    }
+    return backup;
+}
+
+// Bring the pyramid and channels up to date with the cells a bulk edit changed. The word
+// differences of the 8 rows of a tile row are ORed, so each changed tile is recounted once.
+// With keepHistory the changed tiles are added to the last generation's instead of ending
+// the step history.
+void Universe::commitRegion(const RegionBackup& backup, bool keepHistory) {
+    const int span = backup.w1 - backup.w0;
+    const int tilesPerRow = pyramid.getTilesPerRow();
+    std::vector<uint32_t> tiles;
+    std::vector<uint64_t> tileRowDiff(span);
+    for (int y = backup.y0; y < backup.y1; ++y) {
+        const uint64_t* before = &backup.words[static_cast<size_t>(y - backup.y0) * span];
+        const uint64_t* row = &grid[static_cast<size_t>(y) * wordsPerRow + backup.w0];
+        for (int w = 0; w < span; ++w) {
+            uint64_t diff = before[w] ^ row[w];
+            tileRowDiff[w] |= diff;
+            if (diff != 0 && auxChannelsEnabled) {
+                size_t word = static_cast<size_t>(y) * wordsPerRow + backup.w0 + w;
+                for (uint64_t bits = diff; bits != 0; bits &= bits - 1) {
+                    size_t cell = word * 64 + __builtin_ctzll(bits);
+                    auxPlanes[AUX_AGE][cell] = (row[w] >> (cell & 63)) & 1;
+                    auxPlanes[AUX_LAST_CHANGE][cell] = 0;
+                    auxPlanes[AUX_HEAT][cell] = static_cast<uint8_t>(std::min(auxPlanes[AUX_HEAT][cell] + HEAT_GAIN, 255));
+                }
+            }
+        }
+        if (((y + 1) & (PopulationPyramid::TILE_SIZE - 1)) == 0 || y + 1 == backup.y1) {
+            for (int w = 0; w < span; ++w) {
+                uint64_t diff = tileRowDiff[w];
+                while (diff) {
+                    int tx = (backup.w0 + w) * 8 + (__builtin_ctzll(diff) >> 3);
+                    tiles.push_back(static_cast<uint32_t>((y >> PopulationPyramid::BLOCK_SHIFT) * tilesPerRow + tx));
+                    diff &= ~(0xFFULL << ((tx & 7) * 8));
+                }
+            }
+            std::fill(tileRowDiff.begin(), tileRowDiff.end(), 0);
+        }
+    }
+    if (tiles.empty()) {
+        return;
+    }
+    if (keepHistory) {
+        boardSeeded = false;
+        for (uint32_t tile : tiles) {
+            if (!tileChanged[tile]) {
+                tileChanged[tile] = 1;
+                changedTiles.push_back(tile);
+            }
+        }
+    } else {
+        markEdited();
+    }
+    pyramid.updateTiles(grid.data(), wordsPerRow, tiles);
+}
+
+Pattern Universe::copyRegion(int x, int y, int regionWidth, int regionHeight) const {
+    return extractRegion(grid.data(), wordsPerRow, width, height, x, y, regionWidth, regionHeight);
+}
+
+void Universe::editRegion(int x, int y, int regionWidth, int regionHeight, RegionEdit edit, uint64_t seed) {
+    if (edit == EDIT_ROTATE_CLOCKWISE || edit == EDIT_ROTATE_COUNTERCLOCKWISE) {
+        // The rectangle turns on its top-left corner, so the cells land in a height x width one
+        Pattern region = rotatePattern(copyRegion(x, y, regionWidth, regionHeight), edit == EDIT_ROTATE_CLOCKWISE);
+        int side = std::max(regionWidth, regionHeight);
+        RegionBackup backup = backupRegion(x, y, x + side, y + side);
+        fillRegion(grid.data(), wordsPerRow, width, height, x, y, regionWidth, regionHeight, EDIT_CLEAR, 0);
+        stampPattern(region, grid.data(), wordsPerRow, width, height, x, y, false);
+        commitRegion(backup);
+        return;
+    }
+    RegionBackup backup = backupRegion(x, y, x + regionWidth, y + regionHeight);
+    if (edit == EDIT_FLIP_HORIZONTAL || edit == EDIT_FLIP_VERTICAL) {
+        Pattern region = copyRegion(x, y, regionWidth, regionHeight);
+        flipPattern(region, edit == EDIT_FLIP_HORIZONTAL);
+        stampPattern(region, grid.data(), wordsPerRow, width, height, x, y, false);
+    } else {
+        fillRegion(grid.data(), wordsPerRow, width, height, x, y, regionWidth, regionHeight, edit, seed);
+    }
+    commitRegion(backup);
+}
+
+void Universe::pastePattern(const Pattern& pattern, int x, int y, bool merge) {
+    RegionBackup backup = backupRegion(x, y, x + pattern.width, y + pattern.height);
+    stampPattern(pattern, grid.data(), wordsPerRow, width, height, x, y, merge);
+    commitRegion(backup);
+}
+
+void Universe::writeRows(int y, int count, const uint64_t* words) {
+    y = std::max(y, 0);
+    count = std::min(count, height - y);
+    if (count <= 0) {
+        return;
+    }
+    RegionBackup backup = backupRegion(0, y, width, y + count);
+    std::copy(words, words + static_cast<size_t>(count) * wordsPerRow, grid.begin() + static_cast<size_t>(y) * wordsPerRow);
+    commitRegion(backup, true);
+}
+
+uint64_t Universe::countLiveCells(int x0, int y0, int x1, int y1) const {
+    return pyramid.countLiveCells(grid.data(), wordsPerRow, x0, y0, x1, y1);
+}
+
+bool Universe::isRegionEmpty(int x0, int y0, int x1, int y1) const {
+    return pyramid.isRegionEmpty(grid.data(), wordsPerRow, x0, y0, x1, y1);
+}
+
+void Universe::setBoard(int newWidth, int newHeight, std::vector<uint64_t> words) {
+    markEdited();
+    width = newWidth;
+    height = newHeight;
+    wordsPerRow = (width + 63) / 64;
+    placeBuffers(words.data(), words.size(), nullptr);
+
+    pyramid.resize(width, height);
+    changedTiles.clear();
+    tileChanged.assign(static_cast<size_t>(pyramid.getLevelWidth(0)) * pyramid.getLevelHeight(0), 0);
+    rebuildPyramid();
+    setAuxChannelsEnabled(auxChannelsEnabled);
+}
+
+// The board grows to fit the pattern, which is centred on it, and takes on its rule
+bool Universe::placePattern(Pattern& pattern, std::string& error) {
+    if (!pattern.rule.empty() && !setRule(pattern.rule)) {
+        error = "Unsupported rule " + pattern.rule;
+        return false;
+    }
+
+    int newWidth = std::max(pattern.width, width);
+    int newHeight = std::max(pattern.height, height);
+    if (newWidth == pattern.width && newHeight == pattern.height) {
+        setBoard(newWidth, newHeight, std::move(pattern.words)); // Exact fit: take the words as they are
+        return true;
+    }
+    int newWordsPerRow = (newWidth + 63) / 64;
+    std::vector<uint64_t> words(static_cast<size_t>(newWordsPerRow) * newHeight, 0);
+    blitPattern(pattern, words.data(), newWordsPerRow, newWidth, newHeight, (newWidth - pattern.width) / 2, (newHeight - pattern.height) / 2);
+    setBoard(newWidth, newHeight, std::move(words));
+    return true;
+}
+
+// The pattern is ORed in and clipped to the board, which keeps its size and rule
+bool Universe::placePatternAt(const Pattern& pattern, int x, int y, std::string& error) {
+    if (x >= width || y >= height || x + pattern.width <= 0 || y + pattern.height <= 0) {
+        error = "A pattern at " + std::to_string(x) + "," + std::to_string(y) + " is outside the board";
+        return false;
+    }
+    pastePattern(pattern, x, y, true);
+    return true;
+}
+
+bool Universe::replaceBoard(Pattern& pattern, std::string& error) {
+    if (!pattern.rule.empty() && !setRule(pattern.rule)) {
+        error = "Unsupported rule " + pattern.rule;
+        return false;
+    }
+    setBoard(pattern.width, pattern.height, std::move(pattern.words));
+    return true;
+}
+
+Pattern Universe::copyBoard() const {
+    Pattern pattern;
+    pattern.width = width;
+    pattern.height = height;
+    pattern.wordsPerRow = wordsPerRow;
+    pattern.words.assign(grid.begin(), grid.end());
+    pattern.rule = getRule();
+    return pattern;
+}
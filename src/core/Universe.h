@@ -0,0 +1,224 @@
+#ifndef UNIVERSE_H
+#define UNIVERSE_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "PopulationPyramid.h"
+#include "RegionEdit.h"
+#include "GridMemory.h"
+
+struct Pattern;
+
+// Optional per-cell channels maintained by step, one byte per cell. Cell x of row y is
+// byte (y * getWordsPerRow() + x / 64) * 64 + x % 64.
+enum AuxChannel {
+    AUX_AGE,          // Generations since birth, 0 while dead
+    AUX_LAST_CHANGE,  // Generations since the cell last changed
+    AUX_HEAT,         // Decaying activity, raised by every change
+    AUX_CHANNEL_COUNT
+};
+
+// Step engines a universe can use; all give the same generations
+enum StepEngine {
+    ENGINE_DENSE,     // Every word, on the calling thread
+    ENGINE_THREADED,  // Every word, in bands of rows on worker threads
+    ENGINE_ACTIVE,    // Only the words next to cells that changed last generation
+    ENGINE_SPARSE,    // Only the live cells and their neighbours, for nearly empty boards
+    ENGINE_COUNT,
+    ENGINE_AUTO = ENGINE_COUNT // Per generation, the one the costs below predict to be fastest
+};
+const char* const STEP_ENGINE_NAMES[] = { "dense", "threaded", "active", "sparse", "auto" };
+
+// Nanoseconds, measured on this machine by calibrateEngines (EngineTuner.h)
+struct EngineCosts {
+    double denseWord = 1.0;          // Per word stepped by the dense engine
+    int threads = 1;                 // Threads of the threaded engine, 1 leaves it unused
+    double threadedWord = 1.0;       // Per word of the board with that many threads
+    double threadedGeneration = 0.0; // Per generation, waking the workers and waiting for them
+    double activeWord = 1.0;         // Per word the active engine steps
+    double activeGeneration = 0.0;   // Per generation, finding the words to step
+    double sparseCell = 1.0;         // Per live cell the sparse engine steps
+    double sparseGeneration = 0.0;   // Per generation, apart from the cells
+};
+
+struct UniverseStats {
+    int width = 0;
+    int height = 0;
+    uint64_t generation = 0;
+    uint64_t population = 0;
+    bool changed = false;                       // The last generation changed a cell
+    StepEngine lastEngine = ENGINE_DENSE;       // The engine that stepped it
+    uint64_t lastSteppedWords = 0;              // Words it stepped
+    uint64_t engineGenerations[ENGINE_COUNT] = {}; // Generations stepped by each engine
+};
+
+// The rule parser and row kernel of Universe, for boards kept elsewhere (DiskBoard.h).
+// parseRule takes the forms setRule does and leaves the masks unchanged on failure; bit n of
+// a mask set means n live neighbours give birth or survival. stepRow steps one row of width
+// cells in the layout of Universe below; above and below are null beyond the board's edges.
+bool parseRule(const std::string& rule, uint16_t& birthMask, uint16_t& survivalMask);
+std::string formatRule(uint16_t birthMask, uint16_t survivalMask);
+void stepRow(const uint64_t* above, const uint64_t* row, const uint64_t* below, uint64_t* out, int width,
+             uint16_t birthMask, uint16_t survivalMask);
+
+class Universe;
+
+// One way of stepping a universe a generation. Universe::step asks every engine that can
+// take the next generation for its predicted cost and runs the cheapest, or the one set.
+class Engine {
+public:
+    virtual ~Engine() = default;
+    virtual StepEngine getKind() const = 0;
+    // Whether the engine can step the universe's next generation; if so, prepare is called
+    // before predictCost, and finish after the generation whichever engine stepped it
+    virtual bool canStep(const Universe& universe) const = 0;
+    virtual void prepare(const Universe& /*universe*/) {}
+    virtual void finish() {}
+    // Nanoseconds, from the universe's EngineCosts
+    virtual double predictCost(const Universe& universe) const = 0;
+    // Step the universe with Universe::stepWords, noting the changed tiles in tiles, and
+    // return the number of words stepped
+    virtual uint64_t step(Universe& universe, std::vector<uint32_t>& tiles) = 0;
+    // Call write(y0, y1) for bands of rows covering the board on the threads that step those
+    // rows, so new board buffers are first written, and placed (GridMemory.h), by them.
+    // Returns false, having called nothing, if the engine does not step on other threads.
+    virtual bool placeRows(const Universe& /*universe*/, const std::function<void(int, int)>& /*write*/) { return false; }
+};
+
+// A bounded board of width x height cells under an outer-totalistic rule, with its
+// population pyramid, optional per-cell channels and step engines. Universes are
+// independent of each other; one must only be used by one thread at a time.
+//
+// The board is stored as bit-packed rows: 64 cells per word, cell x of row y is
+// bit (x % 64) of word y * getWordsPerRow() + x / 64.
+class Universe {
+public:
+    Universe(int width, int height);
+    ~Universe();
+    Universe(const Universe&) = delete;
+    Universe& operator=(const Universe&) = delete;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getWordsPerRow() const { return wordsPerRow; }
+    const GridBuffer& getWords() const { return grid; }
+    const PopulationPyramid& getPyramid() const { return pyramid; }
+
+    // Replace the board with a width x height one holding words in the layout above
+    void setBoard(int width, int height, std::vector<uint64_t> words);
+    void clear();
+    void randomize(uint64_t seed); // Every cell alive with 50% chance; the same seed gives the same board
+    bool getSeed(uint64_t& seed) const; // False once the seeded board was stepped, edited or replaced
+
+    // Outer-totalistic rule in B/S notation ("B3/S23"); the S/B form "23/3" is also accepted.
+    // setRule returns false and leaves the rule unchanged if it cannot be parsed.
+    bool setRule(const std::string& rule);
+    std::string getRule() const;
+
+    // Generations stepped since the counter was last set; set by loads that restore one
+    uint64_t getGeneration() const { return generation; }
+    void setGeneration(uint64_t value) { generation = value; }
+
+    void step(uint64_t generations = 1);
+    void setStepEngine(StepEngine engine); // ENGINE_AUTO by default
+    StepEngine getStepEngine() const { return engineSetting; }
+    void setEngineCosts(const EngineCosts& costs); // A change of threads moves the board to theirs
+    const EngineCosts& getEngineCosts() const { return engineCosts; }
+    UniverseStats getStats() const;
+    GridPlacement getPlacement() const; // Of the board's buffers; slow, see addPlacement
+
+    // Cells out of the board read as dead and ignore writes
+    bool getCell(int x, int y) const;
+    void setCell(int x, int y, bool state);
+    void paintCells(int x, int y, int size, bool state); // A size x size square with its top-left corner at (x, y)
+    uint64_t countLiveCells(int x0, int y0, int x1, int y1) const; // Half-open rectangle
+    bool isRegionEmpty(int x0, int y0, int x1, int y1) const;
+
+    // Rectangle reads and edits done a word at a time (RegionEdit.h); the rectangle may
+    // reach past the board
+    Pattern copyRegion(int x, int y, int width, int height) const;
+    void editRegion(int x, int y, int width, int height, RegionEdit edit, uint64_t seed = 0);
+    void pastePattern(const Pattern& pattern, int x, int y, bool merge); // Replaces the cells under it unless merge
+    // Overwrite whole rows [y, y + count) with count * getWordsPerRow() words, e.g. halo rows
+    // stepped elsewhere. Unlike the edits above this keeps the step history: the changed
+    // tiles count as changed by the last generation, so the active engine steps around them.
+    void writeRows(int y, int count, const uint64_t* words);
+
+    // Whole patterns (PatternIO.h). placePattern grows the board to fit and centres the
+    // pattern; replaceBoard takes the pattern's size exactly. Both move the words out of the
+    // pattern and take on its rule, if it has one. placePatternAt ORs the pattern in with its
+    // top-left corner at (x, y), clipped to the board, and fails only if none of it lands there.
+    bool placePattern(Pattern& pattern, std::string& error);
+    bool placePatternAt(const Pattern& pattern, int x, int y, std::string& error);
+    bool replaceBoard(Pattern& pattern, std::string& error);
+    Pattern copyBoard() const; // The board and rule
+
+    void setAuxChannelsEnabled(bool enabled);
+    bool getAuxChannelsEnabled() const { return auxChannelsEnabled; }
+    const std::vector<uint8_t>& getAuxChannel(AuxChannel channel) const { return auxPlanes[channel]; }
+
+    // For engines. The generation before the current one is stepped into the next board,
+    // which still holds the generation before that while hasStepHistory is true; any edit
+    // makes it false. getChangedTiles lists the tiles the last generation changed.
+    bool hasStepHistory() const { return stepHistoryValid; }
+    const std::vector<uint32_t>& getChangedTiles() const { return changedTiles; }
+    // Step word columns [w0, w1) of rows [y0, y1), advancing the channels and adding the
+    // tiles whose cells changed to tiles. Calls for disjoint tile rows may run concurrently.
+    void stepWords(int y0, int y1, int w0, int w1, std::vector<uint32_t>& tiles);
+    // For engines that write the next board themselves instead: the rule, the next board
+    // (the generation before, as above), and adding a tile to tiles once per generation
+    uint16_t getBirthMask() const { return birthMask; }
+    uint16_t getSurvivalMask() const { return survivalMask; }
+    uint64_t* getNextWords() { return nextGrid.data(); }
+    void addChangedTile(uint32_t tile, std::vector<uint32_t>& tiles);
+
+private:
+    void stepGeneration();
+    void markEdited();
+    void rebuildPyramid();
+    void resetAuxChannels();
+    void updateAuxWord(size_t word, uint64_t alive, uint64_t changed);
+    uint64_t lastWordMask() const;
+    struct RegionBackup;
+    RegionBackup backupRegion(int x0, int y0, int x1, int y1) const;
+    void commitRegion(const RegionBackup& backup, bool keepHistory = false);
+    void placeBuffers(const uint64_t* words, size_t count, const uint64_t* history);
+
+    int width;
+    int height;
+    int wordsPerRow;
+    GridBuffer grid;
+    GridBuffer nextGrid; // Output buffer of a step, then the generation before
+    uint64_t generation = 0;
+
+    // Rule as neighbour count masks: bit n set means n live neighbours give birth or survival
+    uint16_t birthMask;
+    uint16_t survivalMask;
+
+    // Seed of the board while it is still exactly what randomize made, so a session log can
+    // record the seed instead of the cells
+    uint64_t boardSeed = 0;
+    bool boardSeeded = false;
+
+    // Per-block live counts, kept in step with the grid
+    PopulationPyramid pyramid;
+    std::vector<uint32_t> changedTiles; // Tiles touched by the last step
+    std::vector<uint8_t> tileChanged;
+
+    StepEngine engineSetting = ENGINE_AUTO;
+    EngineCosts engineCosts;
+    std::unique_ptr<Engine> engines[ENGINE_COUNT];
+    bool stepHistoryValid = false;
+    StepEngine lastStepEngine = ENGINE_DENSE;
+    uint64_t lastSteppedWords = 0;
+    uint64_t engineGenerations[ENGINE_COUNT] = {};
+
+    // Optional per-cell channels, one byte per cell in the grid's word order (64 bytes per word)
+    bool auxChannelsEnabled = false;
+    std::vector<uint8_t> auxPlanes[AUX_CHANNEL_COUNT];
+};
+
+#endif // UNIVERSE_H
@@ -0,0 +1,494 @@
+#include "Headless.h"
+#include "GameOfLife.h"
+#include "PopulationPyramid.h"
+#include "FrameRecorder.h"
+#include "ImageExport.h"
+#include "PatternIO.h"
+#include "BinarySnapshot.h"
+#include "BackgroundIO.h"
+#include "Checkpoint.h"
+#include "SessionLog.h"
+#include "EngineTuner.h"
+#include "SlabCluster.h"
+#include "DiskBoard.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+bool hasArgument(int argc, char* argv[], const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* getArgument(int argc, char* argv[], const char* name) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+bool getOffsetArgument(int argc, char* argv[], const char* name, int& x, int& y) {
+    const char* value = getArgument(argc, argv, name);
+    if (value == nullptr) {
+        return false;
+    }
+    const char* end = value + std::strlen(value);
+    auto parsedX = std::from_chars(value, end, x);
+    if (parsedX.ec != std::errc() || parsedX.ptr == end || *parsedX.ptr != ',') {
+        return false;
+    }
+    auto parsedY = std::from_chars(parsedX.ptr + 1, end, y);
+    return parsedY.ec == std::errc() && parsedY.ptr == end;
+}
+
+// Integer option with a default
+long long getIntegerArgument(int argc, char* argv[], const char* name, long long defaultValue) {
+    const char* value = getArgument(argc, argv, name);
+    return value != nullptr ? std::atoll(value) : defaultValue;
+}
+
+bool getEngineArgument(int argc, char* argv[], StepEngine& engine) {
+    const char* name = getArgument(argc, argv, "--engine");
+    engine = ENGINE_AUTO;
+    if (name == nullptr) {
+        return true;
+    }
+    for (int i = 0; i <= ENGINE_AUTO; ++i) {
+        if (std::strcmp(name, STEP_ENGINE_NAMES[i]) == 0) {
+            engine = static_cast<StepEngine>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --export and --save of the board in this process, at the end of a run
+bool saveFinalBoard(int argc, char* argv[], uint64_t generation) {
+    // Export the final generation as a PBM or PNG image, chosen by the file extension
+    const char* exportPath = getArgument(argc, argv, "--export");
+    if (exportPath != nullptr) {
+        std::string error;
+        int scale = static_cast<int>(getIntegerArgument(argc, argv, "--export-scale", 1));
+        if (!exportImage(exportPath, imageFormatForPath(exportPath), getGrid().data(), getWordsPerRow(),
+                         getGridWidth(), getGridHeight(), scale, error)) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        std::cout << "Exported: " << exportPath << std::endl;
+    }
+    const char* savePath = getArgument(argc, argv, "--save");
+    if (savePath != nullptr) {
+        std::string error;
+        bool saved = writeFileAtomically(savePath, [&](const std::string& tempPath, std::string& writeError) {
+            return isBinarySnapshotPath(savePath)
+                       ? saveBinarySnapshot(tempPath, generation, writeError)
+                       : saveGrid(tempPath, writeError);
+        }, error);
+        if (!saved) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        std::cout << "Saved: " << savePath << std::endl;
+    }
+    return true;
+}
+
+// --out-of-core: the board lives in a file and is stepped a band at a time, so it never has
+// to fit in memory. An existing file is stepped on until generation --generations, as with
+// --resume; otherwise one is made from --pattern or a random board of --size W,H.
+int runOutOfCore(int argc, char* argv[], const char* path, long long generations) {
+    const char* unsupported[] = { "--record", "--checkpoint-every", "--checkpoint-seconds", "--processes", "--replay",
+                                  "--session-log", "--resume", "--at" };
+    for (const char* option : unsupported) {
+        if (getArgument(argc, argv, option) != nullptr || hasArgument(argc, argv, option)) {
+            std::cerr << option << " does not work with --out-of-core" << std::endl;
+            return 1;
+        }
+    }
+
+    DiskBoard board;
+    board.setBandBytes(static_cast<uint64_t>(std::max(getIntegerArgument(argc, argv, "--band-mb", 32), 1LL)) << 20);
+    std::string error;
+    bool opened = false;
+    const char* patternPath = getArgument(argc, argv, "--pattern");
+    if (std::ifstream(path).good()) {
+        opened = board.open(path, error);
+        generations = std::max(generations - static_cast<long long>(board.getStats().generation), 0LL);
+    } else if (patternPath != nullptr) {
+        Pattern pattern;
+        uint64_t generation = 0;
+        bool loaded = isBinarySnapshotPath(patternPath) ? readBinarySnapshot(patternPath, pattern, generation, error)
+                                                        : readPattern(patternPath, pattern, error);
+        opened = loaded && board.create(path, pattern, generation, error);
+    } else {
+        int width = getGridWidth();
+        int height = getGridHeight();
+        if (getArgument(argc, argv, "--size") != nullptr && !getOffsetArgument(argc, argv, "--size", width, height)) {
+            std::cerr << "Expected --size W,H" << std::endl;
+            return 1;
+        }
+        uint64_t seed = getArgument(argc, argv, "--seed") ? std::strtoull(getArgument(argc, argv, "--seed"), nullptr, 10) : randomSeed();
+        std::cout << "Seed: " << seed << std::endl;
+        opened = board.createRandom(path, width, height, seed, getRule(), error);
+    }
+    if (!opened) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    const DiskBoardStats& stats = board.getStats();
+    std::cout << "Board file: " << path << ", " << board.getWidth() << "x" << board.getHeight() << ", rule " << board.getRule()
+              << ", generation " << stats.generation << ", " << (stats.fileBytes >> 20) << " MB, bands of " << stats.bandRows
+              << " rows" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!board.step(static_cast<uint64_t>(generations), error)) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double megabytes = (stats.bytesRead + stats.bytesWritten) / 1048576.0;
+    std::cout << "Generations: " << generations << " (now at generation " << stats.generation << ")\n"
+              << "Population: " << stats.population << "\n"
+              << "Seconds: " << seconds << "\n"
+              << "Generations per second: " << (seconds > 0.0 ? generations / seconds : 0.0) << "\n"
+              << "Disk: " << (stats.bytesRead >> 20) << " MB read, " << (stats.bytesWritten >> 20) << " MB written, "
+              << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MB/s\n"
+              << "Stepping " << stats.stepSeconds << " s, waiting " << stats.readWaitSeconds << " s for reads and "
+              << stats.writeWaitSeconds << " s for writes" << std::endl;
+
+    // Saving or exporting brings the board into memory
+    if (getArgument(argc, argv, "--save") != nullptr || getArgument(argc, argv, "--export") != nullptr) {
+        Pattern finalBoard;
+        if (!board.read(finalBoard, error) || !replaceBoard(finalBoard, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        if (!saveFinalBoard(argc, argv, stats.generation)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// --record-format NAME, y4m if absent; false if the name is unknown
+bool getRecordFormatArgument(int argc, char* argv[], RecordingFormat& format) {
+    std::string name = getArgument(argc, argv, "--record-format") ? getArgument(argc, argv, "--record-format") : "y4m";
+    format = RECORD_Y4M;
+    if (name == "raw") {
+        format = RECORD_RAW;
+    } else if (name == "pbm") {
+        format = RECORD_PBM_FRAMES;
+    } else if (name == "png") {
+        format = RECORD_PNG_FRAMES;
+    }
+    return format != RECORD_Y4M || name == "y4m";
+}
+
+// --transport NAME, shared memory if absent; false if the name is unknown
+bool getTransportArgument(int argc, char* argv[], HaloTransport& transport) {
+    std::string name = getArgument(argc, argv, "--transport") ? getArgument(argc, argv, "--transport") : "shm";
+    transport = name == HALO_TRANSPORT_NAMES[HALO_SOCKET] ? HALO_SOCKET : HALO_SHARED_MEMORY;
+    return transport == HALO_SOCKET || name == HALO_TRANSPORT_NAMES[HALO_SHARED_MEMORY];
+}
+
+int runHeadless(int argc, char* argv[]) {
+    long long generations = getIntegerArgument(argc, argv, "--generations", 1000);
+
+    StepEngine engine;
+    if (!getEngineArgument(argc, argv, engine)) {
+        std::cerr << "Unknown engine: " << getArgument(argc, argv, "--engine") << std::endl;
+        return 1;
+    }
+    // The board file is stepped a band at a time with stepRow, so no engine is needed
+    if (const char* outOfCorePath = getArgument(argc, argv, "--out-of-core")) {
+        return runOutOfCore(argc, argv, outOfCorePath, generations);
+    }
+    RecordingFormat recordFormat;
+    if (!getRecordFormatArgument(argc, argv, recordFormat)) {
+        std::cerr << "Unknown recording format: " << getArgument(argc, argv, "--record-format") << std::endl;
+        return 1;
+    }
+    HaloTransport transport;
+    if (!getTransportArgument(argc, argv, transport)) {
+        std::cerr << "Unknown halo transport: " << getArgument(argc, argv, "--transport") << std::endl;
+        return 1;
+    }
+    int placeX = 0;
+    int placeY = 0;
+    if (getArgument(argc, argv, "--at") != nullptr && !getOffsetArgument(argc, argv, "--at", placeX, placeY)) {
+        std::cerr << "Expected --at X,Y" << std::endl;
+        return 1;
+    }
+
+    // Engine costs are measured once per machine, once the arguments are known to be good;
+    // this runs before any board is set up
+    std::string calibrationMessage;
+    setEngineCosts(loadEngineCosts(getEngineCalibrationPath(), hasArgument(argc, argv, "--calibrate"), calibrationMessage));
+    setStepEngine(engine);
+    std::cout << calibrationMessage << std::endl;
+
+    CheckpointSettings checkpoints;
+    if (getArgument(argc, argv, "--checkpoint-dir") != nullptr) {
+        checkpoints.directory = getArgument(argc, argv, "--checkpoint-dir");
+    }
+    checkpoints.everyGenerations = static_cast<uint64_t>(std::max(getIntegerArgument(argc, argv, "--checkpoint-every", 0), 0LL));
+    checkpoints.everySeconds = getArgument(argc, argv, "--checkpoint-seconds") ? std::atof(getArgument(argc, argv, "--checkpoint-seconds")) : 0.0;
+    checkpoints.diskBudget = static_cast<uint64_t>(std::max(getIntegerArgument(argc, argv, "--checkpoint-budget-mb", 1024), 1LL)) << 20;
+    bool checkpointing = checkpoints.everyGenerations != 0 || checkpoints.everySeconds > 0.0;
+
+    // Start from a replayed session, the newest checkpoint, a pattern file or binary snapshot,
+    // or a random board
+    uint64_t startGeneration = 0;
+    const char* patternPath = getArgument(argc, argv, "--pattern");
+    const char* replayPath = getArgument(argc, argv, "--replay");
+    if (replayPath != nullptr) {
+        // Step from event to event as fast as the engine goes; the log's End record checks the
+        // result. --generations is then the generation to finish at, by default the log's last.
+        std::vector<SessionEvent> events;
+        std::string error;
+        if (!readSessionLog(replayPath, events, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        auto replayStart = std::chrono::steady_clock::now();
+        bool verified = false;
+        for (const SessionEvent& event : events) {
+            while (event.type != SessionEventType::Start && startGeneration < event.generation) {
+                updateGrid();
+                ++startGeneration;
+            }
+            if (!applySessionEvent(event, startGeneration, error)) {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+            verified |= event.type == SessionEventType::End;
+        }
+        double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+        std::cout << "Replayed: " << events.size() << " events to generation " << startGeneration << " in "
+                  << replaySeconds << " s, board " << getGridWidth() << "x" << getGridHeight() << ", rule " << getRule()
+                  << (verified ? ", matches the recording" : ", log has no end to check against") << std::endl;
+        long long target = getIntegerArgument(argc, argv, "--generations", static_cast<long long>(startGeneration));
+        generations = std::max(target - static_cast<long long>(startGeneration), 0LL);
+    } else if (hasArgument(argc, argv, "--resume") && hasCheckpoint(checkpoints.directory)) {
+        Pattern board;
+        std::string error;
+        if (!readLatestCheckpoint(checkpoints.directory, board, startGeneration, error) || !replaceBoard(board, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        generations = std::max(generations - static_cast<long long>(startGeneration), 0LL);
+        std::cout << "Resumed: generation " << startGeneration << ", board " << getGridWidth() << "x" << getGridHeight()
+                  << ", rule " << getRule() << std::endl;
+    } else if (patternPath != nullptr) {
+        std::string error;
+        bool loaded;
+        if (getArgument(argc, argv, "--at") != nullptr) {
+            Pattern pattern;
+            clearGrid();
+            loaded = readPattern(patternPath, pattern, error) && placePatternAt(pattern, placeX, placeY, error);
+        } else if (isBinarySnapshotPath(patternPath)) {
+            loaded = loadBinarySnapshot(patternPath, startGeneration, error);
+        } else {
+            loaded = loadGrid(patternPath, error);
+        }
+        if (!loaded) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        std::cout << "Board: " << getGridWidth() << "x" << getGridHeight() << ", rule " << getRule() << std::endl;
+    } else {
+        uint64_t seed = getArgument(argc, argv, "--seed") ? std::strtoull(getArgument(argc, argv, "--seed"), nullptr, 10) : randomSeed();
+        initializeGrid(seed);
+        std::cout << "Seed: " << seed << std::endl;
+    }
+
+    // Worker processes are forked after the board is set up, so with threads > 1 each carries a
+    // snapshot of this process's threaded-engine pool: its threads are gone there and its locks
+    // may be held. Workers step a Universe of their own and must never touch the process-wide
+    // board or that pool.
+    SlabCluster cluster;
+    int processes = static_cast<int>(getIntegerArgument(argc, argv, "--processes", 1));
+    if (processes > 1) {
+        ClusterSettings settings;
+        settings.processes = processes;
+        settings.halo = static_cast<int>(getIntegerArgument(argc, argv, "--halo", settings.halo));
+        settings.transport = transport;
+        settings.engine = engine;
+        settings.costs = getEngineCosts();
+
+        std::string error;
+        if (!isClusterSupported()) {
+            std::cerr << "Multi-process runs need a POSIX system; stepping in this process" << std::endl;
+        } else if (!cluster.start(copyBoard(), startGeneration, settings, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        } else {
+            const ClusterSettings& started = cluster.getSettings();
+            const std::vector<int>& slabRows = cluster.getStats().slabRows;
+            std::cout << "Processes: " << started.processes << ", slabs of " << *std::min_element(slabRows.begin(), slabRows.end())
+                      << " to " << *std::max_element(slabRows.begin(), slabRows.end()) << " rows, halo " << started.halo
+                      << ", transport " << HALO_TRANSPORT_NAMES[started.transport] << std::endl;
+        }
+    }
+
+    // A log of a run without edits is just its start and end, which a later --replay checks
+    const char* sessionLogPath = getArgument(argc, argv, "--session-log");
+    if (sessionLogPath != nullptr) {
+        std::string error;
+        if (!startSessionLog(sessionLogPath, startGeneration, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+    }
+
+    const char* recordPath = getArgument(argc, argv, "--record");
+    if (recordPath != nullptr) {
+        RecordingSettings settings;
+        settings.path = recordPath;
+        settings.format = recordFormat;
+        settings.every = static_cast<int>(getIntegerArgument(argc, argv, "--record-every", 1));
+        settings.cellPixels = static_cast<int>(getIntegerArgument(argc, argv, "--record-scale", 1));
+        settings.cellsPerPixel = static_cast<int>(getIntegerArgument(argc, argv, "--record-shrink", 1));
+
+        std::string error;
+        if (!startRecording(settings, getGridWidth(), getGridHeight(), error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        // The first frame is the starting board
+        recordGeneration(getGrid().data(), getWordsPerRow(), getGridWidth(), getGridHeight(), startGeneration);
+    }
+
+    // Checkpoints are written by the I/O thread while stepping goes on
+    if (checkpointing) {
+        startIoThread(nullptr);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto lastCheckpointTime = start;
+    uint64_t lastCheckpointGeneration = startGeneration;
+    uint64_t generation = startGeneration;
+    uint64_t engineGenerations[ENGINE_COUNT] = {};
+    const uint64_t endGeneration = startGeneration + static_cast<uint64_t>(generations);
+    const uint64_t recordEvery = static_cast<uint64_t>(std::max(getIntegerArgument(argc, argv, "--record-every", 1), 1LL));
+    while (generation < endGeneration) {
+        // A cluster steps in runs up to the next frame or checkpoint, and the board is only
+        // gathered into this process for those
+        bool gathered = !cluster.isRunning();
+        if (cluster.isRunning()) {
+            uint64_t stop = std::min(endGeneration, generation + 256);
+            if (recordPath != nullptr) {
+                stop = std::min(stop, (generation / recordEvery + 1) * recordEvery);
+            }
+            if (checkpoints.everyGenerations != 0) {
+                stop = std::min(stop, std::max(lastCheckpointGeneration + checkpoints.everyGenerations, generation + 1));
+            }
+            std::string error;
+            if (!cluster.step(stop - generation, error)) {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+            generation = stop;
+            if (recordPath != nullptr && generation % recordEvery == 0) {
+                Pattern board;
+                if (!cluster.gather(board, error) || !replaceBoard(board, error)) {
+                    std::cerr << error << std::endl;
+                    return 1;
+                }
+                gathered = true;
+            }
+        } else {
+            updateGrid();
+            ++engineGenerations[getLastStepEngine()];
+            ++generation;
+        }
+        if (gathered) {
+            recordGeneration(getGrid().data(), getWordsPerRow(), getGridWidth(), getGridHeight(), generation);
+        }
+
+        if (checkpointing) {
+            bool due = checkpoints.everyGenerations != 0 && generation - lastCheckpointGeneration >= checkpoints.everyGenerations;
+            if (!due && checkpoints.everySeconds > 0.0) {
+                auto now = std::chrono::steady_clock::now();
+                due = std::chrono::duration<double>(now - lastCheckpointTime).count() >= checkpoints.everySeconds;
+            }
+            if (due && tryBeginCheckpoint()) {
+                std::string error;
+                Pattern board;
+                if (!gathered && (!cluster.gather(board, error) || !replaceBoard(board, error))) {
+                    std::cerr << error << std::endl;
+                    return 1;
+                }
+                queueCheckpoint(checkpoints, copyBoard(), generation);
+                lastCheckpointGeneration = generation;
+                lastCheckpointTime = std::chrono::steady_clock::now();
+            }
+        }
+    }
+    if (cluster.isRunning()) {
+        // The final board, for the session log, save and export below
+        std::string error;
+        Pattern board;
+        if (!cluster.gather(board, error) || !replaceBoard(board, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        const ClusterStats& clusterStats = cluster.getStats();
+        std::copy(std::begin(clusterStats.engineGenerations), std::end(clusterStats.engineGenerations), engineGenerations);
+        cluster.stop();
+    }
+    stopRecording();
+    stopSessionLog(generation);
+    if (checkpointing) {
+        stopIoThread(); // Finishes the checkpoint in flight
+        IoStatus ioStatus = getIoStatus();
+        if (ioStatus.lastFailed) {
+            std::cerr << ioStatus.lastResult << std::endl;
+        } else if (!ioStatus.lastResult.empty()) {
+            std::cout << ioStatus.lastResult << std::endl;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    RecordingStatus status = getRecordingStatus();
+    std::cout << "Generations: " << generations << " (now at generation " << generation << ")\n"
+              << "Population: " << getPyramid().getPopulation() << "\n"
+              << "Seconds: " << seconds << "\n"
+              << "Generations per second: " << (seconds > 0.0 ? generations / seconds : 0.0) << "\n"
+              << "Engine " << STEP_ENGINE_NAMES[engine] << ":";
+    for (int i = 0; i < ENGINE_COUNT; ++i) {
+        std::cout << " " << STEP_ENGINE_NAMES[i] << " " << engineGenerations[i] << (i + 1 < ENGINE_COUNT ? "," : "");
+    }
+    std::cout << std::endl;
+    std::cout << "Memory: " << describePlacement(getGridPlacement()) << std::endl;
+    if (!cluster.getStats().slabRows.empty()) {
+        const ClusterStats& clusterStats = cluster.getStats();
+        std::cout << "Halo exchanges: " << clusterStats.exchanges << " per process, " << clusterStats.haloBytes << " bytes in all\n"
+                  << "Slowest process: " << clusterStats.stepSeconds << " s stepping, " << clusterStats.exchangeSeconds
+                  << " s exchanging halos" << std::endl;
+    }
+
+    if (!saveFinalBoard(argc, argv, generation)) {
+        return 1;
+    }
+    if (recordPath != nullptr) {
+        std::cout << "Frames written: " << status.framesWritten << std::endl;
+        if (!status.error.empty()) {
+            std::cerr << status.error << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "GameOfLife.h"
+
+// Command line helpers
+bool hasArgument(int argc, char* argv[], const char* name);
+const char* getArgument(int argc, char* argv[], const char* name); // Value after name, or nullptr
+bool getOffsetArgument(int argc, char* argv[], const char* name, int& x, int& y); // "X,Y" after name
+bool getEngineArgument(int argc, char* argv[], StepEngine& engine); // --engine NAME, ENGINE_AUTO if absent
+
+// Run the simulation without a window, for batch jobs on hosts without a display.
+//   --headless                     select this mode
+//   --generations N                generations to step (default 1000)
+//   --record PATH                  record the run to PATH
+//   --record-format FORMAT         y4m or raw stream, or numbered pbm or png frames (default y4m)
+//   --record-every N               record every Nth generation
+//   --record-scale N               pixels per cell
+//   --record-shrink N              cells per pixel, shown as density
+//   --pattern PATH                 start from a pattern file or snapshot, the board grown to fit
+//   --at X,Y                       place the pattern with its top-left corner at X,Y on an
+//                                  empty board of the default size instead
+//   --save PATH                    write the final generation in the format of its extension
+//   --checkpoint-every N           checkpoint every N generations
+//   --checkpoint-seconds S         checkpoint every S seconds
+//   --checkpoint-dir PATH          checkpoint directory (default checkpoints)
+//   --checkpoint-budget-mb N       disk space kept for checkpoints (default 1024)
+//   --resume                       start from the newest checkpoint and step on until
+//                                  generation --generations, so a killed job can be rerun as is
+//   --engine NAME                  step engine: dense, threaded, active, sparse or auto (default), which
+//                                  picks per generation from the measured engine costs
+//   --calibrate                    measure the engine costs again instead of reading them
+//                                  from engine-calibration.txt in ~/.cache/gol (or $XDG_CACHE_HOME/gol)
+//   --seed N                       seed of the random starting board (printed when not given)
+//   --session-log PATH             record the run as a session log
+//   --replay PATH                  replay a session log at full speed and check that it ends
+//                                  on the recorded board, then step on until generation
+//                                  --generations if that is later
+//   --processes N                  step in N worker processes, each owning a slab of rows
+//                                  (SlabCluster.h); engine counts are then summed over slabs
+//   --halo K                       rows of each neighbour a worker keeps, so halos are
+//                                  exchanged every K generations (default 8)
+//   --transport shm|socket         halo exchange over shared memory (default) or Unix-domain
+//                                  sockets
+//   --out-of-core PATH             keep the board in a file at PATH (DiskBoard.h) and step it a
+//                                  band at a time; an existing file is stepped on until
+//                                  generation --generations, a new one made from --pattern or
+//                                  a random board
+//   --size W,H                     size of a new random board file
+//   --band-mb N                    megabytes of board per band (default 32)
+int runHeadless(int argc, char* argv[]);
+
+#endif // HEADLESS_H
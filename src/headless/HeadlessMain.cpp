@@ -0,0 +1,8 @@
+#include "Headless.h"
+
+// The headless runner on its own, linked against libgol only, for hosts without SDL. It
+// takes the options of the window's --headless mode (Headless.h); --headless itself is
+// implied.
+int main(int argc, char* argv[]) {
+    return runHeadless(argc, argv);
+}
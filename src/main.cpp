@@ -2,46 +2,315 @@
 #include <imgui_impl_sdl2.h>
 #include <imgui_impl_sdlrenderer2.h>
 #include "GameOfLife.h"
+#include "Simulation.h"
+#include "FrameRecorder.h"
+#include "BackgroundIO.h"
+#include "Checkpoint.h"
+#include "PatternLibrary.h"
+#include "Headless.h"
+#include "RegionEdit.h"
+#include "EngineTuner.h"
 #include <SDL.h>
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 // Constants for window dimensions and control panel sizes
-const int WINDOW_WIDTH = GRID_WIDTH * CELL_SIZE;
-const int WINDOW_HEIGHT = GRID_HEIGHT * CELL_SIZE;
+// The board is drawn into a fixed viewport, independent of the grid size
+const int WINDOW_WIDTH = 500;
+const int WINDOW_HEIGHT = 500;
 const int CONTROL_PANEL_HEIGHT = WINDOW_HEIGHT;
 const int CONTROL_PANEL_WIDTH = 500;
 const int CONTROL_PANEL_X = 500;
 const int CONTROL_PANEL_Y = 0;
 const int HELP_WINDOW_WIDTH = 400;
 const int HELP_WINDOW_HEIGHT = 400;
+const int CELL_SIZE = 10;  // Size of each cell in pixels at the initial zoom
+
+void renderGrid(SDL_Renderer* renderer);
+void renderImGuiWidgets(SDL_Renderer* renderer);
+void cleanUp(SDL_Renderer* renderer, SDL_Window* window);
 
 // Simulation state variables
 bool isPaused = false; // Controls the simulation state
 bool running = true; // Controls the main loop
-Uint32 lastUpdateTime = 0; // Stores the last update time
-int updateInterval = 100; // Time in milliseconds between updates
+float targetRate = 10.0f; // Generations per second
+bool maxSpeed = false; // Step as many generations per frame as fit the frame budget
+float frameBudget = 14.0f; // Milliseconds of stepping per frame in max speed mode
 int cursorSize = 1;  // Initial cursor size
+
+// Redraw-on-demand: with nothing new to show, the loop blocks in SDL_WaitEventTimeout
+bool redrawOnDemand = true;
+int pendingFrames = 2; // Frames still to draw; ImGui needs a second frame to settle after input
+Uint32 snapshotEventType = 0; // Pushed by the simulation thread whenever it publishes
+const Uint32 CPU_METER_INTERVAL = 1000; // Milliseconds between CPU usage readings
+float cpuUsage = 0.0f; // Process CPU time as a percentage of one core
+float framesPerSecond = 0.0f;
+
+// Hardware counters of renderGrid on this thread, summed over a second at a time and shown
+// with those of the steps while measuring is on
+const Uint32 COUNTER_INTERVAL_MS = 1000;
+PerfCounters renderCounters;
+bool measureCounters = false;
+PerfReading shownRenderCounters;
+Uint32 renderCounterTime = 0;
+int framesDrawn = 0;
 bool isWindowSizeSet = false; // Flag to set the window size
 
 // Mouse interaction variables
 int mouseX, mouseY;
 bool leftMouseButtonPressed = false;
 bool rightMouseButtonPressed = false; 
-bool simulationJustResumed = false;
 int hoverX = -1, hoverY = -1;  // Hover cell coordinates
+
+// What a left drag does: draw cells, select a rectangle, or stamp the clipboard
+enum EditTool {
+    TOOL_DRAW,
+    TOOL_SELECT,
+    TOOL_STAMP
+};
+int editTool = TOOL_DRAW;
+bool hasSelection = false;
+int selectionAnchorX = 0, selectionAnchorY = 0; // Corner cell where the drag started
+int selectionEndX = 0, selectionEndY = 0;       // Corner cell under the mouse, both inclusive
+std::shared_ptr<const Pattern> clipboard;       // Copied cells, also the stamp brush
+bool stampMerge = true; // Stamps OR the clipboard in rather than overwriting its dead cells
+int lastStampX = 0, lastStampY = 0;             // Where the current stamp drag last stamped
 bool showHelpWindow = false; // Flag to show help window
 
+// Camera over the board: top-left corner in cell coordinates and zoom in pixels per cell
+double cameraX = 0.0;
+double cameraY = 0.0;
+double cameraZoom = CELL_SIZE;
+const double MIN_ZOOM = 1.0 / 256.0;
+const double MAX_ZOOM = 64.0;
+const double ZOOM_STEP = 1.25; // Zoom factor per mouse wheel notch
+bool middleMouseButtonPressed = false; // Middle drag pans the camera
+SDL_Texture* viewportTexture = nullptr; // Streaming texture the board is drawn into
+
 // Cell colours and state;
 bool ALIVE = true;
 ImVec4 aliveColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // White
 ImVec4 deadColor = ImVec4(0.0f, 0.0f, 0.0f, 1.0f); // Black
 ImVec4 gridColor = ImVec4(1.0f, 1.0f, 1.0f, 1.0f); // White
 
+// What the cell colours show; every mode maps a byte per pixel through a 256-entry palette
+enum ColorMode {
+    COLOR_STATE,        // Alive or dead, blended by density when zoomed out
+    COLOR_AGE,          // Generations since birth
+    COLOR_LAST_CHANGE,  // Generations since the cell last changed
+    COLOR_HEAT          // Decaying activity
+};
+int colorMode = COLOR_STATE;
+const char* COLOR_MODE_NAMES[] = { "State", "Age", "Last Change", "Heat" };
+Uint32 palette[256];
+
+// Recording settings edited in the Control Panel
+char recordPath[256] = "recording.y4m";
+int recordFormat = RECORD_Y4M;
+const char* RECORD_FORMAT_NAMES[] = { "Y4M video", "Raw grey frames", "Numbered PBM frames", "Numbered PNG frames" };
+int recordEvery = 1;
+int recordScale = 1;
+std::string recordError;
+
+// Full-resolution image export of the displayed generation
+char exportPath[256] = "board.png";
+int exportScale = 1;
+
+// Pattern file for Save State, Load State and Place Pattern, in the format of its extension
+char patternPath[256] = "grid.rle";
+int placeAt[2] = { 0, 0 };
+
+// Periodic checkpoints, written in the background; 0 turns a trigger off
+CheckpointSettings checkpointSettings;
+int checkpointEvery = 0;
+float checkpointSeconds = 0.0f;
+
+// Step engine, auto by default; the costs it is picked by are measured at startup
+int engineSetting = ENGINE_AUTO;
+std::string calibrationMessage;
+
+// Session log of every edit, replayed with --headless --replay
+bool recordingSession = false;
+char sessionLogPath[256] = "session.gollog";
+
+// Pattern library browser
+bool showLibraryWindow = false;
+bool libraryScanned = false; // The folder is scanned the first time the window opens
+char libraryFolder[256] = "patterns";
+char libraryFilter[64] = "";
+std::vector<LibraryEntry> libraryEntries;
+uint64_t libraryVersion = 0;
+std::vector<int> libraryRows; // Entries matching the filter
+std::string libraryRowsFilter;
+int librarySelected = -1; // Entry index
+std::unordered_map<uint64_t, SDL_Texture*> thumbnailTextures; // By pattern hash
+const int LIBRARY_WINDOW_WIDTH = 480;
+const int LIBRARY_WINDOW_HEIGHT = 460;
+const float THUMBNAIL_ROW_SIZE = 32.0f; // Thumbnail side in the list, in pixels
+const size_t MAX_THUMBNAIL_TEXTURES = 1024; // Beyond this the textures are dropped and reloaded from the disk cache
+
 SDL_Renderer* tempRenderer = nullptr;
 
+// Wake the event loop when the simulation thread publishes a new snapshot
+void notifySnapshotPublished() {
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = snapshotEventType;
+    SDL_PushEvent(&event);
+}
+
+// Wake the event loop when the pattern library has news, so thumbnails show without input
+void notifyLibraryUpdated() {
+    notifySnapshotPublished();
+}
+
+// CPU time used by the whole process, in seconds
+double processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (kernel.QuadPart + user.QuadPart) * 1e-7; // 100 ns units
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+// Refresh the CPU and frame rate readings once per CPU_METER_INTERVAL.
+// Returns true when a new reading is available.
+bool updateCpuMeter() {
+    static Uint32 lastReadingTime = SDL_GetTicks();
+    static double lastCpuSeconds = processCpuSeconds();
+
+    Uint32 now = SDL_GetTicks();
+    if (now - lastReadingTime < CPU_METER_INTERVAL) {
+        return false;
+    }
+
+    double cpuSeconds = processCpuSeconds();
+    double wallSeconds = (now - lastReadingTime) / 1000.0;
+    cpuUsage = static_cast<float>((cpuSeconds - lastCpuSeconds) / wallSeconds * 100.0);
+    framesPerSecond = static_cast<float>(framesDrawn / wallSeconds);
+    framesDrawn = 0;
+    lastReadingTime = now;
+    lastCpuSeconds = cpuSeconds;
+    return true;
+}
+
+// Map a window pixel to the board cell under it
+void screenToCell(int screenX, int screenY, int& cellX, int& cellY) {
+    cellX = static_cast<int>(std::floor(cameraX + screenX / cameraZoom));
+    cellY = static_cast<int>(std::floor(cameraY + screenY / cameraZoom));
+}
+
+// Zoom by the given factor, keeping the board point under (screenX, screenY) fixed
+void zoomAt(int screenX, int screenY, double factor) {
+    double boardX = cameraX + screenX / cameraZoom;
+    double boardY = cameraY + screenY / cameraZoom;
+    cameraZoom = std::min(std::max(cameraZoom * factor, MIN_ZOOM), MAX_ZOOM);
+    cameraX = boardX - screenX / cameraZoom;
+    cameraY = boardY - screenY / cameraZoom;
+}
+
+void resetCamera() {
+    cameraX = 0.0;
+    cameraY = 0.0;
+    cameraZoom = CELL_SIZE;
+}
+
+// The selection as a rectangle, clipped to the board; false if nothing of it is on the board
+bool getSelection(int& x, int& y, int& width, int& height) {
+    const GridSnapshot& snapshot = getSnapshot();
+    int x0 = std::max(std::min(selectionAnchorX, selectionEndX), 0);
+    int y0 = std::max(std::min(selectionAnchorY, selectionEndY), 0);
+    int x1 = std::min(std::max(selectionAnchorX, selectionEndX) + 1, snapshot.width);
+    int y1 = std::min(std::max(selectionAnchorY, selectionEndY) + 1, snapshot.height);
+    if (!hasSelection || x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+    x = x0;
+    y = y0;
+    width = x1 - x0;
+    height = y1 - y0;
+    return true;
+}
+
+void editSelection(RegionEdit edit) {
+    SimCommand command;
+    command.type = SimCommandType::EditRegion;
+    command.value = edit;
+    if (getSelection(command.x, command.y, command.width, command.height)) {
+        postCommand(command);
+        // The selection turns with the cells, on its top-left corner
+        if (edit == EDIT_ROTATE_CLOCKWISE || edit == EDIT_ROTATE_COUNTERCLOCKWISE) {
+            selectionAnchorX = command.x;
+            selectionAnchorY = command.y;
+            selectionEndX = command.x + command.height - 1;
+            selectionEndY = command.y + command.width - 1;
+        }
+    }
+}
+
+// Copy what is on screen under the selection, so the clipboard holds what the user saw
+void copySelection(bool cut) {
+    int x, y, width, height;
+    if (!getSelection(x, y, width, height)) {
+        return;
+    }
+    const GridSnapshot& snapshot = getSnapshot();
+    clipboard = std::make_shared<const Pattern>(extractRegion(snapshot.cells.data(), snapshot.wordsPerRow, snapshot.width,
+                                                              snapshot.height, x, y, width, height));
+    if (cut) {
+        editSelection(EDIT_CLEAR);
+    }
+}
+
+void pasteClipboard(int x, int y) {
+    SimCommand command;
+    command.type = SimCommandType::Paste;
+    command.x = x;
+    command.y = y;
+    command.state = stampMerge;
+    command.pattern = clipboard;
+    postCommand(command);
+}
+
+// Turn or mirror the clipboard, e.g. to stamp it the other way round
+void transformClipboard(RegionEdit edit) {
+    if (!clipboard) {
+        return;
+    }
+    Pattern pattern = edit == EDIT_ROTATE_CLOCKWISE || edit == EDIT_ROTATE_COUNTERCLOCKWISE
+                          ? rotatePattern(*clipboard, edit == EDIT_ROTATE_CLOCKWISE)
+                          : *clipboard;
+    if (edit == EDIT_FLIP_HORIZONTAL || edit == EDIT_FLIP_VERTICAL) {
+        flipPattern(pattern, edit == EDIT_FLIP_HORIZONTAL);
+    }
+    clipboard = std::make_shared<const Pattern>(std::move(pattern));
+}
+
 // Main function
 int main(int argc, char* argv[]) {
+    if (hasArgument(argc, argv, "--headless")) {
+        return runHeadless(argc, argv);
+    }
+
     // Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "Failed to initialize SDL: " << SDL_GetError() << std::endl;
@@ -79,16 +348,103 @@ int main(int argc, char* argv[]) {
     ImGui_ImplSDL2_InitForSDLRenderer(window_ptr, renderer_ptr);
     ImGui_ImplSDLRenderer2_Init(renderer_ptr);
 
-    // Initialize Game of Life grid
-    initializeGrid();
+    // Checkpoint options, shared with the headless runner
+    if (getArgument(argc, argv, "--checkpoint-dir") != nullptr) {
+        checkpointSettings.directory = getArgument(argc, argv, "--checkpoint-dir");
+    }
+    if (getArgument(argc, argv, "--checkpoint-every") != nullptr) {
+        checkpointEvery = std::max(std::atoi(getArgument(argc, argv, "--checkpoint-every")), 0);
+    }
+    if (getArgument(argc, argv, "--checkpoint-seconds") != nullptr) {
+        checkpointSeconds = std::max(static_cast<float>(std::atof(getArgument(argc, argv, "--checkpoint-seconds"))), 0.0f);
+    }
+    checkpointSettings.everyGenerations = checkpointEvery;
+    checkpointSettings.everySeconds = checkpointSeconds;
+
+    // Engine costs are measured once per machine, before the first board is set up
+    StepEngine engine;
+    if (!getEngineArgument(argc, argv, engine)) {
+        std::cerr << "Unknown engine: " << getArgument(argc, argv, "--engine") << std::endl;
+    }
+    engineSetting = engine;
+    setEngineCosts(loadEngineCosts(getEngineCalibrationPath(), hasArgument(argc, argv, "--calibrate"), calibrationMessage));
+    setStepEngine(engine);
+
+    // Initialize Game of Life grid and hand it to the simulation thread
+    initializeGrid(randomSeed());
+    snapshotEventType = SDL_RegisterEvents(1);
+    setPublishCallback(notifySnapshotPublished);
+    setCheckpointSettings(checkpointSettings);
+    startSimulation(isPaused, targetRate);
+    startLibrary(notifyLibraryUpdated);
+    // Only this thread: the threads it has started run alongside rendering, not in it
+    renderCounters.open(false);
+    // --session-log PATH records the session from its first board on, for --replay
+    if (getArgument(argc, argv, "--session-log") != nullptr) {
+        std::snprintf(sessionLogPath, sizeof(sessionLogPath), "%s", getArgument(argc, argv, "--session-log"));
+        recordingSession = true;
+        SimCommand command;
+        command.type = SimCommandType::StartSessionLog;
+        command.path = sessionLogPath;
+        postCommand(command);
+    }
+    // --load PATH starts from a pattern, centred on a board grown to fit or placed at --at X,Y
+    if (getArgument(argc, argv, "--load") != nullptr) {
+        std::snprintf(patternPath, sizeof(patternPath), "%s", getArgument(argc, argv, "--load"));
+        SimCommand command;
+        command.type = SimCommandType::Load;
+        command.path = patternPath;
+        command.state = getOffsetArgument(argc, argv, "--at", placeAt[0], placeAt[1]);
+        command.x = placeAt[0];
+        command.y = placeAt[1];
+        postCommand(command);
+    }
+    if (hasArgument(argc, argv, "--resume") && hasCheckpoint(checkpointSettings.directory)) {
+        SimCommand command;
+        command.type = SimCommandType::ResumeCheckpoint;
+        postCommand(command);
+    }
 
     // Main loop
     while(running) {
         SDL_Event e;
-        while(SDL_PollEvent(&e)) {
+        bool haveEvent;
+        if (redrawOnDemand && pendingFrames == 0) {
+            // Nothing to draw: sleep until input, a new snapshot or the next CPU reading
+            haveEvent = SDL_WaitEventTimeout(&e, CPU_METER_INTERVAL) != 0;
+        } else {
+            haveEvent = SDL_PollEvent(&e) != 0;
+        }
+
+        for (; haveEvent; haveEvent = SDL_PollEvent(&e) != 0) {
+            // Input may change the hover cursor or ImGui state; a snapshot only changes the board
+            pendingFrames = e.type == snapshotEventType ? std::max(pendingFrames, 1) : 2;
+
             if (e.type == SDL_MOUSEMOTION) {
-                hoverX = e.motion.x / CELL_SIZE;
-                hoverY = e.motion.y / CELL_SIZE;
+                screenToCell(e.motion.x, e.motion.y, hoverX, hoverY);
+
+                // Pan by the distance dragged, converted to cells
+                if (middleMouseButtonPressed) {
+                    cameraX -= e.motion.xrel / cameraZoom;
+                    cameraY -= e.motion.yrel / cameraZoom;
+                }
+            }
+
+            // Zoom around the mouse cursor
+            if (e.type == SDL_MOUSEWHEEL && !ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow)) {
+                int wheelX, wheelY;
+                SDL_GetMouseState(&wheelX, &wheelY);
+                if (wheelX < WINDOW_WIDTH) {
+                    zoomAt(wheelX, wheelY, std::pow(ZOOM_STEP, e.wheel.y));
+                }
+            }
+
+            if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_MIDDLE) {
+                middleMouseButtonPressed = true;
+            }
+
+            if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_MIDDLE) {
+                middleMouseButtonPressed = false;
             }
 
             if (e.type == SDL_QUIT) {
@@ -114,67 +470,115 @@ int main(int argc, char* argv[]) {
                 leftMouseButtonPressed = false;
             }
 
-            if (rightMouseButtonPressed && !ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow)) {
+            // Only motion and button events carry a mouse position
+            bool isPaintEvent = (e.type == SDL_MOUSEMOTION || e.type == SDL_MOUSEBUTTONDOWN) && e.motion.x < WINDOW_WIDTH;
+
+            if (isPaintEvent && rightMouseButtonPressed && !ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow)) {
                 int mouseX = e.motion.x;
                 int mouseY = e.motion.y;
 
-                int gridX = mouseX / CELL_SIZE;
-                int gridY = mouseY / CELL_SIZE;
+                int gridX, gridY;
+                screenToCell(mouseX, mouseY, gridX, gridY);
 
             // Set cells within the cursor size to dead
-                for (int dx = 0; dx < cursorSize; ++dx) {
-                    for (int dy = 0; dy < cursorSize; ++dy) {
-                        int cellX = gridX + dx;
-                        int cellY = gridY + dy;
-                        if (cellX < GRID_WIDTH && cellY < GRID_HEIGHT) {
-                            setCellState(cellX, cellY, false); // Set the cell to dead
-                        }
-                    }
+                SimCommand paint;
+                paint.type = SimCommandType::Paint;
+                paint.x = gridX;
+                paint.y = gridY;
+                paint.size = cursorSize;
+                paint.state = false;
+                postCommand(paint);
+            }
+
+            // Select and stamp tools: a press starts a selection or a stamp, motion drags it on
+            bool boardEvent = isPaintEvent && leftMouseButtonPressed && !ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow);
+            if (boardEvent && editTool == TOOL_SELECT) {
+                screenToCell(e.motion.x, e.motion.y, selectionEndX, selectionEndY);
+                if (e.type == SDL_MOUSEBUTTONDOWN) {
+                    selectionAnchorX = selectionEndX;
+                    selectionAnchorY = selectionEndY;
+                    hasSelection = true;
+                }
+            }
+            if (boardEvent && editTool == TOOL_STAMP && clipboard) {
+                int gridX, gridY;
+                screenToCell(e.motion.x, e.motion.y, gridX, gridY);
+                if (e.type == SDL_MOUSEBUTTONDOWN || gridX != lastStampX || gridY != lastStampY) {
+                    pasteClipboard(gridX - clipboard->width / 2, gridY - clipboard->height / 2);
+                    lastStampX = gridX;
+                    lastStampY = gridY;
+                }
+            }
+
+            // Keyboard shortcuts for the selection, unless an ImGui field has the keyboard
+            if (e.type == SDL_KEYDOWN && !ImGui::GetIO().WantCaptureKeyboard) {
+                bool control = (e.key.keysym.mod & KMOD_CTRL) != 0;
+                SDL_Keycode key = e.key.keysym.sym;
+                if (control && key == SDLK_c) {
+                    copySelection(false);
+                } else if (control && key == SDLK_x) {
+                    copySelection(true);
+                } else if (control && key == SDLK_v && clipboard) {
+                    pasteClipboard(hoverX, hoverY);
+                } else if (key == SDLK_DELETE || key == SDLK_BACKSPACE) {
+                    editSelection(EDIT_CLEAR);
+                } else if (key == SDLK_ESCAPE) {
+                    hasSelection = false;
                 }
             }
 
             // Handle mouse motion
-            if (leftMouseButtonPressed && !ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow)) {
+            if (isPaintEvent && leftMouseButtonPressed && editTool == TOOL_DRAW && !ImGui::IsWindowHovered(ImGuiHoveredFlags_AnyWindow)) {
                 int mouseX = e.motion.x;
                 int mouseY = e.motion.y;
 
-                int gridX = mouseX / CELL_SIZE;
-                int gridY = mouseY / CELL_SIZE;
+                int gridX, gridY;
+                screenToCell(mouseX, mouseY, gridX, gridY);
 
                 // Set cells within the cursor size to alive
-                for (int dx = 0; dx < cursorSize; ++dx) {
-                    for (int dy = 0; dy < cursorSize; ++dy) {
-                        int cellX = gridX + dx;
-                        int cellY = gridY + dy;
-                        if (cellX < GRID_WIDTH && cellY < GRID_HEIGHT) {
-                            setCellState(cellX, cellY, true); // Set the cell to alive
-                        }
-                    }
-                }
+                SimCommand paint;
+                paint.type = SimCommandType::Paint;
+                paint.x = gridX;
+                paint.y = gridY;
+                paint.size = cursorSize;
+                paint.state = true;
+                postCommand(paint);
             }
             ImGui_ImplSDL2_ProcessEvent(&e);
         }
 
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastUpdateTime > updateInterval) {
+        // Pick up the latest generation published by the simulation thread
+        if (acquireSnapshot()) {
+            pendingFrames = std::max(pendingFrames, 1);
+        }
+        if (updateCpuMeter()) {
+            pendingFrames = std::max(pendingFrames, 1);
+        }
 
-            // Update Game of Life
-            if (!isPaused && simulationJustResumed) {
-                updateGrid(true);  // Use the temp grid for this update
-                simulationJustResumed = false;
-            } else if (!isPaused) {
-                updateGrid();  // Normal update
-            }
-        
-            lastUpdateTime = currentTime;
+        if (redrawOnDemand && pendingFrames == 0) {
+            continue;
+        }
+        if (pendingFrames > 0) {
+            --pendingFrames;
         }
+        ++framesDrawn;
 
          // Clear the screen
         SDL_SetRenderDrawColor(renderer_ptr, 120, 180, 255, 255);
         SDL_RenderClear(renderer_ptr);
 
         // Render the Game of Life grid
-        renderGrid(renderer_ptr);
+        if (measureCounters) {
+            renderCounters.start();
+            renderGrid(renderer_ptr);
+            renderCounters.stop(1);
+            if (SDL_GetTicks() - renderCounterTime >= COUNTER_INTERVAL_MS) {
+                shownRenderCounters = renderCounters.takeReading();
+                renderCounterTime = SDL_GetTicks();
+            }
+        } else {
+            renderGrid(renderer_ptr);
+        }
 
         // Start ImGui frame
         ImGui_ImplSDLRenderer2_NewFrame();
@@ -190,44 +594,330 @@ int main(int argc, char* argv[]) {
         SDL_RenderPresent(renderer_ptr);
     }
 
+    stopSimulation();
+    stopRecording();
+    stopLibrary();
     cleanUp(renderer_ptr, window_ptr);
     return 0;  // Ensure to return 0
 }
 
-// Function to render the Game of Life grid
+// Pack an ImGui colour into an ARGB8888 pixel
+Uint32 toPixel(const ImVec4& color) {
+    return 0xFF000000u | (Uint32(color.x * 255) << 16) | (Uint32(color.y * 255) << 8) | Uint32(color.z * 255);
+}
+
+// Colour at t in [0, 1] along evenly spaced gradient stops
+ImVec4 gradientColor(const ImVec4* stops, int stopCount, float t) {
+    float position = t * (stopCount - 1);
+    int index = std::min(static_cast<int>(position), stopCount - 2);
+    float blend = position - index;
+    const ImVec4& from = stops[index];
+    const ImVec4& to = stops[index + 1];
+    return ImVec4(from.x + (to.x - from.x) * blend,
+                  from.y + (to.y - from.y) * blend,
+                  from.z + (to.z - from.z) * blend, 1.0f);
+}
+
+// Fill the palette for the current colour mode
+void buildPalette() {
+    const ImVec4 ageStops[] = { aliveColor, ImVec4(1.0f, 0.6f, 0.1f, 1.0f), ImVec4(0.6f, 0.1f, 0.6f, 1.0f), ImVec4(0.1f, 0.1f, 0.6f, 1.0f) };
+    const ImVec4 lastChangeStops[] = { ImVec4(1.0f, 1.0f, 1.0f, 1.0f), ImVec4(1.0f, 0.8f, 0.2f, 1.0f), ImVec4(0.6f, 0.1f, 0.1f, 1.0f), deadColor };
+    const ImVec4 heatStops[] = { deadColor, ImVec4(0.5f, 0.0f, 0.0f, 1.0f), ImVec4(1.0f, 0.3f, 0.0f, 1.0f), ImVec4(1.0f, 0.9f, 0.2f, 1.0f), ImVec4(1.0f, 1.0f, 1.0f, 1.0f) };
+    const ImVec4 stateStops[] = { deadColor, aliveColor };
+
+    for (int i = 0; i < 256; ++i) {
+        float t = i / 255.0f;
+        switch (colorMode) {
+            case COLOR_AGE:
+                // Zero age means dead, so it keeps the dead colour
+                palette[i] = i == 0 ? toPixel(deadColor) : toPixel(gradientColor(ageStops, 4, (i - 1) / 254.0f));
+                break;
+            case COLOR_LAST_CHANGE:
+                palette[i] = toPixel(gradientColor(lastChangeStops, 4, t));
+                break;
+            case COLOR_HEAT:
+                palette[i] = toPixel(gradientColor(heatStops, 5, t));
+                break;
+            default:
+                palette[i] = toPixel(gradientColor(stateStops, 2, t));
+                break;
+        }
+    }
+}
+
+// Screen rectangle of a rectangle of cells, at least a pixel across
+SDL_Rect cellRect(int x, int y, int width, int height) {
+    int left = static_cast<int>(std::floor((x - cameraX) * cameraZoom));
+    int top = static_cast<int>(std::floor((y - cameraY) * cameraZoom));
+    int right = static_cast<int>(std::ceil((x + width - cameraX) * cameraZoom));
+    int bottom = static_cast<int>(std::ceil((y + height - cameraY) * cameraZoom));
+    return SDL_Rect{ left, top, std::max(right - left, 1), std::max(bottom - top, 1) };
+}
+
+// Function to render the Game of Life grid through the camera.
+// The view and the channel it colours by, for the simulation thread to sample the channel at
+SimViewport getShownViewport() {
+    SimViewport viewport;
+    viewport.x = cameraX;
+    viewport.y = cameraY;
+    viewport.zoom = cameraZoom;
+    viewport.columns = WINDOW_WIDTH;
+    viewport.rows = WINDOW_HEIGHT;
+    viewport.channel = colorMode == COLOR_STATE ? -1 : colorMode == COLOR_AGE ? AUX_AGE : colorMode == COLOR_LAST_CHANGE ? AUX_LAST_CHANGE : AUX_HEAT;
+    return viewport;
+}
+
+// Every viewport pixel is mapped to the block of cells it covers, so the cost tracks the
+// viewport rather than the board: zoomed in a pixel shows one cell, zoomed out it shows
+// the population density of its block. In the channel colour modes a zoomed-out pixel
+// shows the top-left cell of its block instead.
 void renderGrid(SDL_Renderer* renderer) {
-    auto& grid = getGrid(); // Access the grid from GameOfLife
+    const GridSnapshot& snapshot = getSnapshot();
 
-    SDL_RenderClear(renderer);
-    
-    // Iterate through each cell in the grid
-    for (int x = 0; x < GRID_WIDTH; ++x) {
-        for (int y = 0; y < GRID_HEIGHT; ++y) {
+    SimViewport shown = getShownViewport();
+    static SimViewport postedViewport;
+    if (shown != postedViewport) {
+        SimCommand command;
+        command.type = SimCommandType::SetViewport;
+        command.viewport = shown;
+        postCommand(command);
+        postedViewport = shown;
+    }
 
+    if (viewportTexture == nullptr) {
+        viewportTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                            WINDOW_WIDTH, WINDOW_HEIGHT);
+        if (viewportTexture == nullptr) {
+            std::cerr << "Failed to create viewport texture: " << SDL_GetError() << std::endl;
+            return;
+        }
+    }
 
-            SDL_Rect cell;
-            cell.x = x * CELL_SIZE;
-            cell.y = y * CELL_SIZE;
-            cell.w = CELL_SIZE;
-            cell.h = CELL_SIZE;
+    // Cell boundaries of every viewport column and row
+    static std::vector<int> columnEdges(WINDOW_WIDTH + 1);
+    static std::vector<int> rowEdges(WINDOW_HEIGHT + 1);
+    for (int sx = 0; sx <= WINDOW_WIDTH; ++sx) {
+        columnEdges[sx] = static_cast<int>(std::floor(cameraX + sx / cameraZoom));
+    }
+    for (int sy = 0; sy <= WINDOW_HEIGHT; ++sy) {
+        rowEdges[sy] = static_cast<int>(std::floor(cameraY + sy / cameraZoom));
+    }
 
-            // Set color based on cell state and hover state
-            if (x >= hoverX && x < hoverX + cursorSize && y >= hoverY && y < hoverY + cursorSize && grid[x][y] == 0) {
-                SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255); // Alive color
-            } else if (grid[x][y]) {
-                SDL_SetRenderDrawColor(renderer, aliveColor.x * 255, aliveColor.y * 255, aliveColor.z * 255, 255); // Highlight color
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(viewportTexture, nullptr, &pixels, &pitch) != 0) {
+        return;
+    }
+
+    const Uint32 backgroundPixel = 0xFF78B4FF; // Outside the board
+    const Uint32 hoverPixel = 0xFFC8C8C8;
+    buildPalette();
+
+    // Channel modes need the channel sampled by the simulation thread. While a moved view is
+    // on its way there, each pixel takes the nearest sample of the view last sampled; where
+    // that view does not reach, or before any channel arrives, the pixel shows the state.
+    const SimViewport& sampled = snapshot.auxViewport;
+    bool showChannel = shown.channel >= 0 && !snapshot.auxView.empty() && sampled.channel == shown.channel;
+    bool sampledHere = sampled == shown;
+
+    for (int sy = 0; sy < WINDOW_HEIGHT; ++sy) {
+        Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(pixels) + sy * pitch);
+        int y0 = std::max(rowEdges[sy], 0);
+        int y1 = std::min(std::max(rowEdges[sy + 1], rowEdges[sy] + 1), snapshot.height);
+
+        for (int sx = 0; sx < WINDOW_WIDTH; ++sx) {
+            int x0 = std::max(columnEdges[sx], 0);
+            int x1 = std::min(std::max(columnEdges[sx + 1], columnEdges[sx] + 1), snapshot.width);
+            if (x0 >= x1 || y0 >= y1) {
+                row[sx] = backgroundPixel;
+                continue;
+            }
+
+            bool empty;
+            int paletteIndex;
+            int sampleX = sx;
+            int sampleY = sy;
+            if (showChannel && !sampledHere) {
+                sampleX = static_cast<int>(std::floor((x0 - sampled.x) * sampled.zoom));
+                sampleY = static_cast<int>(std::floor((y0 - sampled.y) * sampled.zoom));
+            }
+            if (showChannel && sampleX >= 0 && sampleX < sampled.columns && sampleY >= 0 && sampleY < sampled.rows) {
+                empty = !snapshot.getCellState(x0, y0);
+                paletteIndex = snapshot.auxView[static_cast<size_t>(sampleY) * sampled.columns + sampleX];
             } else {
-                SDL_SetRenderDrawColor(renderer, deadColor.x * 255, deadColor.y * 255, deadColor.z * 255, 255); // Dead color
+                int area = (x1 - x0) * (y1 - y0);
+                int liveCells = area == 1 ? (snapshot.getCellState(x0, y0) ? 1 : 0) : static_cast<int>(snapshot.countLiveCells(x0, y0, x1, y1));
+                empty = liveCells == 0;
+                paletteIndex = liveCells * 255 / area;
             }
+            bool hovered = editTool == TOOL_DRAW && x0 < hoverX + cursorSize && x1 > hoverX && y0 < hoverY + cursorSize && y1 > hoverY;
 
-            // Draw cell
-            SDL_RenderFillRect(renderer, &cell);
+            // Set color based on cell state and hover state
+            row[sx] = hovered && empty ? hoverPixel : palette[paletteIndex];
         }
     }
+
+    SDL_UnlockTexture(viewportTexture);
+
+    SDL_Rect viewport = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
+    SDL_RenderCopy(renderer, viewportTexture, nullptr, &viewport);
+
+    // Outlines of the selection and of where the stamp brush would land
+    SDL_RenderSetClipRect(renderer, &viewport);
+    int x, y, width, height;
+    if (getSelection(x, y, width, height)) {
+        SDL_Rect outline = cellRect(x, y, width, height);
+        SDL_SetRenderDrawColor(renderer, 255, 220, 0, 255);
+        SDL_RenderDrawRect(renderer, &outline);
+    }
+    if (editTool == TOOL_STAMP && clipboard) {
+        SDL_Rect outline = cellRect(hoverX - clipboard->width / 2, hoverY - clipboard->height / 2, clipboard->width, clipboard->height);
+        SDL_SetRenderDrawColor(renderer, 0, 200, 255, 255);
+        SDL_RenderDrawRect(renderer, &outline);
+    }
+    SDL_RenderSetClipRect(renderer, nullptr);
 }
 
 
 int cellSize = CELL_SIZE;
+
+// Post a command without arguments to the simulation thread
+void postSimpleCommand(SimCommandType type, int value = 0) {
+    SimCommand command;
+    command.type = type;
+    command.value = value;
+    postCommand(command);
+}
+
+// Turn finished thumbnails into textures, grey levels showing live-cell density
+void updateThumbnailTextures(SDL_Renderer* renderer) {
+    std::vector<Thumbnail> thumbnails;
+    takeThumbnails(thumbnails);
+    if (thumbnailTextures.size() + thumbnails.size() > MAX_THUMBNAIL_TEXTURES) {
+        for (auto& thumbnail : thumbnailTextures) {
+            SDL_DestroyTexture(thumbnail.second);
+        }
+        thumbnailTextures.clear();
+    }
+    for (const Thumbnail& thumbnail : thumbnails) {
+        if (thumbnailTextures.count(thumbnail.hash) != 0) {
+            continue;
+        }
+        SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+        if (texture == nullptr) {
+            continue;
+        }
+        std::vector<Uint32> pixels(thumbnail.pixels.size());
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            Uint32 level = thumbnail.pixels[i];
+            pixels[i] = 0xFF000000u | (level << 16) | (level << 8) | level;
+        }
+        SDL_UpdateTexture(texture, nullptr, pixels.data(), THUMBNAIL_SIZE * sizeof(Uint32));
+        thumbnailTextures[thumbnail.hash] = texture;
+    }
+}
+
+// Thumbnail of an entry, or a blank square while it is rendered in the background
+void drawThumbnail(const LibraryEntry& entry, float size) {
+    auto texture = thumbnailTextures.find(entry.hash);
+    if (texture != thumbnailTextures.end()) {
+        ImGui::Image(texture->second, ImVec2(size, size));
+    } else {
+        requestThumbnail(entry);
+        ImGui::Dummy(ImVec2(size, size));
+    }
+}
+
+// Browse the indexed pattern files and stamp the selected one into the board at the
+// Place Pattern offset. Only the visible rows are laid out, so thousands of files scroll freely.
+void renderLibraryWindow(SDL_Renderer* renderer) {
+    if (!libraryScanned) {
+        scanLibrary(libraryFolder);
+        libraryScanned = true;
+    }
+    updateThumbnailTextures(renderer);
+    if (getLibraryEntries(libraryEntries, libraryVersion)) {
+        librarySelected = -1;
+        libraryRowsFilter = "\n"; // Refilter
+    }
+    if (libraryRowsFilter != libraryFilter) {
+        libraryRowsFilter = libraryFilter;
+        libraryRows.clear();
+        for (int i = 0; i < static_cast<int>(libraryEntries.size()); ++i) {
+            if (libraryEntries[i].path.find(libraryRowsFilter) != std::string::npos) {
+                libraryRows.push_back(i);
+            }
+        }
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(LIBRARY_WINDOW_WIDTH, LIBRARY_WINDOW_HEIGHT), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Pattern Library", &showLibraryWindow)) {
+        ImGui::End();
+        return;
+    }
+    ImGui::InputText("Folder", libraryFolder, sizeof(libraryFolder));
+    ImGui::SameLine();
+    if (ImGui::Button("Scan")) {
+        scanLibrary(libraryFolder);
+    }
+    LibraryStatus status = getLibraryStatus();
+    if (status.scanning) {
+        ImGui::Text("Scanning... %zu patterns, %zu read", status.filesSeen, status.filesParsed);
+    } else if (!status.message.empty()) {
+        ImGui::TextColored(status.failed ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f), "%s", status.message.c_str());
+    }
+    ImGui::InputText("Filter", libraryFilter, sizeof(libraryFilter));
+
+    // Details and the stamp button for the selected pattern
+    if (librarySelected >= 0) {
+        const LibraryEntry& entry = libraryEntries[librarySelected];
+        drawThumbnail(entry, THUMBNAIL_SIZE * 2.0f);
+        ImGui::SameLine();
+        ImGui::BeginGroup();
+        ImGui::Text("%s", entry.path.c_str());
+        ImGui::Text("%dx%d, %llu live cells", entry.width, entry.height, static_cast<unsigned long long>(entry.population));
+        ImGui::Text("Live area %dx%d at %d,%d", entry.boxWidth, entry.boxHeight, entry.boxX, entry.boxY);
+        ImGui::Text("Rule: %s", entry.rule.empty() ? "none, keeps the board's" : entry.rule.c_str());
+        if (ImGui::Button("Stamp At")) {
+            SimCommand command;
+            command.type = SimCommandType::Load;
+            command.path = getLibraryPath(entry);
+            command.state = true;
+            command.x = placeAt[0];
+            command.y = placeAt[1];
+            postCommand(command);
+        }
+        ImGui::SameLine();
+        ImGui::PushItemWidth(100);
+        ImGui::InputInt2("##StampAt", placeAt);
+        ImGui::PopItemWidth();
+        placeAt[0] = std::max(placeAt[0], 0);
+        placeAt[1] = std::max(placeAt[1], 0);
+        ImGui::EndGroup();
+    }
+
+    ImGui::BeginChild("Patterns");
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(libraryRows.size()), THUMBNAIL_ROW_SIZE + ImGui::GetStyle().ItemSpacing.y);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            const LibraryEntry& entry = libraryEntries[libraryRows[row]];
+            ImGui::PushID(row);
+            drawThumbnail(entry, THUMBNAIL_ROW_SIZE);
+            ImGui::SameLine();
+            char label[512];
+            std::snprintf(label, sizeof(label), "%s  (%dx%d, %llu cells)", entry.path.c_str(), entry.width, entry.height,
+                          static_cast<unsigned long long>(entry.population));
+            if (ImGui::Selectable(label, librarySelected == libraryRows[row], 0, ImVec2(0.0f, THUMBNAIL_ROW_SIZE))) {
+                librarySelected = libraryRows[row];
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
+
 void renderImGuiWidgets(SDL_Renderer* renderer) {
     ImGui::SetNextWindowPos(ImVec2(CONTROL_PANEL_X, CONTROL_PANEL_Y));
     ImGui::SetNextWindowSize(ImVec2(CONTROL_PANEL_WIDTH, CONTROL_PANEL_HEIGHT)); // replace newWidth and newHeight with the desired values
@@ -236,32 +926,101 @@ void renderImGuiWidgets(SDL_Renderer* renderer) {
     // Start/Pause Simulation
     if (ImGui::Button(isPaused ? "Resume Simulation" : "Pause Simulation")) {
         isPaused = !isPaused;
+        postSimpleCommand(SimCommandType::SetPaused, isPaused);
     }
 
     // Reset the Simulation
     if (ImGui::Button("Reset Simulation")) {
-        initializeGrid();
+        postSimpleCommand(SimCommandType::Reset);
     }
 
     if (ImGui::Button("Clear Board")) {
-        clearGrid();  
+        postSimpleCommand(SimCommandType::Clear);
     }
 
     // Save the current state
+    ImGui::InputText("Pattern Path", patternPath, sizeof(patternPath));
     if (ImGui::Button("Save State")) {
-        // Implement the save functionality
-        saveGrid();
+        SimCommand command;
+        command.type = SimCommandType::Save;
+        command.path = patternPath;
+        postCommand(command);
     }
 
     // Load a previously saved state
+    ImGui::SameLine();
     if (ImGui::Button("Load State")) {
-        // Implement the load functionality
-        loadGrid();
+        SimCommand command;
+        command.type = SimCommandType::Load;
+        command.path = patternPath;
+        postCommand(command);
     }
 
+    // Stamp the pattern into the running board, top-left corner at the given cell
+    ImGui::SameLine();
+    if (ImGui::Button("Place Pattern")) {
+        SimCommand command;
+        command.type = SimCommandType::Load;
+        command.path = patternPath;
+        command.state = true;
+        command.x = placeAt[0];
+        command.y = placeAt[1];
+        postCommand(command);
+    }
+    ImGui::SameLine();
+    ImGui::PushItemWidth(100);
+    ImGui::InputInt2("At", placeAt);
+    ImGui::PopItemWidth();
+    placeAt[0] = std::max(placeAt[0], 0);
+    placeAt[1] = std::max(placeAt[1], 0);
+
+    // Binary snapshots restore the board size, rule and generation exactly
+    if (ImGui::Button("Save Snapshot")) {
+        postSimpleCommand(SimCommandType::SaveSnapshot);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load Snapshot")) {
+        postSimpleCommand(SimCommandType::LoadSnapshot);
+    }
+
+    // Checkpoints: a base image plus deltas against it, so even frequent ones stay cheap
+    bool checkpointsChanged = ImGui::InputInt("Checkpoint Every (gen)", &checkpointEvery, 100, 1000);
+    checkpointsChanged |= ImGui::InputFloat("Checkpoint Every (s)", &checkpointSeconds, 10.0f, 60.0f, "%.0f");
+    if (checkpointsChanged) {
+        checkpointEvery = std::max(checkpointEvery, 0);
+        checkpointSeconds = std::max(checkpointSeconds, 0.0f);
+        SimCommand command;
+        command.type = SimCommandType::SetCheckpoints;
+        command.value = checkpointEvery;
+        command.rate = checkpointSeconds;
+        postCommand(command);
+    }
+    if (ImGui::Button("Resume From Checkpoint")) {
+        postSimpleCommand(SimCommandType::ResumeCheckpoint);
+    }
+
+    // Session log: the starting board and every edit since, a few bytes each
+    if (ImGui::Checkbox("Record Session", &recordingSession)) {
+        SimCommand command;
+        command.type = recordingSession ? SimCommandType::StartSessionLog : SimCommandType::StopSessionLog;
+        command.path = sessionLogPath;
+        postCommand(command);
+    }
+    ImGui::SameLine();
+    ImGui::PushItemWidth(160);
+    ImGui::InputText("##SessionLog", sessionLogPath, sizeof(sessionLogPath), recordingSession ? ImGuiInputTextFlags_ReadOnly : 0);
+    ImGui::PopItemWidth();
+
     if (ImGui::Button("Help")) {
             showHelpWindow = true;
     }
+    ImGui::SameLine();
+    if (ImGui::Button("Pattern Library")) {
+        showLibraryWindow = true;
+    }
+    if (showLibraryWindow) {
+        renderLibraryWindow(renderer);
+    }
 
     if (showHelpWindow) {
         ImGui::SetNextWindowSize(ImVec2(HELP_WINDOW_WIDTH, HELP_WINDOW_HEIGHT)); 
@@ -277,20 +1036,196 @@ void renderImGuiWidgets(SDL_Renderer* renderer) {
         ImGui::TextWrapped("Death:");
         ImGui::TextWrapped("   Overpopulation: A live cell with more than three live neighbors dies.");
         ImGui::TextWrapped("   Loneliness: A live cell with fewer than two live neighbors also dies.");
+        ImGui::Spacing();
+        ImGui::TextWrapped("Controls: left drag draws cells, right drag erases them, middle drag pans the view "
+                    "and the mouse wheel zooms. Zoomed out, each pixel shows how crowded its block of cells is.");
+        ImGui::Spacing();
+        ImGui::TextWrapped("With the Select tool, left drag selects a rectangle: Ctrl+C copies it, Ctrl+X cuts it, Delete "
+                    "clears it and Escape drops it. Ctrl+V pastes the clipboard at the mouse, and the Stamp Clipboard tool "
+                    "draws with it as a brush.");
         ImGui::End();
     }
 
-    // Slider for controlling update interval
-    ImGui::SliderInt("Update Interval (ms)", &updateInterval, 1000, 1);
+    // Slider for controlling the simulation rate, fractional and above 1000 gen/s alike
+    if (ImGui::SliderFloat("Target Rate (gen/s)", &targetRate, 0.1f, 100000.0f, "%.2f", ImGuiSliderFlags_Logarithmic)) {
+        SimCommand command;
+        command.type = SimCommandType::SetTargetRate;
+        command.rate = targetRate;
+        postCommand(command);
+    }
+
+    // Max speed mode ignores the target rate and renders only the last generation of each frame
+    if (ImGui::Checkbox("Max Speed", &maxSpeed)) {
+        postSimpleCommand(SimCommandType::SetMaxSpeed, maxSpeed);
+    }
+    if (maxSpeed && ImGui::SliderFloat("Frame Budget (ms)", &frameBudget, 1.0f, 16.0f, "%.1f")) {
+        postSimpleCommand(SimCommandType::SetFrameBudget, static_cast<int>(frameBudget * 1000.0f));
+    }
+
+    // Step engine: auto follows the board from dense sweeps to the active engine as it settles,
+    // and to the sparse engine once it is nearly empty
+    if (ImGui::Combo("Engine", &engineSetting, STEP_ENGINE_NAMES, ENGINE_COUNT + 1)) {
+        postSimpleCommand(SimCommandType::SetEngine, engineSetting);
+    }
+    const EngineCosts& costs = getSnapshot().engineCosts;
+    ImGui::Text("Running: %s, %d thread%s available", STEP_ENGINE_NAMES[getSnapshot().engine], costs.threads, costs.threads == 1 ? "" : "s");
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("%s\nns per word: dense %.2f, threaded %.2f, active %.2f\nns per live cell: sparse %.2f", calibrationMessage.c_str(),
+                          costs.denseWord, costs.threadedWord, costs.activeWord, costs.sparseCell);
+    }
 
     // Slider for cursor size
     ImGui::SliderInt("Cursor Size", &cursorSize, 1, 10);
 
+    // Selection tools; the edits run a word at a time, so huge selections are as quick as small ones
+    ImGui::RadioButton("Draw", &editTool, TOOL_DRAW);
+    ImGui::SameLine();
+    ImGui::RadioButton("Select", &editTool, TOOL_SELECT);
+    ImGui::SameLine();
+    ImGui::RadioButton("Stamp Clipboard", &editTool, TOOL_STAMP);
+    ImGui::SameLine();
+    ImGui::Checkbox("Merge", &stampMerge);
+    int selectionX, selectionY, selectionWidth, selectionHeight;
+    if (getSelection(selectionX, selectionY, selectionWidth, selectionHeight)) {
+        ImGui::Text("Selection: %dx%d at %d,%d", selectionWidth, selectionHeight, selectionX, selectionY);
+        if (ImGui::Button("Copy")) {
+            copySelection(false);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cut")) {
+            copySelection(true);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Paste Here") && clipboard) {
+            pasteClipboard(selectionX, selectionY);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Deselect")) {
+            hasSelection = false;
+        }
+        const RegionEdit edits[] = { EDIT_CLEAR, EDIT_FILL, EDIT_INVERT, EDIT_RANDOM };
+        const char* editNames[] = { "Clear", "Fill", "Invert", "Random" };
+        for (int i = 0; i < 4; ++i) {
+            if (i > 0) {
+                ImGui::SameLine();
+            }
+            if (ImGui::Button(editNames[i])) {
+                editSelection(edits[i]);
+            }
+        }
+    }
+    // Rotations and flips apply to the selection if there is one, else to the clipboard
+    const RegionEdit turns[] = { EDIT_ROTATE_CLOCKWISE, EDIT_ROTATE_COUNTERCLOCKWISE, EDIT_FLIP_HORIZONTAL, EDIT_FLIP_VERTICAL };
+    const char* turnNames[] = { "Rotate CW", "Rotate CCW", "Flip H", "Flip V" };
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) {
+            ImGui::SameLine();
+        }
+        if (ImGui::Button(turnNames[i])) {
+            if (hasSelection) {
+                editSelection(turns[i]);
+            } else {
+                transformClipboard(turns[i]);
+            }
+        }
+    }
+    if (clipboard) {
+        ImGui::Text("Clipboard: %dx%d", clipboard->width, clipboard->height);
+    }
+
+    // Idle cost
+    ImGui::Checkbox("Redraw On Demand", &redrawOnDemand);
+    ImGui::Text("CPU: %.1f%% of a core, %.1f frames/s", cpuUsage, framesPerSecond);
+
+    // Camera
+    ImGui::Text("Zoom: %.3f px/cell", cameraZoom);
+    if (ImGui::Button("Reset View")) {
+        resetCamera();
+    }
+
     // Display current simulation status
     ImGui::Text("Simulation Status: %s", isPaused ? "Paused" : "Running");
+    ImGui::Text("Generation: %llu", static_cast<unsigned long long>(getSnapshot().generation));
+    ImGui::Text("Population: %llu", static_cast<unsigned long long>(getSnapshot().population));
+    ImGui::Text("Board: %dx%d, rule %s", getSnapshot().width, getSnapshot().height, getSnapshot().rule.c_str());
+    ImGui::Text("Memory: %s", describePlacement(getSnapshot().placement).c_str());
+
+    // Saves and loads run in the background; show what is in flight and how the last one went
+    IoStatus ioStatus = getIoStatus();
+    if (ioStatus.busy) {
+        ImGui::Text("%s... %.1f s%s", ioStatus.activity.c_str(), ioStatus.seconds,
+                    ioStatus.queued > 0 ? (", " + std::to_string(ioStatus.queued) + " queued").c_str() : "");
+    }
+    if (!ioStatus.lastResult.empty()) {
+        ImGui::TextColored(ioStatus.lastFailed ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f), "%s", ioStatus.lastResult.c_str());
+    }
+    if (maxSpeed) {
+        ImGui::Text("Speed: %.2f gen/s measured, max speed requested", getSnapshot().generationsPerSecond);
+    } else {
+        ImGui::Text("Speed: %.2f gen/s measured, %.2f requested", getSnapshot().generationsPerSecond, targetRate);
+    }
+    ImGui::Text("Generations per frame: %d, dropped: %llu", getSnapshot().generationsPerFrame,
+                static_cast<unsigned long long>(getSnapshot().droppedGenerations));
+
+    // Hardware counters around the step kernel and the board's rendering, per generation and frame
+    if (ImGui::Checkbox("Hardware Counters", &measureCounters)) {
+        postSimpleCommand(SimCommandType::SetCounters, measureCounters);
+        renderCounters.takeReading();
+        shownRenderCounters = PerfReading();
+        renderCounterTime = SDL_GetTicks();
+    }
+    if (measureCounters) {
+        if (!getSnapshot().counterError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.3f, 1.0f), "Hardware counters unavailable: %s", getSnapshot().counterError.c_str());
+        }
+        ImGui::TextWrapped("Step: %s", describeCounters(getSnapshot().stepCounters, "gen").c_str());
+        ImGui::TextWrapped("Render: %s", describeCounters(shownRenderCounters, "frame").c_str());
+    }
+
+    // Colour by state or by one of the per-cell channels, which the engine only keeps while needed
+    if (ImGui::Combo("Color By", &colorMode, COLOR_MODE_NAMES, IM_ARRAYSIZE(COLOR_MODE_NAMES))) {
+        postSimpleCommand(SimCommandType::SetAuxChannels, colorMode != COLOR_STATE);
+    }
 
     ImGui::ColorEdit3("Alive Cell Color", (float*)&aliveColor);
     ImGui::ColorEdit3("Dead Cell Color", (float*)&deadColor);
+
+    // Recording: frames are copied by the simulation thread and encoded in the background
+    RecordingStatus recordingStatus = getRecordingStatus();
+    ImGui::InputText("Record Path", recordPath, sizeof(recordPath));
+    ImGui::Combo("Record Format", &recordFormat, RECORD_FORMAT_NAMES, IM_ARRAYSIZE(RECORD_FORMAT_NAMES));
+    ImGui::SliderInt("Record Every", &recordEvery, 1, 100);
+    ImGui::SliderInt("Record Scale", &recordScale, 1, 16);
+    if (ImGui::Button(recordingStatus.recording ? "Stop Recording" : "Start Recording")) {
+        if (recordingStatus.recording) {
+            stopRecording();
+        } else {
+            RecordingSettings settings;
+            settings.path = recordPath;
+            settings.format = static_cast<RecordingFormat>(recordFormat);
+            settings.every = recordEvery;
+            settings.cellPixels = recordScale;
+            recordError.clear();
+            startRecording(settings, getSnapshot().width, getSnapshot().height, recordError);
+        }
+    }
+    ImGui::Text("Frames queued: %llu, written: %llu", static_cast<unsigned long long>(recordingStatus.framesQueued),
+                static_cast<unsigned long long>(recordingStatus.framesWritten));
+    if (!recordError.empty() || !recordingStatus.error.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", recordError.empty() ? recordingStatus.error.c_str() : recordError.c_str());
+    }
+
+    // Export the current generation as a PBM or PNG image, chosen by the file extension. It
+    // is written from a board copy on the I/O thread, like saves, and reported in the status.
+    ImGui::InputText("Export Path", exportPath, sizeof(exportPath));
+    ImGui::SliderInt("Export Scale", &exportScale, 1, 16);
+    if (ImGui::Button("Export Image")) {
+        SimCommand command;
+        command.type = SimCommandType::ExportImage;
+        command.path = exportPath;
+        command.value = exportScale;
+        postCommand(command);
+    }
     // These colors can be used in the renderGrid function to draw cells
 
     // Additional custom widgets can be added here
@@ -300,6 +1235,16 @@ void renderImGuiWidgets(SDL_Renderer* renderer) {
 
 
 void cleanUp(SDL_Renderer* renderer_ptr, SDL_Window* window_ptr) {
+    // Destroy the viewport texture
+    if (viewportTexture != nullptr) {
+        SDL_DestroyTexture(viewportTexture);
+        viewportTexture = nullptr;
+    }
+    for (auto& thumbnail : thumbnailTextures) {
+        SDL_DestroyTexture(thumbnail.second);
+    }
+    thumbnailTextures.clear();
+
     // Destroy the renderer
     if (renderer_ptr != nullptr) {
         SDL_DestroyRenderer(renderer_ptr);
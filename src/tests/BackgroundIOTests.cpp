@@ -0,0 +1,55 @@
+#include "Tests.h"
+#include "BackgroundIO.h"
+#include "GameOfLife.h"
+#include <chrono>
+#include <thread>
+
+// Wait for the I/O thread to finish a load, for up to ten seconds
+bool waitForLoadedBoard(LoadedBoard& loaded) {
+    for (int i = 0; i < 1000; ++i) {
+        if (takeLoadedBoard(loaded)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// A pattern loaded to be placed keeps that request also at a negative offset, and is clipped
+// into the board rather than replacing it
+TEST(loadPlacesPatternAtNegativeOffset) {
+    std::string path = makeTestDirectory("load-place") + "/placed.rle";
+    Pattern pattern = randomPattern(20, 12, 50, 1);
+    std::string error;
+    REQUIRE(writePattern(path, pattern.words.data(), pattern.wordsPerRow, pattern.width, pattern.height, "B3/S23", error));
+
+    startIoThread(nullptr);
+    queueLoad(IoJobType::LoadPattern, path, true, -5, 3);
+    LoadedBoard loaded;
+    bool taken = waitForLoadedBoard(loaded);
+    stopIoThread();
+    REQUIRE(taken);
+    CHECK(loaded.placeAt);
+    CHECK(loaded.x == -5 && loaded.y == 3);
+
+    Pattern board = randomPattern(100, 80, 30, 2);
+    setGrid(board.width, board.height, board.words);
+    Pattern expected = board;
+    for (int y = 0; y < pattern.height; ++y) {
+        for (int x = 0; x < pattern.width; ++x) {
+            if (getPatternCell(pattern, x, y)) {
+                setPatternCell(expected, x - 5, y + 3, true);
+            }
+        }
+    }
+    REQUIRE(placePatternAt(loaded.board, loaded.x, loaded.y, error));
+    CHECK(samePatternCells(copyBoard(), expected));
+
+    // Without the request the pattern is centred on a board of its own
+    startIoThread(nullptr);
+    queueLoad(IoJobType::LoadPattern, path);
+    taken = waitForLoadedBoard(loaded);
+    stopIoThread();
+    REQUIRE(taken);
+    CHECK(!loaded.placeAt);
+}
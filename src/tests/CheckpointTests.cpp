@@ -0,0 +1,78 @@
+#include "Tests.h"
+#include "Checkpoint.h"
+#include "Universe.h"
+#include <filesystem>
+#include <set>
+
+const uint64_t CHECKPOINT_EVERY = 10;
+const uint64_t LAST_CHECKPOINT = 60;
+const uint64_t RUN_END = 100;
+
+std::set<std::string> listDirectory(const std::string& directory) {
+    std::set<std::string> names;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        names.insert(entry.path().string());
+    }
+    return names;
+}
+
+// Step a copy of the checkpointed board to the end of the run
+bool resumeRun(const std::string& directory, uint64_t expectedGeneration, Pattern& finished) {
+    Pattern board;
+    uint64_t generation = 0;
+    std::string error;
+    if (!readLatestCheckpoint(directory, board, generation, error)) {
+        reportFailure(__FILE__, __LINE__, error);
+        return false;
+    }
+    CHECK(generation == expectedGeneration);
+    Universe resumed(board.width, board.height);
+    if (!resumed.replaceBoard(board, error)) {
+        reportFailure(__FILE__, __LINE__, error);
+        return false;
+    }
+    resumed.step(RUN_END - generation);
+    finished = resumed.copyBoard();
+    return true;
+}
+
+// A run resumed from its checkpoints ends on the board of the run left alone, also when the
+// newest checkpoint was torn and an older one has to do
+TEST(checkpointResumeMatchesUninterruptedRun) {
+    std::string directory = makeTestDirectory("checkpoints");
+    CheckpointSettings settings;
+    settings.directory = directory;
+
+    Pattern start = randomPattern(200, 150, 35, 1);
+    Universe run(start.width, start.height);
+    run.setRule("B36/S23");
+    run.setBoard(start.width, start.height, start.words);
+    std::set<std::string> beforeLast;
+    for (uint64_t generation = 1; generation <= RUN_END; ++generation) {
+        run.step();
+        if (generation % CHECKPOINT_EVERY == 0 && generation <= LAST_CHECKPOINT) {
+            if (generation == LAST_CHECKPOINT) {
+                beforeLast = listDirectory(directory);
+            }
+            REQUIRE(tryBeginCheckpoint());
+            Pattern board = run.copyBoard();
+            std::string result, error;
+            REQUIRE(writeCheckpoint(settings, board, generation, result, error));
+        }
+    }
+    Pattern uninterrupted = run.copyBoard();
+
+    Pattern finished;
+    REQUIRE(resumeRun(directory, LAST_CHECKPOINT, finished));
+    CHECK(samePatternCells(finished, uninterrupted));
+    CHECK(finished.rule == "B36/S23");
+
+    // Tear the files the last checkpoint wrote
+    for (const std::string& path : listDirectory(directory)) {
+        if (beforeLast.count(path) == 0) {
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+        }
+    }
+    REQUIRE(resumeRun(directory, LAST_CHECKPOINT - CHECKPOINT_EVERY, finished));
+    CHECK(samePatternCells(finished, uninterrupted));
+}
@@ -0,0 +1,138 @@
+#include "Tests.h"
+#include "Universe.h"
+#include <algorithm>
+#include <memory>
+
+const StepEngine TESTED_ENGINES[] = { ENGINE_DENSE, ENGINE_THREADED, ENGINE_ACTIVE, ENGINE_SPARSE };
+
+// One generation of a bounded board, cell by cell; cells past the edges are dead
+Pattern stepNaive(const Pattern& board, uint16_t birthMask, uint16_t survivalMask) {
+    Pattern next = makePattern(board.width, board.height);
+    for (int y = 0; y < board.height; ++y) {
+        for (int x = 0; x < board.width; ++x) {
+            int neighbours = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    neighbours += (dx != 0 || dy != 0) && getPatternCell(board, x + dx, y + dy) ? 1 : 0;
+                }
+            }
+            uint16_t mask = getPatternCell(board, x, y) ? survivalMask : birthMask;
+            setPatternCell(next, x, y, (mask >> neighbours) & 1);
+        }
+    }
+    return next;
+}
+
+uint64_t countCells(const Pattern& pattern) {
+    uint64_t count = 0;
+    for (int y = 0; y < pattern.height; ++y) {
+        for (int x = 0; x < pattern.width; ++x) {
+            count += getPatternCell(pattern, x, y) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+// A dense patch in an otherwise empty board, so the sparse engine steps crowded cells too
+Pattern clusteredPattern(int width, int height, uint64_t seed) {
+    Pattern board = makePattern(width, height);
+    Pattern patch = randomPattern(std::min(width, 24), std::min(height, 24), 40, seed);
+    for (int y = 0; y < patch.height; ++y) {
+        for (int x = 0; x < patch.width; ++x) {
+            setPatternCell(board, (width - patch.width) / 2 + x, (height - patch.height) / 2 + y, getPatternCell(patch, x, y));
+        }
+    }
+    return board;
+}
+
+// A universe stepped only by engine, with threads for the threaded engine however many
+// cores this machine has
+std::unique_ptr<Universe> makeUniverse(const Pattern& board, const std::string& rule, StepEngine engine) {
+    std::unique_ptr<Universe> universe(new Universe(board.width, board.height));
+    EngineCosts costs;
+    costs.threads = 4;
+    universe->setEngineCosts(costs);
+    universe->setRule(rule);
+    universe->setStepEngine(engine);
+    universe->setBoard(board.width, board.height, board.words);
+    return universe;
+}
+
+TEST(enginesMatchNaiveStepping) {
+    const int sizes[][2] = { { 64, 64 }, { 100, 37 }, { 130, 130 }, { 257, 65 } };
+    const char* rules[] = { "B3/S23", "B36/S23", "B2/S" };
+    for (const auto& size : sizes) {
+        for (const char* rule : rules) {
+            for (int percentAlive : { 0, 1, 40 }) {
+                uint16_t birthMask = 0, survivalMask = 0;
+                REQUIRE(parseRule(rule, birthMask, survivalMask));
+                uint64_t seed = static_cast<uint64_t>(size[0] * 31 + percentAlive);
+                // No percentage stands for the clustered board
+                Pattern reference = percentAlive == 0 ? clusteredPattern(size[0], size[1], seed)
+                                                      : randomPattern(size[0], size[1], percentAlive, seed);
+                std::vector<std::unique_ptr<Universe>> universes;
+                for (StepEngine engine : TESTED_ENGINES) {
+                    universes.push_back(makeUniverse(reference, rule, engine));
+                }
+                for (int generation = 1; generation <= 24; ++generation) {
+                    reference = stepNaive(reference, birthMask, survivalMask);
+                    for (auto& universe : universes) {
+                        universe->step();
+                        CHECK(samePatternCells(universe->copyBoard(), reference));
+                        CHECK(universe->getPyramid().getPopulation() == countCells(reference));
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Each engine must really step the boards it is meant for, or the comparison above proves
+// nothing about it
+TEST(enginesStepTheirBoards) {
+    Pattern sparse = randomPattern(256, 256, 1, 7);
+    for (StepEngine engine : TESTED_ENGINES) {
+        std::unique_ptr<Universe> universe = makeUniverse(sparse, "B3/S23", engine);
+        universe->step(16);
+        CHECK(universe->getStats().engineGenerations[engine] > 0);
+    }
+}
+
+// Edits end the step history the active engine steps around, and writeRows keeps it
+TEST(enginesAgreeAcrossEdits) {
+    Pattern board = randomPattern(200, 150, 30, 11);
+    Pattern stamp = randomPattern(40, 25, 50, 12);
+    std::vector<uint64_t> rows(static_cast<size_t>(board.wordsPerRow) * 3, 0x0123456789ABCDEFULL);
+    std::vector<std::unique_ptr<Universe>> universes;
+    for (StepEngine engine : TESTED_ENGINES) {
+        universes.push_back(makeUniverse(board, "B3/S23", engine));
+    }
+    for (auto& universe : universes) {
+        universe->step(5);
+        universe->editRegion(-10, 20, 90, 60, EDIT_INVERT);
+        universe->step(3);
+        universe->pastePattern(stamp, 170, 130, true);
+        universe->setCell(0, 0, true);
+        universe->step(4);
+        universe->writeRows(70, 3, rows.data());
+        universe->step(6);
+        universe->editRegion(30, 30, 50, 20, EDIT_ROTATE_CLOCKWISE);
+        universe->step(6);
+    }
+    Pattern dense = universes[0]->copyBoard();
+    for (size_t i = 1; i < universes.size(); ++i) {
+        CHECK(samePatternCells(universes[i]->copyBoard(), dense));
+        CHECK(universes[i]->getPyramid().getPopulation() == countCells(dense));
+    }
+}
+
+TEST(autoEngineMatchesDense) {
+    Pattern board = randomPattern(300, 200, 3, 21);
+    std::unique_ptr<Universe> dense = makeUniverse(board, "B3/S23", ENGINE_DENSE);
+    std::unique_ptr<Universe> automatic = makeUniverse(board, "B3/S23", ENGINE_AUTO);
+    for (int i = 0; i < 10; ++i) {
+        dense->step(7);
+        automatic->step(7);
+        CHECK(samePatternCells(dense->copyBoard(), automatic->copyBoard()));
+    }
+}
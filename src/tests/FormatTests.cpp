@@ -0,0 +1,174 @@
+#include "Tests.h"
+#include "BinarySnapshot.h"
+#include "ImageExport.h"
+#include <algorithm>
+#include <fstream>
+
+// The bounding box of the live cells, for formats that keep only that
+Pattern cropToLiveCells(const Pattern& pattern) {
+    int x0 = pattern.width, y0 = pattern.height, x1 = 0, y1 = 0;
+    for (int y = 0; y < pattern.height; ++y) {
+        for (int x = 0; x < pattern.width; ++x) {
+            if (getPatternCell(pattern, x, y)) {
+                x0 = std::min(x0, x);
+                y0 = std::min(y0, y);
+                x1 = std::max(x1, x + 1);
+                y1 = std::max(y1, y + 1);
+            }
+        }
+    }
+    Pattern cropped = makePattern(std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            setPatternCell(cropped, x - x0, y - y0, getPatternCell(pattern, x, y));
+        }
+    }
+    return cropped;
+}
+
+// Boards with awkward widths, empty margins and long runs
+std::vector<Pattern> makeFormatBoards() {
+    std::vector<Pattern> boards;
+    boards.push_back(randomPattern(150, 90, 20, 1));
+    boards.push_back(randomPattern(64, 64, 50, 2));
+    boards.push_back(randomPattern(1000, 3, 2, 3));
+    Pattern margins = makePattern(200, 120);
+    Pattern middle = randomPattern(30, 20, 60, 4);
+    for (int y = 0; y < middle.height; ++y) {
+        for (int x = 0; x < middle.width; ++x) {
+            setPatternCell(margins, 70 + x, 50 + y, getPatternCell(middle, x, y));
+        }
+    }
+    boards.push_back(margins);
+    // Repeats, which Macrocell shares
+    Pattern tiled = makePattern(256, 256);
+    for (int y = 0; y < tiled.height; ++y) {
+        for (int x = 0; x < tiled.width; ++x) {
+            setPatternCell(tiled, x, y, getPatternCell(middle, x % 16, y % 16));
+        }
+    }
+    boards.push_back(tiled);
+    return boards;
+}
+
+bool writeAndRead(const std::string& path, const Pattern& board, Pattern& read) {
+    std::string error;
+    bool ok = writePattern(path, board.words.data(), board.wordsPerRow, board.width, board.height, "B36/S23", error) &&
+              readPattern(path, read, error);
+    if (!ok) {
+        reportFailure(__FILE__, __LINE__, path + ": " + error);
+    }
+    return ok;
+}
+
+// RLE keeps the board's size and rule
+TEST(rleRoundTrip) {
+    std::string directory = makeTestDirectory("rle");
+    for (const Pattern& board : makeFormatBoards()) {
+        Pattern read;
+        REQUIRE(writeAndRead(directory + "/board.rle", board, read));
+        CHECK(samePatternCells(read, board));
+        CHECK(read.rule == "B36/S23");
+    }
+}
+
+TEST(rleReadsKnownPattern) {
+    std::string path = makeTestDirectory("rle-known") + "/glider.rle";
+    std::ofstream(path) << "#N Glider\nx = 3, y = 3, rule = B3/S23\nbo$2bo$3o!\n";
+    Pattern read;
+    std::string error;
+    REQUIRE(readPattern(path, read, error));
+    Pattern glider = makePattern(3, 3);
+    const int cells[][2] = { { 1, 0 }, { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+    for (const auto& cell : cells) {
+        setPatternCell(glider, cell[0], cell[1], true);
+    }
+    CHECK(samePatternCells(read, glider));
+}
+
+// Macrocell, plaintext and Life 1.06 keep the live cells' bounding box
+TEST(macrocellRoundTrip) {
+    std::string directory = makeTestDirectory("mc");
+    for (const Pattern& board : makeFormatBoards()) {
+        Pattern read;
+        REQUIRE(writeAndRead(directory + "/board.mc", board, read));
+        CHECK(samePatternCells(cropToLiveCells(read), cropToLiveCells(board)));
+        CHECK(read.rule == "B36/S23");
+        CHECK(!read.cropped);
+    }
+}
+
+TEST(cellsRoundTrip) {
+    std::string directory = makeTestDirectory("cells");
+    for (const Pattern& board : makeFormatBoards()) {
+        Pattern read;
+        REQUIRE(writeAndRead(directory + "/board.cells", board, read));
+        CHECK(samePatternCells(cropToLiveCells(read), cropToLiveCells(board)));
+    }
+}
+
+TEST(life106RoundTrip) {
+    std::string directory = makeTestDirectory("lif");
+    for (const Pattern& board : makeFormatBoards()) {
+        Pattern read;
+        REQUIRE(writeAndRead(directory + "/board.lif", board, read));
+        CHECK(samePatternCells(cropToLiveCells(read), cropToLiveCells(board)));
+    }
+}
+
+// PBM is written by the image exporter and read back by the pattern reader
+TEST(pbmRoundTrip) {
+    std::string directory = makeTestDirectory("pbm");
+    for (const Pattern& board : makeFormatBoards()) {
+        Pattern read;
+        REQUIRE(writeAndRead(directory + "/board.pbm", board, read));
+        CHECK(samePatternCells(read, board));
+
+        // Scaled up, each cell is a square of pixels
+        std::string error;
+        REQUIRE(exportImage(directory + "/scaled.pbm", IMAGE_PBM, board.words.data(), board.wordsPerRow, board.width,
+                            board.height, 3, error));
+        REQUIRE(readPattern(directory + "/scaled.pbm", read, error));
+        Pattern scaled = makePattern(board.width * 3, board.height * 3);
+        for (int y = 0; y < scaled.height; ++y) {
+            for (int x = 0; x < scaled.width; ++x) {
+                setPatternCell(scaled, x, y, getPatternCell(board, x / 3, y / 3));
+            }
+        }
+        CHECK(samePatternCells(read, scaled));
+    }
+}
+
+TEST(binarySnapshotRoundTrip) {
+    std::string directory = makeTestDirectory("golsnap");
+    for (const Pattern& board : makeFormatBoards()) {
+        std::string path = directory + "/board.golsnap";
+        std::string error;
+        REQUIRE(writeBinarySnapshot(path, board.words.data(), board.wordsPerRow, board.width, board.height, "B36/S23", 12345, error));
+        Pattern read;
+        uint64_t generation = 0;
+        REQUIRE(readBinarySnapshot(path, read, generation, error));
+        CHECK(read.words == board.words);
+        CHECK(read.width == board.width && read.height == board.height);
+        CHECK(read.rule == "B36/S23");
+        CHECK(generation == 12345);
+    }
+}
+
+TEST(binarySnapshotRejectsCorruption) {
+    std::string path = makeTestDirectory("golsnap-corrupt") + "/board.golsnap";
+    Pattern board = randomPattern(100, 100, 30, 5);
+    std::string error;
+    REQUIRE(writeBinarySnapshot(path, board.words.data(), board.wordsPerRow, board.width, board.height, "B3/S23", 1, error));
+    {
+        // Flip a byte of the words
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(200);
+        char byte = static_cast<char>(file.get());
+        file.seekp(200);
+        file.put(static_cast<char>(~byte));
+    }
+    Pattern read;
+    uint64_t generation = 0;
+    CHECK(!readBinarySnapshot(path, read, generation, error));
+}
@@ -0,0 +1,61 @@
+#include "Tests.h"
+#include "PatternLibrary.h"
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+// Poll the library thread for up to ten seconds
+template <typename Done>
+bool waitForLibrary(Done done) {
+    for (int i = 0; i < 1000; ++i) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// A file replaced by a smaller pattern after it was indexed still gets a thumbnail of what it
+// holds now, and that is not cached under the old pattern's hash
+TEST(thumbnailOfFileChangedSinceIndexing) {
+    std::string directory = makeTestDirectory("library");
+    std::string path = directory + "/changing.rle";
+    std::string error;
+    Pattern large = makePattern(300, 300);
+    for (int i = 250; i < 300; ++i) {
+        setPatternCell(large, i, i, true);
+    }
+    REQUIRE(writePattern(path, large.words.data(), large.wordsPerRow, large.width, large.height, "B3/S23", error));
+
+    startLibrary(nullptr);
+    scanLibrary(directory);
+    std::vector<LibraryEntry> entries;
+    uint64_t version = 0;
+    bool scanned = waitForLibrary([&]() { return getLibraryEntries(entries, version) && !getLibraryStatus().scanning; });
+    if (!scanned || entries.size() != 1) {
+        stopLibrary();
+        reportFailure(__FILE__, __LINE__, "the scan did not index the one pattern");
+        return;
+    }
+    CHECK(entries[0].boxX == 250 && entries[0].boxWidth == 50);
+
+    Pattern small = randomPattern(3, 3, 60, 1);
+    setPatternCell(small, 1, 1, true);
+    CHECK(writePattern(path, small.words.data(), small.wordsPerRow, small.width, small.height, "B3/S23", error));
+    requestThumbnail(entries[0]);
+    std::vector<Thumbnail> thumbnails;
+    bool rendered = waitForLibrary([&]() {
+        takeThumbnails(thumbnails);
+        return !thumbnails.empty();
+    });
+    stopLibrary();
+    REQUIRE(rendered);
+    REQUIRE(thumbnails[0].pixels.size() == static_cast<size_t>(THUMBNAIL_SIZE * THUMBNAIL_SIZE));
+    int lit = 0;
+    for (uint8_t pixel : thumbnails[0].pixels) {
+        lit += pixel != 0 ? 1 : 0;
+    }
+    CHECK(lit > 0);
+    CHECK(!std::filesystem::exists(directory + "/.thumbnails"));
+}
@@ -0,0 +1,148 @@
+#include "Tests.h"
+#include "RegionEdit.h"
+#include "Universe.h"
+#include <random>
+
+// Rectangles that start before the board, end past it, straddle word boundaries or miss it
+const int RECTANGLES[][4] = { { 0, 0, 1, 1 },     { 5, 3, 60, 10 },  { 60, 0, 10, 40 },  { -7, -5, 30, 20 },
+                              { 120, 80, 50, 50 }, { 63, 1, 66, 65 }, { -20, 10, 250, 3 }, { 200, 200, 5, 5 },
+                              { 10, 10, 0, 5 } };
+
+Pattern extractNaive(const Pattern& board, int x, int y, int w, int h) {
+    Pattern region = makePattern(w, h);
+    for (int dy = 0; dy < h; ++dy) {
+        for (int dx = 0; dx < w; ++dx) {
+            setPatternCell(region, dx, dy, getPatternCell(board, x + dx, y + dy));
+        }
+    }
+    return region;
+}
+
+TEST(extractRegionMatchesNaive) {
+    Pattern board = randomPattern(150, 100, 45, 1);
+    for (const auto& rect : RECTANGLES) {
+        Pattern region = extractRegion(board.words.data(), board.wordsPerRow, board.width, board.height, rect[0], rect[1], rect[2], rect[3]);
+        CHECK(samePatternCells(region, extractNaive(board, rect[0], rect[1], rect[2], rect[3])));
+    }
+}
+
+TEST(stampPatternMatchesNaive) {
+    for (bool merge : { false, true }) {
+        for (const auto& rect : RECTANGLES) {
+            Pattern board = randomPattern(150, 100, 45, 2);
+            Pattern stamp = randomPattern(rect[2], rect[3], 50, 3);
+            Pattern expected = board;
+            for (int y = 0; y < stamp.height; ++y) {
+                for (int x = 0; x < stamp.width; ++x) {
+                    bool live = getPatternCell(stamp, x, y);
+                    if (live || !merge) {
+                        setPatternCell(expected, rect[0] + x, rect[1] + y, live);
+                    }
+                }
+            }
+            stampPattern(stamp, board.words.data(), board.wordsPerRow, board.width, board.height, rect[0], rect[1], merge);
+            CHECK(samePatternCells(board, expected));
+        }
+    }
+}
+
+TEST(fillRegionMatchesNaive) {
+    for (RegionEdit edit : { EDIT_CLEAR, EDIT_FILL, EDIT_INVERT }) {
+        for (const auto& rect : RECTANGLES) {
+            Pattern board = randomPattern(150, 100, 45, 4);
+            Pattern expected = board;
+            for (int y = rect[1]; y < rect[1] + rect[3]; ++y) {
+                for (int x = rect[0]; x < rect[0] + rect[2]; ++x) {
+                    setPatternCell(expected, x, y, edit == EDIT_FILL || (edit == EDIT_INVERT && !getPatternCell(board, x, y)));
+                }
+            }
+            fillRegion(board.words.data(), board.wordsPerRow, board.width, board.height, rect[0], rect[1], rect[2], rect[3], edit, 0);
+            CHECK(samePatternCells(board, expected));
+        }
+    }
+}
+
+// Random fills change nothing outside the rectangle, come out the same for the same seed,
+// and are about half alive
+TEST(randomFillStaysInRegion) {
+    Pattern board = randomPattern(150, 100, 45, 5);
+    Pattern first = board;
+    Pattern second = board;
+    fillRegion(first.words.data(), first.wordsPerRow, first.width, first.height, 63, 1, 66, 65, EDIT_RANDOM, 99);
+    fillRegion(second.words.data(), second.wordsPerRow, second.width, second.height, 63, 1, 66, 65, EDIT_RANDOM, 99);
+    CHECK(first.words == second.words);
+    int alive = 0;
+    for (int y = 0; y < board.height; ++y) {
+        for (int x = 0; x < board.width; ++x) {
+            bool inside = x >= 63 && x < 129 && y >= 1 && y < 66;
+            if (inside) {
+                alive += getPatternCell(first, x, y) ? 1 : 0;
+            } else {
+                CHECK(getPatternCell(first, x, y) == getPatternCell(board, x, y));
+            }
+        }
+    }
+    CHECK(alive > 66 * 65 * 4 / 10 && alive < 66 * 65 * 6 / 10);
+}
+
+TEST(rotateAndFlipMatchNaive) {
+    const int sizes[][2] = { { 1, 1 }, { 3, 70 }, { 64, 64 }, { 65, 130 }, { 200, 7 } };
+    for (const auto& size : sizes) {
+        Pattern pattern = randomPattern(size[0], size[1], 50, size[0] + size[1]);
+        Pattern transposed = makePattern(size[1], size[0]);
+        Pattern clockwise = makePattern(size[1], size[0]);
+        Pattern counterclockwise = makePattern(size[1], size[0]);
+        Pattern horizontal = makePattern(size[0], size[1]);
+        Pattern vertical = makePattern(size[0], size[1]);
+        for (int y = 0; y < size[1]; ++y) {
+            for (int x = 0; x < size[0]; ++x) {
+                bool live = getPatternCell(pattern, x, y);
+                setPatternCell(transposed, y, x, live);
+                setPatternCell(clockwise, size[1] - 1 - y, x, live);
+                setPatternCell(counterclockwise, y, size[0] - 1 - x, live);
+                setPatternCell(horizontal, size[0] - 1 - x, y, live);
+                setPatternCell(vertical, x, size[1] - 1 - y, live);
+            }
+        }
+        CHECK(samePatternCells(transposePattern(pattern), transposed));
+        CHECK(samePatternCells(rotatePattern(pattern, true), clockwise));
+        CHECK(samePatternCells(rotatePattern(pattern, false), counterclockwise));
+        Pattern flipped = pattern;
+        flipPattern(flipped, true);
+        CHECK(samePatternCells(flipped, horizontal));
+        flipped = pattern;
+        flipPattern(flipped, false);
+        CHECK(samePatternCells(flipped, vertical));
+    }
+}
+
+// Universe edits also keep the population pyramid and its region counts right
+TEST(universeEditsKeepCounts) {
+    Pattern board = randomPattern(150, 100, 45, 6);
+    Universe universe(board.width, board.height);
+    universe.setBoard(board.width, board.height, board.words);
+    std::mt19937 random(7);
+    for (int i = 0; i < 40; ++i) {
+        const auto& rect = RECTANGLES[random() % (sizeof(RECTANGLES) / sizeof(RECTANGLES[0]))];
+        RegionEdit edit = static_cast<RegionEdit>(random() % EDIT_COUNT);
+        universe.editRegion(rect[0], rect[1], rect[2], rect[3], edit, random());
+        Pattern current = universe.copyBoard();
+        uint64_t population = 0;
+        for (int y = 0; y < current.height; ++y) {
+            for (int x = 0; x < current.width; ++x) {
+                population += getPatternCell(current, x, y) ? 1 : 0;
+            }
+        }
+        CHECK(universe.getPyramid().getPopulation() == population);
+        int x0 = static_cast<int>(random() % 150), y0 = static_cast<int>(random() % 100);
+        int x1 = x0 + static_cast<int>(random() % (151 - x0)), y1 = y0 + static_cast<int>(random() % (101 - y0));
+        uint64_t inside = 0;
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                inside += getPatternCell(current, x, y) ? 1 : 0;
+            }
+        }
+        CHECK(universe.countLiveCells(x0, y0, x1, y1) == inside);
+        CHECK(universe.isRegionEmpty(x0, y0, x1, y1) == (inside == 0));
+    }
+}
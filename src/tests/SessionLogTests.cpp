@@ -0,0 +1,121 @@
+#include "Tests.h"
+#include "SessionLog.h"
+#include "GameOfLife.h"
+
+// Step the process-wide board to each event's generation and apply it, as --replay does
+bool replaySession(const std::vector<SessionEvent>& events, std::string& error) {
+    uint64_t generation = 0;
+    for (const SessionEvent& event : events) {
+        while (event.type != SessionEventType::Start && generation < event.generation) {
+            updateGrid();
+            ++generation;
+        }
+        if (!applySessionEvent(event, generation, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Record a session of steps and every kind of edit, the way the window logs them
+std::vector<SessionEvent> recordSession(const std::string& directory, Pattern& finalBoard) {
+    std::string error;
+    std::string logPath = directory + "/session" + SESSION_LOG_EXTENSION;
+    std::string placedPath = directory + "/placed.rle";
+    Pattern placed = randomPattern(20, 12, 50, 2);
+    CHECK(writePattern(placedPath, placed.words.data(), placed.wordsPerRow, placed.width, placed.height, "B3/S23", error));
+
+    setGrid(120, 90, std::vector<uint64_t>(static_cast<size_t>(2) * 90, 0));
+    setRule("B3/S23");
+    initializeGrid(12345);
+    uint64_t generation = 0;
+    CHECK(startSessionLog(logPath, generation, error));
+    auto stepTo = [&](uint64_t target) {
+        for (; generation < target; ++generation) {
+            updateGrid();
+        }
+    };
+
+    stepTo(10);
+    SessionEvent paint;
+    paint.type = SessionEventType::Paint;
+    paint.generation = generation;
+    paint.x = 30;
+    paint.y = 40;
+    paint.size = 5;
+    paint.state = true;
+    paintCells(paint.x, paint.y, paint.size, paint.state);
+    logSessionEvent(paint);
+
+    stepTo(25);
+    SessionEvent edit;
+    edit.type = SessionEventType::Edit;
+    edit.generation = generation;
+    edit.x = -5;
+    edit.y = 50;
+    edit.width = 70;
+    edit.height = 30;
+    edit.edit = EDIT_RANDOM;
+    edit.seed = 777;
+    editRegion(edit.x, edit.y, edit.width, edit.height, EDIT_RANDOM, edit.seed);
+    logSessionEvent(edit);
+
+    stepTo(31);
+    Pattern stamp = randomPattern(33, 17, 40, 3);
+    SessionEvent paste;
+    paste.type = SessionEventType::Paste;
+    paste.generation = generation;
+    paste.x = 100;
+    paste.y = -3;
+    paste.width = stamp.width;
+    paste.height = stamp.height;
+    paste.state = false;
+    paste.words = stamp.words;
+    pastePattern(stamp, paste.x, paste.y, paste.state);
+    logSessionEvent(paste);
+
+    stepTo(40);
+    SessionEvent place;
+    place.type = SessionEventType::Place;
+    place.generation = generation;
+    place.nextGeneration = generation;
+    place.x = -4;
+    place.y = 70;
+    place.path = placedPath;
+    CHECK(placePatternAt(placed, place.x, place.y, error));
+    logSessionEvent(place);
+
+    stepTo(60);
+    stopSessionLog(generation);
+    finalBoard = copyBoard();
+
+    std::vector<SessionEvent> events;
+    CHECK(readSessionLog(logPath, events, error));
+    return events;
+}
+
+TEST(sessionReplayRebuildsTheBoard) {
+    Pattern recorded;
+    std::vector<SessionEvent> events = recordSession(makeTestDirectory("session"), recorded);
+    REQUIRE(events.size() == 6); // Start, the four edits and End
+
+    initializeGrid(1); // Replaying must not depend on the board it starts from
+    std::string error;
+    CHECK(replaySession(events, error));
+    CHECK(samePatternCells(copyBoard(), recorded));
+}
+
+// The End record's checksum catches a replay that went wrong
+TEST(sessionReplayDetectsDivergence) {
+    Pattern recorded;
+    std::vector<SessionEvent> events = recordSession(makeTestDirectory("session-divergence"), recorded);
+    REQUIRE(events.size() == 6);
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i].type == SessionEventType::Paint) {
+            events[i].x += 1;
+        }
+    }
+    std::string error;
+    CHECK(!replaySession(events, error));
+    CHECK(!error.empty());
+}
@@ -0,0 +1,91 @@
+#include "Tests.h"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+int failures = 0;
+
+std::vector<TestCase>& getTests() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void reportFailure(const char* file, int line, const std::string& what) {
+    std::cerr << "  " << file << ":" << line << ": failed: " << what << std::endl;
+    ++failures;
+}
+
+std::string makeTestDirectory(const char* name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "gol-tests" / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory.string();
+}
+
+Pattern makePattern(int width, int height) {
+    Pattern pattern;
+    pattern.width = width;
+    pattern.height = height;
+    pattern.wordsPerRow = (width + 63) / 64;
+    pattern.words.assign(static_cast<size_t>(pattern.wordsPerRow) * height, 0);
+    return pattern;
+}
+
+Pattern randomPattern(int width, int height, int percentAlive, uint64_t seed) {
+    Pattern pattern = makePattern(width, height);
+    std::mt19937_64 random(seed);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            setPatternCell(pattern, x, y, static_cast<int>(random() % 100) < percentAlive);
+        }
+    }
+    return pattern;
+}
+
+bool getPatternCell(const Pattern& pattern, int x, int y) {
+    if (x < 0 || y < 0 || x >= pattern.width || y >= pattern.height) {
+        return false;
+    }
+    return (pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow + x / 64] >> (x % 64)) & 1;
+}
+
+void setPatternCell(Pattern& pattern, int x, int y, bool state) {
+    if (x < 0 || y < 0 || x >= pattern.width || y >= pattern.height) {
+        return;
+    }
+    uint64_t& word = pattern.words[static_cast<size_t>(y) * pattern.wordsPerRow + x / 64];
+    word = state ? word | (uint64_t(1) << (x % 64)) : word & ~(uint64_t(1) << (x % 64));
+}
+
+bool samePatternCells(const Pattern& a, const Pattern& b) {
+    if (a.width != b.width || a.height != b.height) {
+        return false;
+    }
+    for (int y = 0; y < a.height; ++y) {
+        for (int x = 0; x < a.width; ++x) {
+            if (getPatternCell(a, x, y) != getPatternCell(b, x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    for (const TestCase& test : getTests()) {
+        if (filter != nullptr && std::strstr(test.name, filter) == nullptr) {
+            continue;
+        }
+        std::cout << test.name << std::endl;
+        int before = failures;
+        test.run();
+        ++run;
+        failed += failures > before ? 1 : 0;
+    }
+    std::cout << run - failed << " of " << run << " tests passed" << std::endl;
+    return failed == 0 && run > 0 ? 0 : 1;
+}
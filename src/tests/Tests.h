@@ -0,0 +1,55 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "PatternIO.h"
+
+// A small test runner for libgol, with no dependencies of its own. TEST(name) defines a test
+// and registers it; CHECK records a failure with its file and line and carries on, REQUIRE
+// also leaves the test. gol-tests runs every test, or those whose names contain argv[1].
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+std::vector<TestCase>& getTests();
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { getTests().push_back({ name, run }); }
+};
+
+#define TEST(name)                                   \
+    void name();                                     \
+    const TestRegistrar name##Registrar(#name, name); \
+    void name()
+
+void reportFailure(const char* file, int line, const std::string& what);
+
+#define CHECK(condition)                                   \
+    do {                                                   \
+        if (!(condition)) {                                \
+            reportFailure(__FILE__, __LINE__, #condition); \
+        }                                                  \
+    } while (0)
+
+#define REQUIRE(condition)                                 \
+    do {                                                   \
+        if (!(condition)) {                                \
+            reportFailure(__FILE__, __LINE__, #condition); \
+            return;                                        \
+        }                                                  \
+    } while (0)
+
+// An empty directory for the running test's files, under the system's temporary directory
+std::string makeTestDirectory(const char* name);
+
+// Patterns built and read cell by cell, the slow way, as references for the word-at-a-time code
+Pattern makePattern(int width, int height);
+Pattern randomPattern(int width, int height, int percentAlive, uint64_t seed);
+bool getPatternCell(const Pattern& pattern, int x, int y); // Dead outside the pattern
+void setPatternCell(Pattern& pattern, int x, int y, bool state);
+bool samePatternCells(const Pattern& a, const Pattern& b); // Same size and cells; rules are not compared
+
+#endif // TESTS_H